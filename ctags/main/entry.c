@@ -72,7 +72,7 @@
 *   DATA DEFINITIONS
 */
 
-tagFile TagFile = {
+THREAD_LOCAL tagFile TagFile = {
     NULL,		/* tag file name */
     NULL,		/* tag file directory (absolute) */
     NULL,		/* file pointer */
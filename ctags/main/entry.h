@@ -80,7 +80,7 @@ typedef struct sTagEntryInfo {
 /*
 *   GLOBAL VARIABLES
 */
-extern tagFile TagFile;
+extern THREAD_LOCAL tagFile TagFile;
 
 /*
 *   FUNCTION PROTOTYPES
@@ -38,6 +38,25 @@
 # define PRINTF(s,f)
 #endif
 
+/*  Storage class of the state the reader, the preprocessor and the parsers
+ *  keep while a file is parsed.  With thread-local storage each thread gets
+ *  its own parsing context so several files can be parsed concurrently (one
+ *  per thread).  HAVE_THREAD_LOCAL tells whether this is the case; if not,
+ *  callers have to serialize parsing.
+ */
+#if defined (__GNUC__) || defined (__clang__)
+# define THREAD_LOCAL	__thread
+# define HAVE_THREAD_LOCAL 1
+#elif defined (_MSC_VER)
+# define THREAD_LOCAL	__declspec(thread)
+# define HAVE_THREAD_LOCAL 1
+#elif defined (__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && ! defined (__STDC_NO_THREADS__)
+# define THREAD_LOCAL	_Thread_local
+# define HAVE_THREAD_LOCAL 1
+#else
+# define THREAD_LOCAL
+#endif
+
 
 /*  MS-DOS doesn't allow manipulation of standard error, so we send it to
  *  stdout instead.
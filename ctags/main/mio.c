@@ -219,6 +219,8 @@ MIO *mio_new_memory (unsigned char *data,
 	{
 		mio->type = MIO_TYPE_MEMORY;
 		mio->impl.mem.buf = data;
+		mio->impl.mem.buf2 = NULL;
+		mio->impl.mem.buf2_offset = 0;
 		mio->impl.mem.ungetch = EOF;
 		mio->impl.mem.pos = 0;
 		mio->impl.mem.size = size;
@@ -232,6 +234,84 @@ MIO *mio_new_memory (unsigned char *data,
 	return mio;
 }
 
+/**
+ * mio_new_memory_split:
+ * @data: Data of the first part of the stream
+ * @size: Length of @data in bytes
+ * @data2: Data following @data in the stream
+ * @size2: Length of @data2 in bytes
+ *
+ * Creates a new read-only #MIO object reading from two separate memory areas
+ * as if they were contiguous, for example the two parts of a gap buffer. This
+ * avoids joining them into a single buffer first.
+ *
+ * The data is neither copied nor freed, it must stay valid and unchanged for
+ * the lifetime of the returned object. Writing on the stream always fails.
+ *
+ * Free-function: mio_free()
+ *
+ * Returns: A new #MIO on success, or %NULL on failure.
+ */
+MIO *mio_new_memory_split (unsigned char *data,
+						   size_t size,
+						   unsigned char *data2,
+						   size_t size2)
+{
+	MIO *mio;
+
+	mio = mio_new_memory (data, size + size2, NULL, NULL);
+	if (mio)
+	{
+		mio->impl.mem.buf2 = data2;
+		mio->impl.mem.buf2_offset = size;
+	}
+
+	return mio;
+}
+
+/*
+ * mem_get_byte:
+ * @mio: A #MIO object of the type %MIO_TYPE_MEMORY
+ * @pos: Position of the byte, smaller than the size of the stream
+ *
+ * Returns: The byte at @pos, from the second memory area for split streams.
+ */
+static unsigned char mem_get_byte (MIO *mio, size_t pos)
+{
+	if (mio->impl.mem.buf2 && pos >= mio->impl.mem.buf2_offset)
+		return mio->impl.mem.buf2[pos - mio->impl.mem.buf2_offset];
+	return mio->impl.mem.buf[pos];
+}
+
+/*
+ * mem_copy:
+ * @mio: A #MIO object of the type %MIO_TYPE_MEMORY
+ * @dest: Where to copy the data
+ * @pos: Position of the first byte to copy
+ * @n: Number of bytes to copy, they must be inside the stream
+ *
+ * Copies data from the stream, handling the split between the memory areas of
+ * split streams.
+ */
+static void mem_copy (MIO *mio, unsigned char *dest, size_t pos, size_t n)
+{
+	if (mio->impl.mem.buf2 && pos + n > mio->impl.mem.buf2_offset)
+	{
+		if (pos < mio->impl.mem.buf2_offset)
+		{
+			size_t n1 = mio->impl.mem.buf2_offset - pos;
+
+			memcpy (dest, &mio->impl.mem.buf[pos], n1);
+			dest += n1;
+			pos += n1;
+			n -= n1;
+		}
+		memcpy (dest, &mio->impl.mem.buf2[pos - mio->impl.mem.buf2_offset], n);
+	}
+	else
+		memcpy (dest, &mio->impl.mem.buf[pos], n);
+}
+
 /**
  * mio_file_get_fp:
  * @mio: A #MIO object
@@ -268,13 +348,13 @@ FILE *mio_file_get_fp (MIO *mio)
  * was configured to free the memory when destroyed.</para></warning>
  *
  * Returns: The memory buffer of the given #MIO stream, or %NULL if the stream
- *          is not a memory stream.
+ *          is not a memory stream or is split in two memory areas.
  */
 unsigned char *mio_memory_get_data (MIO *mio, size_t *size)
 {
 	unsigned char *ptr = NULL;
 
-	if (mio->type == MIO_TYPE_MEMORY)
+	if (mio->type == MIO_TYPE_MEMORY && ! mio->impl.mem.buf2)
 	{
 		ptr = mio->impl.mem.buf;
 		if (size)
@@ -310,6 +390,7 @@ int mio_free (MIO *mio)
 			if (mio->impl.mem.free_func)
 				mio->impl.mem.free_func (mio->impl.mem.buf);
 			mio->impl.mem.buf = NULL;
+			mio->impl.mem.buf2 = NULL;
 			mio->impl.mem.pos = 0;
 			mio->impl.mem.size = 0;
 			mio->impl.mem.allocated_size = 0;
@@ -373,7 +454,7 @@ size_t mio_read (MIO *mio,
 					ptr++;
 				}
 
-				memcpy (ptr, &mio->impl.mem.buf[mio->impl.mem.pos], copy_bytes);
+				mem_copy (mio, ptr, mio->impl.mem.pos, copy_bytes);
 				mio->impl.mem.pos += copy_bytes;
 			}
 			if (mio->impl.mem.pos >= mio->impl.mem.size)
@@ -459,13 +540,16 @@ static int mem_try_resize (MIO *mio, size_t new_size)
  * Tries to ensure there is enough space for @n bytes to be written from the
  * current cursor position.
  *
- * Returns: %TRUE if there is enough space, %FALSE otherwise.
+ * Returns: %TRUE if there is enough space, %FALSE otherwise (always for
+ *          read-only split streams).
  */
 static int mem_try_ensure_space (MIO *mio, size_t n)
 {
 	int success = TRUE;
 
-	if (mio->impl.mem.pos + n > mio->impl.mem.size)
+	if (mio->impl.mem.buf2)
+		success = FALSE;
+	else if (mio->impl.mem.pos + n > mio->impl.mem.size)
 		success = mem_try_resize (mio, mio->impl.mem.pos + n);
 
 	return success;
@@ -674,7 +758,7 @@ int mio_getc (MIO *mio)
 		}
 		else if (mio->impl.mem.pos < mio->impl.mem.size)
 		{
-			rv = mio->impl.mem.buf[mio->impl.mem.pos];
+			rv = mem_get_byte (mio, mio->impl.mem.pos);
 			mio->impl.mem.pos++;
 		}
 		else
@@ -752,7 +836,7 @@ char *mio_gets (MIO *mio, char *s, size_t size)
 			}
 			for (; mio->impl.mem.pos < mio->impl.mem.size && i < (size - 1); i++)
 			{
-				s[i] = (char)mio->impl.mem.buf[mio->impl.mem.pos];
+				s[i] = (char)mem_get_byte (mio, mio->impl.mem.pos);
 				mio->impl.mem.pos++;
 				if (s[i] == '\n')
 				{
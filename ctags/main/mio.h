@@ -122,6 +122,8 @@ struct _MIO {
 		} file;
 		struct {
 			unsigned char *buf;
+			unsigned char *buf2;
+			size_t buf2_offset;
 			int ungetch;
 			size_t pos;
 			size_t size;
@@ -145,6 +147,10 @@ MIO *mio_new_memory (unsigned char *data,
 					 size_t size,
 					 MIOReallocFunc realloc_func,
 					 MIODestroyNotify free_func);
+MIO *mio_new_memory_split (unsigned char *data,
+						   size_t size,
+						   unsigned char *data2,
+						   size_t size2);
 int mio_free (MIO *mio);
 FILE *mio_file_get_fp (MIO *mio);
 unsigned char *mio_memory_get_data (MIO *mio, size_t *size);
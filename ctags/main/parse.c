@@ -32,8 +32,8 @@
 static parserDefinitionFunc* BuiltInParsers[] = { PARSER_LIST };
 parserDefinition** LanguageTable = NULL;
 unsigned int LanguageCount = 0;
-tagEntryFunction TagEntryFunction = NULL;
-void *TagEntryUserData = NULL;
+THREAD_LOCAL tagEntryFunction TagEntryFunction = NULL;
+THREAD_LOCAL void *TagEntryUserData = NULL;
 
 /*
 *   FUNCTION DEFINITIONS
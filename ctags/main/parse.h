@@ -128,8 +128,8 @@ extern void checkRegex (void);
 
 
 /* Extra stuff for Tag Manager */
-extern tagEntryFunction TagEntryFunction;
-extern void *TagEntryUserData;
+extern THREAD_LOCAL tagEntryFunction TagEntryFunction;
+extern THREAD_LOCAL void *TagEntryUserData;
 extern void setTagEntryFunction(tagEntryFunction entry_function, void *user_data);
 
 #endif	/* _PARSE_H */
@@ -27,8 +27,8 @@
 /*
 *   DATA DEFINITIONS
 */
-inputFile File;			/* globally read through macros */
-static MIOPos StartOfLine;	/* holds deferred position of start of line */
+THREAD_LOCAL inputFile File;			/* globally read through macros */
+static THREAD_LOCAL MIOPos StartOfLine;	/* holds deferred position of start of line */
 
 
 
@@ -297,8 +297,11 @@ extern boolean fileOpen (const char *const fileName, const langType language)
 /* The user should take care of allocate and free the buffer param. 
  * This func is NOT THREAD SAFE.
  * The user should not tamper with the buffer while this func is executing.
+ * If buffer2 isn't NULL, it is read after buffer as if both were a single
+ * buffer (e.g. the two parts of a gap buffer), without joining them.
  */
 extern boolean bufferOpen (unsigned char *buffer, size_t buffer_size,
+			   unsigned char *buffer2, size_t buffer2_size,
 			   const char *const fileName, const langType language )
 {
     boolean opened = FALSE;
@@ -311,6 +314,13 @@ extern boolean bufferOpen (unsigned char *buffer, size_t buffer_size,
     }
 
     /* check if we got a good buffer */
+    if (buffer2 == NULL)
+	buffer2_size = 0;
+    if (buffer == NULL || buffer_size == 0) {
+	buffer = buffer2;
+	buffer_size = buffer2_size;
+	buffer2_size = 0;
+    }
     if (buffer == NULL || buffer_size == 0) {
 	opened = FALSE;
 	return opened;
@@ -318,7 +328,10 @@ extern boolean bufferOpen (unsigned char *buffer, size_t buffer_size,
 	
     opened = TRUE;
 	    
-    File.mio = mio_new_memory (buffer, buffer_size, NULL, NULL);
+    if (buffer2_size > 0)
+	File.mio = mio_new_memory_split (buffer, buffer_size, buffer2, buffer2_size);
+    else
+	File.mio = mio_new_memory (buffer, buffer_size, NULL, NULL);
     setInputFileName (fileName);
     mio_getpos (File.mio, &StartOfLine);
     mio_getpos (File.mio, &File.filePosition);
@@ -92,7 +92,7 @@ typedef struct sInputFile {
 *   GLOBAL VARIABLES
 */
 /* should not be modified externally */
-extern inputFile File;
+extern THREAD_LOCAL inputFile File;
 
 /*
 *   FUNCTION PROTOTYPES
@@ -109,6 +109,7 @@ extern const unsigned char *fileReadLine (void);
 extern char *readLine (vString *const vLine, MIO *const mio);
 extern char *readSourceLine (vString *const vLine, MIOPos location, long *const pSeekValue);
 extern boolean bufferOpen (unsigned char *buffer, size_t buffer_size,
+			   unsigned char *buffer2, size_t buffer2_size,
 			   const char *const fileName, const langType language );
 #define bufferClose fileClose
 
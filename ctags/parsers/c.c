@@ -260,7 +260,7 @@ typedef struct sParenInfo
 *   DATA DEFINITIONS
 */
 
-static jmp_buf Exception;
+static THREAD_LOCAL jmp_buf Exception;
 
 static langType Lang_c;
 static langType Lang_cpp;
@@ -1264,7 +1264,7 @@ static void addOtherFields (tagEntryInfo* const tag, const tagType type,
 static const char *getVarType (const statementInfo *const st,
 							   const tokenInfo *const nameToken)
 {
-	static vString *vt = NULL;
+	static THREAD_LOCAL vString *vt = NULL;
 	unsigned int i;
 	unsigned int end = st->tokenIndex;
 	boolean seenType = FALSE;
@@ -2869,8 +2869,8 @@ static void nextToken (statementInfo *const st)
 /*
 *   Scanning support functions
 */
-static unsigned int contextual_fake_count = 0;
-static statementInfo *CurrentStatement = NULL;
+static THREAD_LOCAL unsigned int contextual_fake_count = 0;
+static THREAD_LOCAL statementInfo *CurrentStatement = NULL;
 
 static statementInfo *newStatement (statementInfo *const parent)
 {
@@ -204,14 +204,14 @@ typedef struct sTokenInfo {
 
 static langType Lang_fortran;
 static langType Lang_f77;
-static jmp_buf Exception;
-static int Ungetc = '\0';
-static unsigned int Column = 0;
-static boolean FreeSourceForm = FALSE;
-static boolean ParsingString;
-static tokenInfo *Parent = NULL;
-static boolean NewLine = TRUE;
-static unsigned int contextual_fake_count = 0;
+static THREAD_LOCAL jmp_buf Exception;
+static THREAD_LOCAL int Ungetc = '\0';
+static THREAD_LOCAL unsigned int Column = 0;
+static THREAD_LOCAL boolean FreeSourceForm = FALSE;
+static THREAD_LOCAL boolean ParsingString;
+static THREAD_LOCAL tokenInfo *Parent = NULL;
+static THREAD_LOCAL boolean NewLine = TRUE;
+static THREAD_LOCAL unsigned int contextual_fake_count = 0;
 
 /* indexed by tagType */
 static kindOption FortranKinds [TAG_COUNT] = {
@@ -323,7 +323,7 @@ static const keywordDesc FortranKeywordTable [] = {
 	{ "while",          KEYWORD_while        }
 };
 
-static struct {
+static THREAD_LOCAL struct {
 	unsigned int count;
 	unsigned int max;
 	tokenInfo* list;
@@ -935,7 +935,7 @@ static void checkForLabel (void)
  */
 static keywordId analyzeToken (vString *const name, langType language)
 {
-    static vString *keyword = NULL;
+    static THREAD_LOCAL vString *keyword = NULL;
     keywordId id;
 
     if (keyword == NULL)
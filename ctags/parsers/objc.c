@@ -431,25 +431,25 @@ typedef void (*parseNext) (vString * const ident, objcToken what);
 /********** Helpers */
 /* This variable hold the 'parser' which is going to
  * handle the next token */
-static parseNext toDoNext;
+static THREAD_LOCAL parseNext toDoNext;
 
 /* Special variable used by parser eater to
  * determine which action to put after their
  * job is finished. */
-static parseNext comeAfter;
+static THREAD_LOCAL parseNext comeAfter;
 
 /* Used by some parsers detecting certain token
  * to revert to previous parser. */
-static parseNext fallback;
+static THREAD_LOCAL parseNext fallback;
 
 
 /********** Grammar */
 static void globalScope (vString * const ident, objcToken what);
 static void parseMethods (vString * const ident, objcToken what);
 static void parseImplemMethods (vString * const ident, objcToken what);
-static vString *tempName = NULL;
-static vString *parentName = NULL;
-static objcKind parentType = K_INTERFACE;
+static THREAD_LOCAL vString *tempName = NULL;
+static THREAD_LOCAL vString *parentName = NULL;
+static THREAD_LOCAL objcKind parentType = K_INTERFACE;
 
 /* used to prepare tag for OCaml, just in case their is a need to
  * add additional information to the tag. */
@@ -490,7 +490,7 @@ static void addTag (vString * const ident, int kind)
 	makeTagEntry (&toCreate);
 }
 
-static objcToken waitedToken, fallBackToken;
+static THREAD_LOCAL objcToken waitedToken, fallBackToken;
 
 /* Ignore everything till waitedToken and jump to comeAfter.
  * If the "end" keyword is encountered break, doesn't remember
@@ -511,7 +511,7 @@ static void tillTokenOrFallBack (vString * const UNUSED (ident), objcToken what)
 	}
 }
 
-static int ignoreBalanced_count = 0;
+static THREAD_LOCAL int ignoreBalanced_count = 0;
 static void ignoreBalanced (vString * const UNUSED (ident), objcToken what)
 {
 
@@ -569,11 +569,11 @@ static void parseFields (vString * const ident, objcToken what)
 	}
 }
 
-static objcKind methodKind;
+static THREAD_LOCAL objcKind methodKind;
 
 
-static vString *fullMethodName;
-static vString *prevIdent;
+static THREAD_LOCAL vString *fullMethodName;
+static THREAD_LOCAL vString *prevIdent;
 
 static void parseMethodsName (vString * const ident, objcToken what)
 {
@@ -780,7 +780,7 @@ static void parseInterface (vString * const ident, objcToken what)
 
 static void parseStructMembers (vString * const ident, objcToken what)
 {
-	static parseNext prev = NULL;
+	static THREAD_LOCAL parseNext prev = NULL;
 
 	if (prev != NULL)
 	{
@@ -822,7 +822,7 @@ static void parseStructMembers (vString * const ident, objcToken what)
 }
 
 /* Called just after the struct keyword */
-static boolean parseStruct_gotName = FALSE;
+static THREAD_LOCAL boolean parseStruct_gotName = FALSE;
 static void parseStruct (vString * const ident, objcToken what)
 {
 	switch (what)
@@ -864,7 +864,7 @@ static void parseStruct (vString * const ident, objcToken what)
 }
 
 /* Parse enumeration members, ignoring potential initialization */
-static parseNext parseEnumFields_prev = NULL;
+static THREAD_LOCAL parseNext parseEnumFields_prev = NULL;
 static void parseEnumFields (vString * const ident, objcToken what)
 {
 	if (parseEnumFields_prev != NULL)
@@ -898,7 +898,7 @@ static void parseEnumFields (vString * const ident, objcToken what)
 }
 
 /* parse enum ... { ... */
-static boolean parseEnum_named = FALSE;
+static THREAD_LOCAL boolean parseEnum_named = FALSE;
 static void parseEnum (vString * const ident, objcToken what)
 {
 	switch (what)
@@ -972,7 +972,7 @@ static void parseTypedef (vString * const ident, objcToken what)
 	}
 }
 
-static boolean ignorePreprocStuff_escaped = FALSE;
+static THREAD_LOCAL boolean ignorePreprocStuff_escaped = FALSE;
 static void ignorePreprocStuff (vString * const UNUSED (ident), objcToken what)
 {
 	switch (what)
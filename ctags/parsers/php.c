@@ -229,16 +229,16 @@ typedef struct {
 static langType Lang_php;
 static langType Lang_zephir;
 
-static boolean InPhp = FALSE; /* whether we are between <? ?> */
+static THREAD_LOCAL boolean InPhp = FALSE; /* whether we are between <? ?> */
 
 /* current statement details */
-static struct {
+static THREAD_LOCAL struct {
 	accessType access;
 	implType impl;
 } CurrentStatement;
 
 /* Current namespace */
-static vString *CurrentNamespace;
+static THREAD_LOCAL vString *CurrentNamespace;
 
 
 static void buildPhpKeywordHash (const langType language)
@@ -281,7 +281,7 @@ static const char *implToString (const implType impl)
 static void initPhpEntry (tagEntryInfo *const e, const tokenInfo *const token,
 						  const phpKind kind, const accessType access)
 {
-	static vString *fullScope = NULL;
+	static THREAD_LOCAL vString *fullScope = NULL;
 	int parentKind = -1;
 
 	if (fullScope == NULL)
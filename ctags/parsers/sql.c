@@ -181,7 +181,7 @@ typedef struct sTokenInfoSQL {
 
 static langType Lang_sql;
 
-static jmp_buf Exception;
+static THREAD_LOCAL jmp_buf Exception;
 
 typedef enum {
 	SQLTAG_CURSOR,
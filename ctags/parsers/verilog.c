@@ -53,9 +53,9 @@ typedef struct {
 /*
  *   DATA DEFINITIONS
  */
-static int Ungetc;
+static THREAD_LOCAL int Ungetc;
 static int Lang_verilog;
-static jmp_buf Exception;
+static THREAD_LOCAL jmp_buf Exception;
 
 static kindOption VerilogKinds [] = {
  { TRUE, 'c', "constant",  "constants (define, parameter, specparam)" },
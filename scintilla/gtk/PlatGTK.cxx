@@ -160,6 +160,7 @@ class SurfaceImpl : public Surface {
 	int y;
 	bool inited;
 	bool createdGC;
+	PangoFontMap *fontMap;
 	PangoContext *pcontext;
 	PangoLayout *layout;
 	Converter conv;
@@ -172,6 +173,7 @@ public:
 	void Init(WindowID wid);
 	void Init(SurfaceID sid, WindowID wid);
 	void InitPixMap(int width, int height, Surface *surface_, WindowID wid);
+	void InitForThread(Surface *surface_);
 
 	void Release();
 	bool Initialised();
@@ -277,7 +279,7 @@ SurfaceImpl::SurfaceImpl() : et(singleByte),
 context(0),
 psurf(0),
 x(0), y(0), inited(false), createdGC(false)
-, pcontext(0), layout(0), characterSet(-1) {
+, fontMap(0), pcontext(0), layout(0), characterSet(-1) {
 }
 
 SurfaceImpl::~SurfaceImpl() {
@@ -300,6 +302,9 @@ void SurfaceImpl::Release() {
 	if (pcontext)
 		g_object_unref(pcontext);
 	pcontext = 0;
+	if (fontMap)
+		g_object_unref(fontMap);
+	fontMap = 0;
 	conv.Close();
 	characterSet = -1;
 	x = 0;
@@ -387,6 +392,26 @@ void SurfaceImpl::InitPixMap(int width, int height, Surface *surface_, WindowID
 	et = surfImpl->et;
 }
 
+void SurfaceImpl::InitForThread(Surface *surface_) {
+	PLATFORM_ASSERT(surface_);
+	Release();
+	SurfaceImpl *surfImpl = static_cast<SurfaceImpl *>(surface_);
+	PLATFORM_ASSERT(surfImpl->pcontext);
+	// Font maps can not be shared between threads so use a font map of our own
+	// set up like the context of surface_ so text measures the same.
+	fontMap = pango_cairo_font_map_new();
+	pcontext = pango_font_map_create_context(fontMap);
+	PLATFORM_ASSERT(pcontext);
+	pango_cairo_context_set_resolution(pcontext, pango_cairo_context_get_resolution(surfImpl->pcontext));
+	pango_cairo_context_set_font_options(pcontext, pango_cairo_context_get_font_options(surfImpl->pcontext));
+	pango_context_set_language(pcontext, pango_context_get_language(surfImpl->pcontext));
+	pango_context_set_base_dir(pcontext, pango_context_get_base_dir(surfImpl->pcontext));
+	layout = pango_layout_new(pcontext);
+	PLATFORM_ASSERT(layout);
+	inited = true;
+	et = surfImpl->et;
+}
+
 void SurfaceImpl::PenColour(ColourDesired fore) {
 	if (context) {
 		ColourDesired cdFore(fore.AsLong());
@@ -1914,6 +1939,63 @@ ElapsedTime::ElapsedTime() {
 	littleBit = curTime.tv_usec;
 }
 
+class MutexImpl : public Mutex {
+	GMutex mutex;
+public:
+	MutexImpl() {
+		g_mutex_init(&mutex);
+	}
+	virtual ~MutexImpl() {
+		g_mutex_clear(&mutex);
+	}
+	virtual void Lock() {
+		g_mutex_lock(&mutex);
+	}
+	virtual void Unlock() {
+		g_mutex_unlock(&mutex);
+	}
+};
+
+Mutex *Mutex::Allocate() {
+	return new MutexImpl();
+}
+
+class ThreadImpl : public Thread {
+	GThread *thread;
+	ThreadFunction function;
+	void *data;
+	static gpointer Run(gpointer user_data) {
+		ThreadImpl *threadImpl = static_cast<ThreadImpl *>(user_data);
+		threadImpl->function(threadImpl->data);
+		return NULL;
+	}
+public:
+	ThreadImpl(ThreadFunction function_, void *data_) : thread(0), function(function_), data(data_) {
+		thread = g_thread_new("Scintilla", Run, this);
+	}
+	virtual ~ThreadImpl() {
+		Join();
+	}
+	virtual void Join() {
+		if (thread) {
+			g_thread_join(thread);
+			thread = 0;
+		}
+	}
+};
+
+Thread *Thread::Start(ThreadFunction function, void *data) {
+	return new ThreadImpl(function, data);
+}
+
+int Thread::Concurrency() {
+#if GLIB_CHECK_VERSION(2, 36, 0)
+	return g_get_num_processors();
+#else
+	return 1;
+#endif
+}
+
 class DynamicLibraryImpl : public DynamicLibrary {
 protected:
 	GModule* m;
@@ -197,7 +197,7 @@ private:
 		guint timer;
 		TimeThunk() : reason(tickCaret), scintilla(NULL), timer(0) {}
 	};
-	TimeThunk timers[tickDwell+1];
+	TimeThunk timers[tickStyle+1];
 	virtual bool FineTickerAvailable();
 	virtual bool FineTickerRunning(TickReason reason);
 	virtual void FineTickerStart(TickReason reason, int millis, int tolerance);
@@ -870,7 +870,7 @@ void ScintillaGTK::Initialise() {
 		caret.period = 0;
 	}
 
-	for (TickReason tr = tickCaret; tr <= tickDwell; tr = static_cast<TickReason>(tr + 1)) {
+	for (TickReason tr = tickCaret; tr <= tickStyle; tr = static_cast<TickReason>(tr + 1)) {
 		timers[tr].reason = tr;
 		timers[tr].scintilla = this;
 	}
@@ -881,7 +881,7 @@ void ScintillaGTK::Initialise() {
 }
 
 void ScintillaGTK::Finalise() {
-	for (TickReason tr = tickCaret; tr <= tickDwell; tr = static_cast<TickReason>(tr + 1)) {
+	for (TickReason tr = tickCaret; tr <= tickStyle; tr = static_cast<TickReason>(tr + 1)) {
 		FineTickerCancel(tr);
 	}
 	ScintillaBase::Finalise();
@@ -85,6 +85,22 @@ public:
 	virtual const char * SCI_METHOD GetSubStyleBases() = 0;
 };
 
+// Operations of ILexer::PrivateCall used by a document to keep the state of its lexer at
+// the start of some lines so lexing can later continue from there.
+// lpcCheckpointSave returns the checkpoint after setting state and lengthState to the
+// state of the lexer at the start of line which stays valid until the next call, or 0
+// when lexing can not continue from that line.
+// lpcCheckpointRestore returns the checkpoint after resetting the lexer to continue
+// lexing at the start of line from state as saved before. Line 0 has an empty state.
+enum { lpcCheckpointSave=0x4C455801, lpcCheckpointRestore=0x4C455802 };
+
+struct LexerCheckpoint {
+	IDocument *pAccess;
+	Sci_Position line;
+	const char *state;
+	Sci_Position lengthState;
+};
+
 class ILoader {
 public:
 	virtual int SCI_METHOD Release() = 0;
@@ -304,6 +304,8 @@ public:
 	virtual void Init(WindowID wid)=0;
 	virtual void Init(SurfaceID sid, WindowID wid)=0;
 	virtual void InitPixMap(int width, int height, Surface *surface_, WindowID wid)=0;
+	/// Measures text like surface_ but can be used on another thread. Can not draw.
+	virtual void InitForThread(Surface *surface_)=0;
 
 	virtual void Release()=0;
 	virtual bool Initialised()=0;
@@ -437,6 +439,31 @@ public:
 	double Duration(bool reset=false);
 };
 
+/**
+ * Mutual exclusion for data shared with a Thread
+ */
+class Mutex {
+public:
+	virtual ~Mutex() {}
+	virtual void Lock() = 0;
+	virtual void Unlock() = 0;
+	static Mutex *Allocate();
+};
+
+/**
+ * Runs a function on a thread of its own
+ */
+class Thread {
+public:
+	typedef void (*ThreadFunction)(void *data);
+	virtual ~Thread() {}
+	/// Waits for the function to return: must be called before deleting the Thread.
+	virtual void Join() = 0;
+	static Thread *Start(ThreadFunction function, void *data);
+	/// Number of threads that can run at the same time.
+	static int Concurrency();
+};
+
 /**
  * Dynamic Library (DLL/SO/...) loading
  */
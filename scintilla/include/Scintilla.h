@@ -419,6 +419,9 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_CANPASTE 2173
 #define SCI_CANUNDO 2174
 #define SCI_EMPTYUNDOBUFFER 2175
+#define SCI_SETUNDOMEMORYLIMIT 3012
+#define SCI_GETUNDOMEMORYLIMIT 3013
+#define SCI_GETUNDOMEMORYUSE 3014
 #define SCI_UNDO 2176
 #define SCI_CUT 2177
 #define SCI_COPY 2178
@@ -510,6 +513,7 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SC_IDLESTYLING_TOVISIBLE 1
 #define SC_IDLESTYLING_AFTERVISIBLE 2
 #define SC_IDLESTYLING_ALL 3
+#define SC_IDLESTYLING_BACKGROUND 4
 #define SCI_SETIDLESTYLING 2692
 #define SCI_GETIDLESTYLING 2693
 #define SC_WRAP_NONE 0
@@ -806,6 +810,8 @@ typedef sptr_t (*SciFnDirect)(sptr_t ptr, unsigned int iMessage, uptr_t wParam,
 #define SCI_INDICATOREND 2509
 #define SCI_SETPOSITIONCACHE 2514
 #define SCI_GETPOSITIONCACHE 2515
+#define SCI_GETPOSITIONCACHEHITS 3010
+#define SCI_GETPOSITIONCACHEMISSES 3011
 #define SCI_COPYALLOWLINE 2519
 #define SCI_GETCHARACTERPOINTER 2520
 #define SCI_GETRANGEPOINTER 2643
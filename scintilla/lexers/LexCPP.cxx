@@ -223,6 +223,43 @@ bool IsStreamCommentStyle(int style) {
 		style == SCE_C_COMMENTDOCKEYWORDERROR;
 }
 
+// The state kept in checkpoints is a sequence of ints and strings
+void AppendInt(std::string &state, int value) {
+	state.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void AppendString(std::string &state, const std::string &value) {
+	AppendInt(state, static_cast<int>(value.length()));
+	state.append(value);
+}
+
+class CheckpointReader {
+	const char *state;
+	size_t length;
+	size_t position;
+public:
+	CheckpointReader(const char *state_, size_t length_) : state(state_), length(length_), position(0) {
+	}
+	bool AtEnd() const {
+		return position >= length;
+	}
+	bool ReadInt(int &value) {
+		if (position + sizeof(value) > length)
+			return false;
+		memcpy(&value, state + position, sizeof(value));
+		position += sizeof(value);
+		return true;
+	}
+	bool ReadString(std::string &value) {
+		int lengthValue = 0;
+		if (!ReadInt(lengthValue) || (lengthValue < 0) || (position + lengthValue > length))
+			return false;
+		value.assign(state + position, lengthValue);
+		position += lengthValue;
+		return true;
+	}
+};
+
 struct PPDefinition {
 	Sci_Position line;
 	std::string key;
@@ -234,6 +271,20 @@ struct PPDefinition {
 	}
 };
 
+// FNV-1a hash of a definition following those hashed into hash
+unsigned int HashDefinition(unsigned int hash, const PPDefinition &definition) {
+	std::string bytes;
+	AppendInt(bytes, definition.isUndef);
+	AppendString(bytes, definition.key);
+	AppendString(bytes, definition.value);
+	AppendString(bytes, definition.arguments);
+	for (std::string::const_iterator it = bytes.begin(); it != bytes.end(); ++it) {
+		hash ^= static_cast<unsigned char>(*it);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
 class LinePPState {
 	int state;
 	int ifTaken;
@@ -278,6 +329,14 @@ public:
 			ifTaken |= maskLevel();
 		}
 	}
+	void Append(std::string &checkpointState) const {
+		AppendInt(checkpointState, state);
+		AppendInt(checkpointState, ifTaken);
+		AppendInt(checkpointState, level);
+	}
+	bool Read(CheckpointReader &reader) {
+		return reader.ReadInt(state) && reader.ReadInt(ifTaken) && reader.ReadInt(level);
+	}
 };
 
 // Hold the preprocessor state for each line seen.
@@ -439,6 +498,8 @@ class LexerCPP : public ILexerWithSubStyles {
 	CharacterSet setWordStart;
 	PPStates vlls;
 	std::vector<PPDefinition> ppDefineHistory;
+	// Hashes of the definitions in ppDefineHistory up to and including each one, calculated as needed
+	std::vector<unsigned int> ppDefineHashes;
 	WordList keywords;
 	WordList keywords2;
 	WordList keywords3;
@@ -461,10 +522,16 @@ class LexerCPP : public ILexerWithSubStyles {
 	};
 	typedef std::map<std::string, SymbolValue> SymbolTable;
 	SymbolTable preprocessorDefinitionsStart;
+	// The definitions made by the first ppDefinitionsApplied entries of ppDefineHistory
+	// so that lexing a piece doesn't apply the whole history again
+	SymbolTable ppDefinitionsActive;
+	size_t ppDefinitionsApplied;
 	OptionsCPP options;
 	OptionSetCPP osCPP;
 	EscapeSequence escapeSeq;
 	SparseState<std::string> rawStringTerminators;
+	std::string checkpointState;
+	Sci_Position lineCheckpointLast;
 	enum { activeFlag = 0x40 };
 	enum { ssIdentifier, ssDocKeyword };
 	SubStyles subStyles;
@@ -476,6 +543,8 @@ public:
 		setArithmethicOp(CharacterSet::setNone, "+-/*%"),
 		setRelOp(CharacterSet::setNone, "=!<>"),
 		setLogicalOp(CharacterSet::setNone, "|&"),
+		ppDefinitionsApplied(0),
+		lineCheckpointLast(0),
 		subStyles(styleSubable, 0x80, 0x40, activeFlag) {
 	}
 	virtual ~LexerCPP() {
@@ -503,9 +572,7 @@ public:
 	void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess);
 	void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess);
 
-	void * SCI_METHOD PrivateCall(int, void *) {
-		return 0;
-	}
+	void * SCI_METHOD PrivateCall(int operation, void *pointer);
 
 	int SCI_METHOD LineEndTypesSupported() {
 		return SC_LINE_END_TYPE_UNICODE;
@@ -550,6 +617,11 @@ public:
 	static int MaskActive(int style) {
 		return style & ~activeFlag;
 	}
+	size_t DefinitionsBefore(Sci_Position line) const;
+	void TruncateDefinitions(size_t count);
+	unsigned int DefinitionsHash(size_t count);
+	void SaveCheckpoint(LexerCheckpoint *checkpoint);
+	bool RestoreCheckpoint(const LexerCheckpoint *checkpoint);
 	void EvaluateTokens(std::vector<std::string> &tokens, const SymbolTable &preprocessorDefinitions);
 	std::vector<std::string> Tokenize(const std::string &expr) const;
 	bool EvaluateExpression(const std::string &expr, const SymbolTable &preprocessorDefinitions);
@@ -622,20 +694,175 @@ Sci_Position SCI_METHOD LexerCPP::WordListSet(int n, const char *wl) {
 						preprocessorDefinitionsStart[name] = val;
 					}
 				}
+				// The whole document is lexed again with these
+				ppDefineHistory.clear();
+				ppDefineHashes.clear();
+				ppDefinitionsActive = preprocessorDefinitionsStart;
+				ppDefinitionsApplied = 0;
 			}
 		}
 	}
 	return firstModification;
 }
 
-// Functor used to truncate history
-struct After {
-	Sci_Position line;
-	explicit After(Sci_Position line_) : line(line_) {}
-	bool operator()(PPDefinition &p) const {
-		return p.line > line;
+// Set continuationLine if last character of previous line is '\'
+static bool ContinuesPreviousLine(Sci_Position lineCurrent, int initStyle, LexAccessor &styler) {
+	if ((LexerCPP::MaskActive(initStyle) == SCE_C_PREPROCESSOR) ||
+      (LexerCPP::MaskActive(initStyle) == SCE_C_COMMENTLINE) ||
+      (LexerCPP::MaskActive(initStyle) == SCE_C_COMMENTLINEDOC)) {
+		if (lineCurrent > 0) {
+			Sci_Position endLinePrevious = styler.LineEnd(lineCurrent - 1);
+			if (endLinePrevious > 0) {
+				return styler.SafeGetCharAt(endLinePrevious-1) == '\\';
+			}
+		}
 	}
-};
+	return false;
+}
+
+static int PrevNonWhite(Sci_PositionU startPos, LexAccessor &styler) {
+	Sci_Position back = startPos;
+	while (--back && IsSpaceEquiv(LexerCPP::MaskActive(styler.StyleAt(back))))
+		;
+	if (LexerCPP::MaskActive(styler.StyleAt(back)) == SCE_C_OPERATOR) {
+		return styler.SafeGetCharAt(back);
+	}
+	return ' ';
+}
+
+// Number of definitions in the history, which is ordered by line, made before line
+size_t LexerCPP::DefinitionsBefore(Sci_Position line) const {
+	size_t lower = 0;
+	size_t upper = ppDefineHistory.size();
+	while (lower < upper) {
+		const size_t middle = lower + (upper - lower) / 2;
+		if (ppDefineHistory[middle].line < line)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower;
+}
+
+void LexerCPP::TruncateDefinitions(size_t count) {
+	if (count >= ppDefineHistory.size())
+		return;
+	ppDefineHistory.erase(ppDefineHistory.begin() + count, ppDefineHistory.end());
+	if (ppDefineHashes.size() > count)
+		ppDefineHashes.resize(count);
+	if (ppDefinitionsApplied > count) {
+		// Definitions can't be taken back so start again
+		ppDefinitionsActive = preprocessorDefinitionsStart;
+		ppDefinitionsApplied = 0;
+	}
+}
+
+unsigned int LexerCPP::DefinitionsHash(size_t count) {
+	while (ppDefineHashes.size() < count) {
+		const unsigned int hashBefore = ppDefineHashes.empty() ? 2166136261u : ppDefineHashes.back();
+		ppDefineHashes.push_back(HashDefinition(hashBefore, ppDefineHistory[ppDefineHashes.size()]));
+	}
+	return (count > 0) ? ppDefineHashes[count - 1] : 2166136261u;
+}
+
+// The state at the start of a line is everything Lex finds when starting there: the
+// preprocessor state, definitions and raw string terminator kept from lexing the lines
+// before and what it looks back to in the document.
+// Only the definitions made since the last checkpoint are kept. Those before are
+// identified by their number and hash so the history is only restored when it still
+// has them, which it does when lexing continues from a checkpoint or one after it.
+void LexerCPP::SaveCheckpoint(LexerCheckpoint *checkpoint) {
+	LexAccessor styler(checkpoint->pAccess);
+	const Sci_Position line = checkpoint->line;
+	const Sci_PositionU startPos = styler.LineStart(line);
+	const int initStyle = (startPos > 0) ? static_cast<unsigned char>(styler.StyleAt(startPos - 1)) : 0;
+	const Sci_Position lineFrom = (lineCheckpointLast <= line) ? lineCheckpointLast : 0;
+	const size_t definitionsFrom = DefinitionsBefore(lineFrom);
+	const size_t definitionsTo = DefinitionsBefore(line);
+	checkpointState.clear();
+	AppendInt(checkpointState, ContinuesPreviousLine(line, initStyle, styler));
+	AppendInt(checkpointState, (startPos > 0) ? PrevNonWhite(startPos, styler) : ' ');
+	vlls.ForLine(line).Append(checkpointState);
+	// The terminator is left over after raw strings so only counts inside them
+	AppendString(checkpointState, (MaskActive(initStyle) == SCE_C_STRINGRAW) ?
+		rawStringTerminators.ValueAt(line-1) : std::string());
+	AppendInt(checkpointState, static_cast<int>(line - lineFrom));
+	AppendInt(checkpointState, static_cast<int>(definitionsFrom));
+	AppendInt(checkpointState, static_cast<int>(DefinitionsHash(definitionsFrom)));
+	for (size_t i = definitionsFrom; i < definitionsTo; i++) {
+		const PPDefinition &definition = ppDefineHistory[i];
+		AppendInt(checkpointState, static_cast<int>(line - definition.line));
+		AppendInt(checkpointState, definition.isUndef);
+		AppendString(checkpointState, definition.key);
+		AppendString(checkpointState, definition.value);
+		AppendString(checkpointState, definition.arguments);
+	}
+	checkpoint->state = checkpointState.c_str();
+	checkpoint->lengthState = static_cast<Sci_Position>(checkpointState.length());
+	lineCheckpointLast = line;
+}
+
+// What Lex looks back to is found again so only the rest is restored.
+// Nothing changes when the state can't be restored.
+bool LexerCPP::RestoreCheckpoint(const LexerCheckpoint *checkpoint) {
+	const Sci_Position line = checkpoint->line;
+	if (line == 0) {
+		rawStringTerminators = SparseState<std::string>();
+		TruncateDefinitions(0);
+		vlls.Add(line, LinePPState());
+		lineCheckpointLast = line;
+		return true;
+	}
+	CheckpointReader reader(checkpoint->state, checkpoint->lengthState);
+	int continuation = 0;
+	int chPrevNonWhite = 0;
+	LinePPState preproc;
+	std::string rawStringTerminator;
+	int linesBack = 0;
+	int definitionsBefore = 0;
+	int hashBefore = 0;
+	if (!reader.ReadInt(continuation) || !reader.ReadInt(chPrevNonWhite) ||
+		!preproc.Read(reader) || !reader.ReadString(rawStringTerminator) ||
+		!reader.ReadInt(linesBack) || !reader.ReadInt(definitionsBefore) || !reader.ReadInt(hashBefore))
+		return false;
+	// The definitions before those kept must be the ones there were when saving
+	if ((linesBack < 0) || (linesBack > line) ||
+		(DefinitionsBefore(line - linesBack) != static_cast<size_t>(definitionsBefore)) ||
+		(DefinitionsHash(definitionsBefore) != static_cast<unsigned int>(hashBefore)))
+		return false;
+	std::vector<PPDefinition> definitions;
+	while (!reader.AtEnd()) {
+		int linesBackDefinition = 0;
+		int isUndef = 0;
+		std::string key;
+		std::string value;
+		std::string arguments;
+		if (!reader.ReadInt(linesBackDefinition) || !reader.ReadInt(isUndef) || !reader.ReadString(key) ||
+			!reader.ReadString(value) || !reader.ReadString(arguments))
+			return false;
+		definitions.push_back(PPDefinition(line - linesBackDefinition, key, value, isUndef != 0, arguments));
+	}
+	TruncateDefinitions(definitionsBefore);
+	ppDefineHistory.insert(ppDefineHistory.end(), definitions.begin(), definitions.end());
+	rawStringTerminators = SparseState<std::string>();
+	if (!rawStringTerminator.empty())
+		rawStringTerminators.Set(line-1, rawStringTerminator);
+	vlls.Add(line, preproc);
+	lineCheckpointLast = line;
+	return true;
+}
+
+void * SCI_METHOD LexerCPP::PrivateCall(int operation, void *pointer) {
+	LexerCheckpoint *checkpoint = static_cast<LexerCheckpoint *>(pointer);
+	switch (operation) {
+	case lpcCheckpointSave:
+		SaveCheckpoint(checkpoint);
+		return checkpoint;
+	case lpcCheckpointRestore:
+		return RestoreCheckpoint(checkpoint) ? checkpoint : 0;
+	}
+	return 0;
+}
 
 void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int initStyle, IDocument *pAccess) {
 	LexAccessor styler(pAccess);
@@ -665,26 +892,11 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 	bool seenDocKeyBrace = false;
 
 	Sci_Position lineCurrent = styler.GetLine(startPos);
-	if ((MaskActive(initStyle) == SCE_C_PREPROCESSOR) ||
-      (MaskActive(initStyle) == SCE_C_COMMENTLINE) ||
-      (MaskActive(initStyle) == SCE_C_COMMENTLINEDOC)) {
-		// Set continuationLine if last character of previous line is '\'
-		if (lineCurrent > 0) {
-			Sci_Position endLinePrevious = styler.LineEnd(lineCurrent - 1);
-			if (endLinePrevious > 0) {
-				continuationLine = styler.SafeGetCharAt(endLinePrevious-1) == '\\';
-			}
-		}
-	}
+	continuationLine = ContinuesPreviousLine(lineCurrent, initStyle, styler);
 
 	// look back to set chPrevNonWhite properly for better regex colouring
 	if (startPos > 0) {
-		Sci_Position back = startPos;
-		while (--back && IsSpaceEquiv(MaskActive(styler.StyleAt(back))))
-			;
-		if (MaskActive(styler.StyleAt(back)) == SCE_C_OPERATOR) {
-			chPrevNonWhite = styler.SafeGetCharAt(back);
-		}
+		chPrevNonWhite = PrevNonWhite(startPos, styler);
 	}
 
 	StyleContext sc(startPos, length, initStyle, styler, static_cast<unsigned char>(0xff));
@@ -695,16 +907,17 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 	// Truncate ppDefineHistory before current line
 
 	if (!options.updatePreprocessor)
-		ppDefineHistory.clear();
+		TruncateDefinitions(0);
 
-	std::vector<PPDefinition>::iterator itInvalid = std::find_if(ppDefineHistory.begin(), ppDefineHistory.end(), After(lineCurrent-1));
-	if (itInvalid != ppDefineHistory.end()) {
-		ppDefineHistory.erase(itInvalid, ppDefineHistory.end());
+	const size_t definitionsValid = DefinitionsBefore(lineCurrent);
+	if (definitionsValid < ppDefineHistory.size()) {
+		TruncateDefinitions(definitionsValid);
 		definitionsChanged = true;
 	}
 
-	SymbolTable preprocessorDefinitions = preprocessorDefinitionsStart;
-	for (std::vector<PPDefinition>::iterator itDef = ppDefineHistory.begin(); itDef != ppDefineHistory.end(); ++itDef) {
+	// Only apply the definitions not applied when lexing before
+	SymbolTable &preprocessorDefinitions = ppDefinitionsActive;
+	for (std::vector<PPDefinition>::iterator itDef = ppDefineHistory.begin() + ppDefinitionsApplied; itDef != ppDefineHistory.end(); ++itDef) {
 		if (itDef->isUndef)
 			preprocessorDefinitions.erase(itDef->key);
 		else
@@ -1272,6 +1485,7 @@ void SCI_METHOD LexerCPP::Lex(Sci_PositionU startPos, Sci_Position length, int i
 		continuationLine = false;
 		sc.Forward();
 	}
+	ppDefinitionsApplied = ppDefineHistory.size();
 	const bool rawStringsChanged = rawStringTerminators.Merge(rawSTNew, lineCurrent);
 	if (definitionsChanged || rawStringsChanged)
 		styler.ChangeLexerState(startPos, startPos + length);
@@ -567,6 +567,21 @@ static Sci_Position FindPhpStringDelimiter(char *phpStringDelimiter, const int p
 	return j - 1;
 }
 
+static int PrevNonWhiteJS(Sci_Position startPos, Accessor &styler) {
+	Sci_Position back = startPos;
+	int style = 0;
+	while (--back) {
+		style = styler.StyleAt(back);
+		if (style < SCE_HJ_DEFAULT || style > SCE_HJ_COMMENTDOC)
+			// includes SCE_HJ_COMMENT & SCE_HJ_COMMENTLINE
+			break;
+	}
+	if (style == SCE_HJ_SYMBOLS) {
+		return static_cast<unsigned char>(styler.SafeGetCharAt(back));
+	}
+	return ' ';
+}
+
 static void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, int initStyle, WordList *keywordlists[],
                                   Accessor &styler, bool isXml) {
 	WordList &keywords = *keywordlists[0];
@@ -695,17 +710,7 @@ static void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, i
 	int chPrevNonWhite = ' ';
 	// look back to set chPrevNonWhite properly for better regex colouring
 	if (scriptLanguage == eScriptJS && startPos > 0) {
-		Sci_Position back = startPos;
-		int style = 0;
-		while (--back) {
-			style = styler.StyleAt(back);
-			if (style < SCE_HJ_DEFAULT || style > SCE_HJ_COMMENTDOC)
-				// includes SCE_HJ_COMMENT & SCE_HJ_COMMENTLINE
-				break;
-		}
-		if (style == SCE_HJ_SYMBOLS) {
-			chPrevNonWhite = static_cast<unsigned char>(styler.SafeGetCharAt(back));
-		}
+		chPrevNonWhite = PrevNonWhiteJS(startPos, styler);
 	}
 
 	styler.StartSegment(startPos);
@@ -2167,6 +2172,24 @@ static void ColourisePHPScriptDoc(Sci_PositionU startPos, Sci_Position length, i
 	ColouriseHTMLDoc(startPos, length, initStyle, keywordlists, styler);
 }
 
+// Lexing continues from the start of a line with the style before it, the line state of
+// the previous line and the fold level of the line, except inside tags and PHP strings
+// where it goes back further. The fold level and the character looked back to for
+// JavaScript regular expressions are the state of the checkpoint.
+static bool CheckpointHyperText(Sci_Position line, Accessor &styler, int &state) {
+	const Sci_Position startPos = styler.LineStart(line);
+	int chPrevNonWhite = ' ';
+	if (startPos > 0) {
+		const int styleBefore = stateForPrintState(styler.StyleAt(startPos - 1));
+		if (InTagState(styleBefore) || isPHPStringState(styleBefore))
+			return false;
+		if (ScriptOfState(styleBefore) == eScriptJS)
+			chPrevNonWhite = PrevNonWhiteJS(startPos, styler);
+	}
+	state = (styler.LevelAt(line) & SC_FOLDLEVELNUMBERMASK) | (chPrevNonWhite << 16);
+	return true;
+}
+
 static const char * const htmlWordListDesc[] = {
 	"HTML elements and attributes",
 	"JavaScript keywords",
@@ -2187,6 +2210,6 @@ static const char * const phpscriptWordListDesc[] = {
 	0,
 };
 
-LexerModule lmHTML(SCLEX_HTML, ColouriseHTMLDoc, "hypertext", 0, htmlWordListDesc);
-LexerModule lmXML(SCLEX_XML, ColouriseXMLDoc, "xml", 0, htmlWordListDesc);
-LexerModule lmPHPSCRIPT(SCLEX_PHPSCRIPT, ColourisePHPScriptDoc, "phpscript", 0, phpscriptWordListDesc);
+LexerModule lmHTML(SCLEX_HTML, ColouriseHTMLDoc, "hypertext", 0, htmlWordListDesc, CheckpointHyperText);
+LexerModule lmXML(SCLEX_XML, ColouriseXMLDoc, "xml", 0, htmlWordListDesc, CheckpointHyperText);
+LexerModule lmPHPSCRIPT(SCLEX_PHPSCRIPT, ColourisePHPScriptDoc, "phpscript", 0, phpscriptWordListDesc, CheckpointHyperText);
@@ -34,11 +34,13 @@ LexerModule::LexerModule(int language_,
 	LexerFunction fnLexer_,
 	const char *languageName_,
 	LexerFunction fnFolder_,
-        const char *const wordListDescriptions_[]) :
+        const char *const wordListDescriptions_[],
+	LexerCheckpointFunction fnCheckpoint_) :
 	language(language_),
 	fnLexer(fnLexer_),
 	fnFolder(fnFolder_),
 	fnFactory(0),
+	fnCheckpoint(fnCheckpoint_),
 	wordListDescriptions(wordListDescriptions_),
 	languageName(languageName_) {
 }
@@ -51,6 +53,7 @@ LexerModule::LexerModule(int language_,
 	fnLexer(0),
 	fnFolder(0),
 	fnFactory(fnFactory_),
+	fnCheckpoint(0),
 	wordListDescriptions(wordListDescriptions_),
 	languageName(languageName_) {
 }
@@ -109,3 +112,7 @@ void LexerModule::Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initS
 		fnFolder(startPos, lengthDoc, initStyle, keywordlists, styler);
 	}
 }
+
+bool LexerModule::Checkpoint(Sci_Position line, Accessor &styler, int &state) const {
+	return fnCheckpoint && fnCheckpoint(line, styler, state);
+}
@@ -18,6 +18,7 @@ class WordList;
 typedef void (*LexerFunction)(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle,
                   WordList *keywordlists[], Accessor &styler);
 typedef ILexer *(*LexerFactoryFunction)();
+typedef bool (*LexerCheckpointFunction)(Sci_Position line, Accessor &styler, int &state);
 
 /**
  * A LexerModule is responsible for lexing and folding a particular language.
@@ -30,6 +31,7 @@ protected:
 	LexerFunction fnLexer;
 	LexerFunction fnFolder;
 	LexerFactoryFunction fnFactory;
+	LexerCheckpointFunction fnCheckpoint;
 	const char * const * wordListDescriptions;
 
 public:
@@ -38,7 +40,8 @@ public:
 		LexerFunction fnLexer_,
 		const char *languageName_=0,
 		LexerFunction fnFolder_=0,
-		const char * const wordListDescriptions_[] = NULL);
+		const char * const wordListDescriptions_[] = NULL,
+		LexerCheckpointFunction fnCheckpoint_=0);
 	LexerModule(int language_,
 		LexerFactoryFunction fnFactory_,
 		const char *languageName_,
@@ -57,6 +60,10 @@ public:
                   WordList *keywordlists[], Accessor &styler) const;
 	virtual void Fold(Sci_PositionU startPos, Sci_Position length, int initStyle,
                   WordList *keywordlists[], Accessor &styler) const;
+	// Lexers with all their state at the start of most lines in the document can
+	// continue from there
+	bool CanCheckpoint() const { return fnCheckpoint != 0; }
+	bool Checkpoint(Sci_Position line, Accessor &styler, int &state) const;
 
 	friend class Catalogue;
 };
@@ -55,3 +55,23 @@ void SCI_METHOD LexerSimple::Fold(Sci_PositionU startPos, Sci_Position lengthDoc
 		astyler.Flush();
 	}
 }
+
+void * SCI_METHOD LexerSimple::PrivateCall(int operation, void *pointer) {
+	if (module->CanCheckpoint()) {
+		LexerCheckpoint *checkpoint = static_cast<LexerCheckpoint *>(pointer);
+		if (operation == lpcCheckpointSave) {
+			Accessor astyler(checkpoint->pAccess, &props);
+			int state = 0;
+			if (!module->Checkpoint(checkpoint->line, astyler, state))
+				return 0;
+			checkpointState.assign(reinterpret_cast<const char *>(&state), sizeof(state));
+			checkpoint->state = checkpointState.c_str();
+			checkpoint->lengthState = static_cast<Sci_Position>(checkpointState.length());
+			return checkpoint;
+		} else if (operation == lpcCheckpointRestore) {
+			// The state is only kept for comparison as the lexer finds it in the document
+			return checkpoint;
+		}
+	}
+	return LexerBase::PrivateCall(operation, pointer);
+}
@@ -16,11 +16,13 @@ namespace Scintilla {
 class LexerSimple : public LexerBase {
 	const LexerModule *module;
 	std::string wordLists;
+	std::string checkpointState;
 public:
 	explicit LexerSimple(const LexerModule *module_);
 	const char * SCI_METHOD DescribeWordListSets();
 	void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, IDocument *pAccess);
 	void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, IDocument *pAccess);
+	void * SCI_METHOD PrivateCall(int operation, void *pointer);
 };
 
 #ifdef SCI_NAMESPACE
@@ -0,0 +1,635 @@
+// Scintilla source code edit control
+/** @file BackgroundLexer.cxx
+ ** Lexes a copy of a document on another thread.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Platform.h"
+
+#include "ILexer.h"
+#include "Scintilla.h"
+
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "UniConversion.h"
+#include "UnicodeFromUTF8.h"
+#include "BackgroundLexer.h"
+
+#ifdef SCI_NAMESPACE
+using namespace Scintilla;
+#endif
+
+#ifdef SCI_NAMESPACE
+namespace Scintilla {
+#endif
+
+/**
+ * The text and line structure of a document at the time lexing started together
+ * with the styles, fold levels and line states the lexer produces for it.
+ * Only single byte and UTF-8 documents are supported.
+ */
+class DocumentSnapshot : public IDocumentWithLineEnd {
+	std::string text;
+	std::vector<int> lineStarts;
+	int dbcsCodePage;
+	int tabInChars;
+	std::string styles;
+	std::vector<int> levels;
+	std::vector<int> lineStates;
+	int endStyled;
+
+	char CharAt(int position) const {
+		if ((position < 0) || (position >= Length()))
+			return 0;
+		return text[position];
+	}
+	bool InGoodUTF8(int pos, int &start, int &end) const;
+	int NextPosition(int pos, int moveDir) const;
+	void StyleWritten(int position, int length);
+	void LineWritten(int line);
+
+public:
+	// Extents written since ResetWritten
+	int positionWrittenStart;
+	int positionWrittenEnd;
+	int lineWrittenFirst;
+	int lineWrittenLast;
+	int errorStatus;
+
+	explicit DocumentSnapshot(Document *pdoc);
+	virtual ~DocumentSnapshot() {
+	}
+	void ResetWritten();
+	StyledChunk *ChunkWritten() const;
+
+	int SCI_METHOD Version() const {
+		return dvLineEnd;
+	}
+	void SCI_METHOD SetErrorStatus(int status) {
+		errorStatus = status;
+	}
+	Sci_Position SCI_METHOD Length() const {
+		return static_cast<Sci_Position>(text.length());
+	}
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const;
+	char SCI_METHOD StyleAt(Sci_Position position) const {
+		if ((position < 0) || (position >= Length()))
+			return 0;
+		return styles[position];
+	}
+	Sci_Position SCI_METHOD LineFromPosition(Sci_Position position) const;
+	Sci_Position SCI_METHOD LineStart(Sci_Position line) const;
+	int SCI_METHOD GetLevel(Sci_Position line) const;
+	int SCI_METHOD SetLevel(Sci_Position line, int level);
+	int SCI_METHOD GetLineState(Sci_Position line) const;
+	int SCI_METHOD SetLineState(Sci_Position line, int state);
+	void SCI_METHOD StartStyling(Sci_Position position, char mask);
+	bool SCI_METHOD SetStyleFor(Sci_Position length, char style);
+	bool SCI_METHOD SetStyles(Sci_Position length, const char *styles_);
+	void SCI_METHOD DecorationSetCurrentIndicator(int) {
+	}
+	void SCI_METHOD DecorationFillRange(Sci_Position, int, Sci_Position) {
+	}
+	void SCI_METHOD ChangeLexerState(Sci_Position, Sci_Position) {
+		// The styles are published with change notifications which cause redrawing anyway
+	}
+	int SCI_METHOD CodePage() const {
+		return dbcsCodePage;
+	}
+	bool SCI_METHOD IsDBCSLeadByte(char) const {
+		return false;
+	}
+	const char * SCI_METHOD BufferPointer() {
+		return text.c_str();
+	}
+	int SCI_METHOD GetLineIndentation(Sci_Position line);
+	Sci_Position SCI_METHOD LineEnd(Sci_Position line) const;
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const;
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const;
+};
+
+/**
+ * What was written by lexing one piece of a DocumentSnapshot
+ * and the checkpoints of the lexer state within the piece.
+ */
+struct StyledChunk {
+	int position;
+	std::string styles;
+	int line;
+	std::vector<int> levels;
+	std::vector<int> lineStates;
+	int linePiece;
+	int linePieceEnd;
+	std::vector<int> checkpointLines;
+	std::vector<StyleCheckpoint> checkpoints;
+	StyledChunk() : position(0), line(0), linePiece(0), linePieceEnd(0) {
+	}
+};
+
+#ifdef SCI_NAMESPACE
+}
+#endif
+
+DocumentSnapshot::DocumentSnapshot(Document *pdoc) :
+	dbcsCodePage(pdoc->dbcsCodePage), tabInChars(pdoc->tabInChars), endStyled(0),
+	positionWrittenStart(0), positionWrittenEnd(0), lineWrittenFirst(0), lineWrittenLast(-1),
+	errorStatus(0) {
+	const int length = pdoc->Length();
+	const int lines = pdoc->LinesTotal();
+	text.resize(length);
+	if (length > 0)
+		pdoc->GetCharRange(&text[0], 0, length);
+	lineStarts.resize(lines + 1);
+	for (int line = 0; line <= lines; line++)
+		lineStarts[line] = pdoc->LineStart(line);
+	// Lexing starts from the beginning so nothing of the document is needed here
+	styles.resize(length, '\0');
+	levels.resize(lines, SC_FOLDLEVELBASE);
+}
+
+bool DocumentSnapshot::InGoodUTF8(int pos, int &start, int &end) const {
+	int trail = pos;
+	while ((trail>0) && (pos-trail < UTF8MaxBytes) && UTF8IsTrailByte(static_cast<unsigned char>(CharAt(trail-1))))
+		trail--;
+	start = (trail > 0) ? trail-1 : trail;
+
+	const unsigned char leadByte = static_cast<unsigned char>(CharAt(start));
+	const int widthCharBytes = UTF8BytesOfLead[leadByte];
+	if (widthCharBytes == 1) {
+		return false;
+	} else {
+		int trailBytes = widthCharBytes - 1;
+		int len = pos - start;
+		if (len > trailBytes)
+			// pos too far from lead
+			return false;
+		char charBytes[UTF8MaxBytes] = {static_cast<char>(leadByte),0,0,0};
+		for (int b=1; b<widthCharBytes && ((start+b) < Length()); b++)
+			charBytes[b] = CharAt(start+b);
+		int utf8status = UTF8Classify(reinterpret_cast<const unsigned char *>(charBytes), widthCharBytes);
+		if (utf8status & UTF8MaskInvalid)
+			return false;
+		end = start + widthCharBytes;
+		return true;
+	}
+}
+
+// Same as Document::NextPosition for single byte and UTF-8 text
+int DocumentSnapshot::NextPosition(int pos, int moveDir) const {
+	int increment = (moveDir > 0) ? 1 : -1;
+	if (pos + increment <= 0)
+		return 0;
+	if (pos + increment >= Length())
+		return Length();
+
+	if (SC_CP_UTF8 == dbcsCodePage) {
+		if (increment == 1) {
+			const unsigned char leadByte = static_cast<unsigned char>(CharAt(pos));
+			if (UTF8IsAscii(leadByte)) {
+				pos++;
+			} else {
+				const int widthCharBytes = UTF8BytesOfLead[leadByte];
+				char charBytes[UTF8MaxBytes] = {static_cast<char>(leadByte),0,0,0};
+				for (int b=1; b<widthCharBytes; b++)
+					charBytes[b] = CharAt(pos+b);
+				int utf8status = UTF8Classify(reinterpret_cast<const unsigned char *>(charBytes), widthCharBytes);
+				if (utf8status & UTF8MaskInvalid)
+					pos++;
+				else
+					pos += utf8status & UTF8MaskWidth;
+			}
+		} else {
+			pos--;
+			unsigned char ch = static_cast<unsigned char>(CharAt(pos));
+			if (UTF8IsTrailByte(ch)) {
+				int startUTF = pos;
+				int endUTF = pos;
+				if (InGoodUTF8(pos, startUTF, endUTF)) {
+					pos = startUTF;
+				}
+			}
+		}
+	} else {
+		pos += increment;
+	}
+	return pos;
+}
+
+void DocumentSnapshot::StyleWritten(int position, int length) {
+	if (positionWrittenStart >= positionWrittenEnd) {
+		positionWrittenStart = position;
+		positionWrittenEnd = position + length;
+	} else {
+		positionWrittenStart = std::min(positionWrittenStart, position);
+		positionWrittenEnd = std::max(positionWrittenEnd, position + length);
+	}
+}
+
+void DocumentSnapshot::LineWritten(int line) {
+	if (lineWrittenFirst > lineWrittenLast) {
+		lineWrittenFirst = line;
+		lineWrittenLast = line;
+	} else {
+		lineWrittenFirst = std::min(lineWrittenFirst, line);
+		lineWrittenLast = std::max(lineWrittenLast, line);
+	}
+}
+
+void DocumentSnapshot::ResetWritten() {
+	positionWrittenStart = 0;
+	positionWrittenEnd = 0;
+	lineWrittenFirst = 0;
+	lineWrittenLast = -1;
+}
+
+StyledChunk *DocumentSnapshot::ChunkWritten() const {
+	StyledChunk *chunk = new StyledChunk();
+	chunk->position = positionWrittenStart;
+	chunk->styles.assign(styles, positionWrittenStart, positionWrittenEnd - positionWrittenStart);
+	chunk->line = lineWrittenFirst;
+	for (int line = lineWrittenFirst; line <= lineWrittenLast; line++) {
+		chunk->levels.push_back(GetLevel(line));
+		chunk->lineStates.push_back(GetLineState(line));
+	}
+	return chunk;
+}
+
+void SCI_METHOD DocumentSnapshot::GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const {
+	if ((lengthRetrieve < 0) || (position < 0) || ((position + lengthRetrieve) > Length()))
+		return;
+	memcpy(buffer, text.c_str() + position, lengthRetrieve);
+}
+
+Sci_Position SCI_METHOD DocumentSnapshot::LineFromPosition(Sci_Position position) const {
+	const int lines = static_cast<int>(lineStarts.size()) - 1;
+	if (lines <= 1)
+		return 0;
+	if (position >= lineStarts[lines])
+		return lines - 1;
+	std::vector<int>::const_iterator it = std::upper_bound(lineStarts.begin(), lineStarts.begin() + lines, position);
+	if (it == lineStarts.begin())
+		return 0;
+	return static_cast<Sci_Position>(it - lineStarts.begin()) - 1;
+}
+
+Sci_Position SCI_METHOD DocumentSnapshot::LineStart(Sci_Position line) const {
+	const int lines = static_cast<int>(lineStarts.size()) - 1;
+	if (line < 0)
+		return 0;
+	else if (line >= lines)
+		return Length();
+	else
+		return lineStarts[line];
+}
+
+int SCI_METHOD DocumentSnapshot::GetLevel(Sci_Position line) const {
+	if ((line >= 0) && (line < static_cast<Sci_Position>(levels.size())))
+		return levels[line];
+	return SC_FOLDLEVELBASE;
+}
+
+int SCI_METHOD DocumentSnapshot::SetLevel(Sci_Position line, int level) {
+	int prev = SC_FOLDLEVELBASE;
+	if ((line >= 0) && (line < static_cast<Sci_Position>(levels.size()))) {
+		prev = levels[line];
+		if (prev != level) {
+			levels[line] = level;
+		}
+		LineWritten(line);
+	}
+	return prev;
+}
+
+int SCI_METHOD DocumentSnapshot::GetLineState(Sci_Position line) const {
+	if ((line >= 0) && (line < static_cast<Sci_Position>(lineStates.size())))
+		return lineStates[line];
+	return 0;
+}
+
+int SCI_METHOD DocumentSnapshot::SetLineState(Sci_Position line, int state) {
+	if (line < 0)
+		return 0;
+	if (line >= static_cast<Sci_Position>(lineStates.size()))
+		lineStates.resize(line + 1, 0);
+	const int statePrevious = lineStates[line];
+	lineStates[line] = state;
+	LineWritten(line);
+	return statePrevious;
+}
+
+void SCI_METHOD DocumentSnapshot::StartStyling(Sci_Position position, char) {
+	endStyled = position;
+}
+
+bool SCI_METHOD DocumentSnapshot::SetStyleFor(Sci_Position length, char style) {
+	if ((length < 0) || (endStyled < 0) || (endStyled + length > Length()))
+		return false;
+	std::fill(styles.begin() + endStyled, styles.begin() + endStyled + length, style);
+	StyleWritten(endStyled, length);
+	endStyled += length;
+	return true;
+}
+
+bool SCI_METHOD DocumentSnapshot::SetStyles(Sci_Position length, const char *styles_) {
+	if ((length < 0) || (endStyled < 0) || (endStyled + length > Length()))
+		return false;
+	std::copy(styles_, styles_ + length, styles.begin() + endStyled);
+	StyleWritten(endStyled, length);
+	endStyled += length;
+	return true;
+}
+
+int SCI_METHOD DocumentSnapshot::GetLineIndentation(Sci_Position line) {
+	int indent = 0;
+	if ((line >= 0) && (line < static_cast<Sci_Position>(lineStarts.size()) - 1)) {
+		const int length = Length();
+		for (int i = LineStart(line); i < length; i++) {
+			const char ch = text[i];
+			if (ch == ' ')
+				indent++;
+			else if (ch == '\t')
+				indent = ((indent / tabInChars) + 1) * tabInChars;
+			else
+				return indent;
+		}
+	}
+	return indent;
+}
+
+Sci_Position SCI_METHOD DocumentSnapshot::LineEnd(Sci_Position line) const {
+	const int lines = static_cast<int>(lineStarts.size()) - 1;
+	if (line >= lines - 1) {
+		return LineStart(line + 1);
+	} else {
+		int position = LineStart(line + 1);
+		if (SC_CP_UTF8 == dbcsCodePage) {
+			unsigned char bytes[] = {
+				static_cast<unsigned char>(CharAt(position-3)),
+				static_cast<unsigned char>(CharAt(position-2)),
+				static_cast<unsigned char>(CharAt(position-1)),
+			};
+			if (UTF8IsSeparator(bytes)) {
+				return position - UTF8SeparatorLength;
+			}
+			if (UTF8IsNEL(bytes+1)) {
+				return position - UTF8NELLength;
+			}
+		}
+		position--; // Back over CR or LF
+		// When line terminator is CR+LF, may need to go back one more
+		if ((position > LineStart(line)) && (CharAt(position - 1) == '\r')) {
+			position--;
+		}
+		return position;
+	}
+}
+
+Sci_Position SCI_METHOD DocumentSnapshot::GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const {
+	int pos = positionStart;
+	if (dbcsCodePage) {
+		const int increment = (characterOffset > 0) ? 1 : -1;
+		while (characterOffset != 0) {
+			const int posNext = NextPosition(pos, increment);
+			if (posNext == pos)
+				return INVALID_POSITION;
+			pos = posNext;
+			characterOffset -= increment;
+		}
+	} else {
+		pos = positionStart + characterOffset;
+		if ((pos < 0) || (pos > Length()))
+			return INVALID_POSITION;
+	}
+	return pos;
+}
+
+int SCI_METHOD DocumentSnapshot::GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const {
+	int character;
+	int bytesInCharacter = 1;
+	if (SC_CP_UTF8 == dbcsCodePage) {
+		const unsigned char leadByte = static_cast<unsigned char>(CharAt(position));
+		if (UTF8IsAscii(leadByte)) {
+			// Single byte character or invalid
+			character =  leadByte;
+		} else {
+			const int widthCharBytes = UTF8BytesOfLead[leadByte];
+			unsigned char charBytes[UTF8MaxBytes] = {leadByte,0,0,0};
+			for (int b=1; b<widthCharBytes; b++)
+				charBytes[b] = static_cast<unsigned char>(CharAt(position+b));
+			int utf8status = UTF8Classify(charBytes, widthCharBytes);
+			if (utf8status & UTF8MaskInvalid) {
+				// Report as singleton surrogate values which are invalid Unicode
+				character =  0xDC80 + leadByte;
+			} else {
+				bytesInCharacter = utf8status & UTF8MaskWidth;
+				character = UnicodeFromUTF8(charBytes);
+			}
+		}
+	} else {
+		character = CharAt(position);
+	}
+	if (pWidth) {
+		*pWidth = bytesInCharacter;
+	}
+	return character;
+}
+
+BackgroundLexer::BackgroundLexer(Document *pdoc, ILexer *instance_) :
+	snapshot(0), instance(instance_), mutex(0), thread(0),
+	positionLexed(0), errorStatus(0), cancelled(false), finished(false), chunkNext(0), published(false) {
+	snapshot = new DocumentSnapshot(pdoc);
+	mutex = Mutex::Allocate();
+	thread = Thread::Start(RunThread, this);
+}
+
+BackgroundLexer::~BackgroundLexer() {
+	Cancel();
+	delete thread;
+	delete mutex;
+	delete snapshot;
+	if (instance)
+		instance->Release();
+	for (std::vector<StyledChunk *>::iterator it = chunksLexed.begin(); it != chunksLexed.end(); ++it)
+		delete *it;
+	for (size_t i = chunkNext; i < chunksPending.size(); i++)
+		delete chunksPending[i];
+}
+
+void BackgroundLexer::RunThread(void *data) {
+	static_cast<BackgroundLexer *>(data)->Run();
+}
+
+bool BackgroundLexer::Cancelled() {
+	mutex->Lock();
+	const bool cancelledNow = cancelled;
+	mutex->Unlock();
+	return cancelledNow;
+}
+
+void BackgroundLexer::LexRange(int start, int end) {
+	const int styleStart = (start > 0) ? snapshot->StyleAt(start - 1) : 0;
+	instance->Lex(start, end - start, styleStart, snapshot);
+	instance->Fold(start, end - start, styleStart, snapshot);
+}
+
+// Lexes the snapshot in pieces of whole lines like Document::EnsureStyledTo would,
+// handing over what each piece wrote including anything before the piece the lexer
+// went back to. When the lexer supports checkpoints, pieces are lexed in steps
+// like the document does so the state at the start of each step can be kept.
+void BackgroundLexer::Run() {
+	const int length = snapshot->Length();
+	int position = 0;
+	try {
+		LexerCheckpoint lexerCheckpoint = {snapshot, 0, "", 0};
+		const bool checkpointing = instance->PrivateCall(lpcCheckpointRestore, &lexerCheckpoint) != 0;
+		while ((position < length) && !Cancelled()) {
+			const int line = snapshot->LineFromPosition(position);
+			const int lineEnd = snapshot->LineFromPosition(position + pieceLength) + 1;
+			const int end = snapshot->LineStart(lineEnd);
+			snapshot->ResetWritten();
+			std::vector<int> checkpointLines;
+			std::vector<StyleCheckpoint> checkpoints;
+			if (checkpointing) {
+				for (int lineStep = line; lineStep < lineEnd; lineStep += LineCheckpoints::spacing) {
+					StyleCheckpoint checkpoint;
+					if (LexInterface::SaveCheckpoint(instance, snapshot, lineStep, checkpoint)) {
+						checkpointLines.push_back(lineStep);
+						checkpoints.push_back(checkpoint);
+					}
+					const int lineStepEnd = std::min(lineStep + static_cast<int>(LineCheckpoints::spacing), lineEnd);
+					LexRange(snapshot->LineStart(lineStep), snapshot->LineStart(lineStepEnd));
+				}
+			} else {
+				LexRange(position, end);
+			}
+			StyledChunk *chunk = snapshot->ChunkWritten();
+			chunk->linePiece = line;
+			chunk->linePieceEnd = lineEnd;
+			chunk->checkpointLines.swap(checkpointLines);
+			chunk->checkpoints.swap(checkpoints);
+			mutex->Lock();
+			chunksLexed.push_back(chunk);
+			positionLexed = end;
+			if (snapshot->errorStatus) {
+				errorStatus = snapshot->errorStatus;
+				snapshot->errorStatus = 0;
+			}
+			mutex->Unlock();
+			position = end;
+		}
+	} catch (...) {
+		// Out of memory: the document styles the rest itself
+	}
+	mutex->Lock();
+	finished = true;
+	mutex->Unlock();
+}
+
+void BackgroundLexer::Cancel() {
+	if (thread) {
+		mutex->Lock();
+		cancelled = true;
+		mutex->Unlock();
+		thread->Join();
+	}
+}
+
+static bool PublishChunk(Document *pdoc, const StyledChunk &chunk) {
+	const int endStyledBefore = pdoc->GetEndStyled();
+	const int lengthStyles = static_cast<int>(chunk.styles.length());
+	if (lengthStyles > 0) {
+		if (chunk.position > endStyledBefore) {
+			// Styles are only published contiguously from the start
+			return false;
+		}
+		pdoc->StartStyling(chunk.position, '\377');
+		if (!pdoc->SetStyles(lengthStyles, chunk.styles.c_str()))
+			return false;
+		// Text styled by the document itself after the chunk is still valid
+		if (pdoc->GetEndStyled() < endStyledBefore)
+			pdoc->StartStyling(endStyledBefore, '\377');
+	}
+	for (size_t i = 0; i < chunk.levels.size(); i++) {
+		const int line = chunk.line + static_cast<int>(i);
+		if (pdoc->GetLevel(line) != chunk.levels[i])
+			pdoc->SetLevel(line, chunk.levels[i]);
+		if (pdoc->GetLineState(line) != chunk.lineStates[i])
+			pdoc->SetLineState(line, chunk.lineStates[i]);
+	}
+	// The text of the piece was lexed from the states of the checkpoints
+	// within it and from the last checkpoint before it
+	LineCheckpoints *checkpoints = pdoc->Checkpoints();
+	checkpoints->RemoveRange(chunk.linePiece, chunk.linePieceEnd);
+	StyleCheckpoint *checkpointBefore = checkpoints->At(checkpoints->Before(chunk.linePiece));
+	if (checkpointBefore && !chunk.checkpoints.empty())
+		checkpointBefore->intact = true;
+	for (size_t i = 0; i < chunk.checkpoints.size(); i++) {
+		checkpoints->Set(chunk.checkpointLines[i], chunk.checkpoints[i]);
+		checkpoints->At(chunk.checkpointLines[i])->intact = (i + 1) < chunk.checkpoints.size();
+	}
+	return true;
+}
+
+// Publishes the chunks lexed so far for up to secondsAllowed.
+// Returns false once everything has been published or publishing can not continue.
+bool BackgroundLexer::Publish(Document *pdoc, double secondsAllowed) {
+	ElapsedTime etPublishing;
+	mutex->Lock();
+	chunksPending.insert(chunksPending.end(), chunksLexed.begin(), chunksLexed.end());
+	chunksLexed.clear();
+	const bool finishedLexing = finished;
+	const int errorStatusLexing = errorStatus;
+	errorStatus = 0;
+	mutex->Unlock();
+
+	if (errorStatusLexing)
+		pdoc->SetErrorStatus(errorStatusLexing);
+
+	while (chunkNext < chunksPending.size()) {
+		StyledChunk *chunk = chunksPending[chunkNext];
+		const bool publishedChunk = PublishChunk(pdoc, *chunk);
+		delete chunk;
+		chunkNext++;
+		if (!publishedChunk)
+			return false;
+		published = true;
+		if (etPublishing.Duration() > secondsAllowed)
+			break;
+	}
+	if (chunkNext == chunksPending.size()) {
+		chunksPending.clear();
+		chunkNext = 0;
+	}
+	return !(finishedLexing && chunksPending.empty());
+}
+
+// The end of the lexed text: the lexer instance has state for the lines before it.
+int BackgroundLexer::PositionLexed() {
+	mutex->Lock();
+	const int position = positionLexed;
+	mutex->Unlock();
+	return position;
+}
+
+ILexer *BackgroundLexer::TakeInstance() {
+	Cancel();
+	ILexer *instanceTaken = instance;
+	instance = 0;
+	return instanceTaken;
+}
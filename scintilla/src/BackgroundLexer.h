@@ -0,0 +1,64 @@
+// Scintilla source code edit control
+/** @file BackgroundLexer.h
+ ** Lexes a copy of a document on another thread.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#ifndef BACKGROUNDLEXER_H
+#define BACKGROUNDLEXER_H
+
+#ifdef SCI_NAMESPACE
+namespace Scintilla {
+#endif
+
+class DocumentSnapshot;
+struct StyledChunk;
+
+/**
+ * Lexes a snapshot of a document from its start with a lexer instance of its own.
+ * The styles, fold levels and line states produced are handed back to the document
+ * in chunks which are published to it from the thread of the document.
+ */
+class BackgroundLexer {
+	DocumentSnapshot *snapshot;
+	ILexer *instance;
+	Mutex *mutex;
+	Thread *thread;
+
+	// Shared with the thread so only accessed with mutex locked
+	std::vector<StyledChunk *> chunksLexed;
+	int positionLexed;
+	int errorStatus;
+	bool cancelled;
+	bool finished;
+
+	// Only accessed by the thread of the document
+	std::vector<StyledChunk *> chunksPending;
+	size_t chunkNext;
+	bool published;
+
+	static void RunThread(void *data);
+	void LexRange(int start, int end);
+	void Run();
+	bool Cancelled();
+
+	// Private so BackgroundLexer objects can not be copied
+	BackgroundLexer(const BackgroundLexer &);
+	BackgroundLexer &operator=(const BackgroundLexer &);
+public:
+	enum { pieceLength = 0x20000 };
+
+	BackgroundLexer(Document *pdoc, ILexer *instance_);
+	~BackgroundLexer();
+	void Cancel();
+	bool Publish(Document *pdoc, double secondsAllowed);
+	bool Published() const { return published; }
+	int PositionLexed();
+	ILexer *TakeInstance();
+};
+
+#ifdef SCI_NAMESPACE
+}
+#endif
+
+#endif
@@ -11,6 +11,7 @@
 #include <stdarg.h>
 
 #include <stdexcept>
+#include <vector>
 #include <algorithm>
 
 #include "Platform.h"
@@ -81,38 +82,27 @@ Action::Action() {
 	mayCoalesce = false;
 }
 
-Action::~Action() {
-	Destroy();
-}
-
-void Action::Create(actionType at_, int position_, const char *data_, int lenData_, bool mayCoalesce_) {
-	delete []data;
-	data = NULL;
+void Action::Create(actionType at_, int position_, char *data_, int lenData_, bool mayCoalesce_) {
 	position = position_;
 	at = at_;
-	if (lenData_) {
-		data = new char[lenData_];
-		memcpy(data, data_, lenData_);
-	}
+	data = data_;
 	lenData = lenData_;
 	mayCoalesce = mayCoalesce_;
 }
 
 void Action::Destroy() {
-	delete []data;
 	data = 0;
+	lenData = 0;
 }
 
 void Action::Grab(Action *source) {
-	delete []data;
-
 	position = source->position;
 	at = source->at;
 	data = source->data;
 	lenData = source->lenData;
 	mayCoalesce = source->mayCoalesce;
 
-	// Ownership of source data transferred to this
+	// The source is left empty
 	source->position = 0;
 	source->at = startAction;
 	source->data = 0;
@@ -120,6 +110,86 @@ void Action::Grab(Action *source) {
 	source->mayCoalesce = true;
 }
 
+namespace {
+
+// Most actions are short so many of them share each block
+const size_t arenaBlockSize = 0x10000;
+
+}
+
+UndoArena::UndoArena() : allocated(0) {
+}
+
+UndoArena::~UndoArena() {
+	FreeAll();
+}
+
+char *UndoArena::Allocate(size_t length) {
+	if (blocks.empty() || ((blocks.back().size - blocks.back().used) < length)) {
+		Block block = {0, 0, 0};
+		blocks.push_back(block);
+		const size_t size = std::max(length, arenaBlockSize);
+		blocks.back().text = new char[size];
+		blocks.back().size = size;
+		allocated += size;
+	}
+	Block &block = blocks.back();
+	char *text = block.text + block.used;
+	block.used += length;
+	return text;
+}
+
+// Lengthens text allocated last in place if there is room in its block
+bool UndoArena::Extend(const char *text, size_t length, size_t lengthExtra) {
+	if (blocks.empty())
+		return false;
+	Block &block = blocks.back();
+	if ((text + length != block.text + block.used) || ((block.size - block.used) < lengthExtra))
+		return false;
+	block.used += lengthExtra;
+	return true;
+}
+
+// Frees everything allocated after end which is the end of text still used
+void UndoArena::FreeAfter(const char *end) {
+	if (!end) {
+		FreeAll();
+		return;
+	}
+	while (!blocks.empty()) {
+		Block &block = blocks.back();
+		if ((end > block.text) && (end <= block.text + block.size)) {
+			block.used = end - block.text;
+			return;
+		}
+		delete []block.text;
+		allocated -= block.size;
+		blocks.pop_back();
+	}
+}
+
+// Frees the blocks allocated before the one containing start which is the oldest text still used
+void UndoArena::FreeBefore(const char *start) {
+	for (size_t i = 0; i < blocks.size(); i++) {
+		if ((start >= blocks[i].text) && (start < blocks[i].text + blocks[i].size)) {
+			for (size_t j = 0; j < i; j++) {
+				delete []blocks[j].text;
+				allocated -= blocks[j].size;
+			}
+			blocks.erase(blocks.begin(), blocks.begin() + i);
+			return;
+		}
+	}
+}
+
+void UndoArena::FreeAll() {
+	for (size_t i = 0; i < blocks.size(); i++) {
+		delete []blocks[i].text;
+	}
+	blocks.clear();
+	allocated = 0;
+}
+
 // The undo history stores a sequence of user operations that represent the user's view of the
 // commands executed on the text.
 // Each user operation contains a sequence of text insertion and text deletion actions.
@@ -137,6 +207,10 @@ void Action::Grab(Action *source) {
 // operation. If there is no outstanding BeginUndoAction call then a new operation is started
 // unless it looks as if the new action is caused by the user typing or deleting a stream of text.
 // Sequences that look like typing or deletion are coalesced into a single user operation.
+// Within an operation, text inserted right after the previous insertion or removed at the
+// position of the previous removal is appended to that action instead of adding another.
+// The text of all actions is kept in an UndoArena. When a memory limit is set, the oldest
+// user operations are dropped once the history uses more than that.
 
 UndoHistory::UndoHistory() {
 
@@ -147,6 +221,7 @@ UndoHistory::UndoHistory() {
 	undoSequenceDepth = 0;
 	savePoint = 0;
 	tentativePoint = -1;
+	memoryLimit = 0;
 
 	actions[currentAction].Create(startAction);
 }
@@ -171,6 +246,38 @@ void UndoHistory::EnsureUndoRoom() {
 	}
 }
 
+// The end of the text of the last action before act which has any
+const char *UndoHistory::EndOfDataBefore(int act) const {
+	for (act--; act > 0; act--) {
+		if (actions[act].lenData)
+			return actions[act].data + actions[act].lenData;
+	}
+	return 0;
+}
+
+// Adds the text to the previous action when it continues it as typing or deleting forwards does
+bool UndoHistory::AppendToPrevious(actionType at, int position, const char *data, int lengthData, bool mayCoalesce) {
+	if ((currentAction < 2) || (actions[currentAction].at != startAction) || !mayCoalesce || (lengthData == 0))
+		return false;
+	Action &previous = actions[currentAction - 1];
+	if ((previous.at != at) || !previous.mayCoalesce || (previous.lenData == 0))
+		return false;
+	if (at == insertAction) {
+		if (position != previous.position + previous.lenData)
+			return false;
+	} else if (at == removeAction) {
+		if (position != previous.position)
+			return false;
+	} else {
+		return false;
+	}
+	if (!arena.Extend(previous.data, previous.lenData, lengthData))
+		return false;
+	memcpy(previous.data + previous.lenData, data, lengthData);
+	previous.lenData += lengthData;
+	return true;
+}
+
 const char *UndoHistory::AppendAction(actionType at, int position, const char *data, int lengthData,
 	bool &startSequence, bool mayCoalesce) {
 	EnsureUndoRoom();
@@ -239,12 +346,25 @@ const char *UndoHistory::AppendAction(actionType at, int position, const char *d
 		currentAction++;
 	}
 	startSequence = oldCurrentAction != currentAction;
-	int actionWithData = currentAction;
-	actions[currentAction].Create(at, position, data, lengthData, mayCoalesce);
+	// Any actions from here on were undone and are replaced
+	arena.FreeAfter(EndOfDataBefore(currentAction));
+	if (!startSequence && AppendToPrevious(at, position, data, lengthData, mayCoalesce)) {
+		maxAction = currentAction;
+		const Action &previous = actions[currentAction - 1];
+		return previous.data + previous.lenData - lengthData;
+	}
+	char *dataAction = 0;
+	if (lengthData) {
+		dataAction = arena.Allocate(lengthData);
+		memcpy(dataAction, data, lengthData);
+	}
+	actions[currentAction].Create(at, position, dataAction, lengthData, mayCoalesce);
 	currentAction++;
 	actions[currentAction].Create(startAction);
 	maxAction = currentAction;
-	return actions[actionWithData].data;
+	if (startSequence)
+		LimitMemory();
+	return dataAction;
 }
 
 void UndoHistory::BeginUndoAction() {
@@ -286,6 +406,7 @@ void UndoHistory::DeleteUndoHistory() {
 	actions[currentAction].Create(startAction);
 	savePoint = 0;
 	tentativePoint = -1;
+	arena.FreeAll();
 }
 
 void UndoHistory::SetSavePoint() {
@@ -366,6 +487,68 @@ void UndoHistory::CompletedRedoStep() {
 	currentAction++;
 }
 
+// Forgets the actions before act which is the start action of a user operation
+void UndoHistory::DropOldest(int act) {
+	for (int i = act; i <= maxAction; i++)
+		actions[i - act].Grab(&actions[i]);
+	maxAction -= act;
+	currentAction -= act;
+	savePoint = (savePoint >= act) ? savePoint - act : -1;
+	if (tentativePoint >= 0)
+		tentativePoint -= act;
+	if ((lenActions > 100) && (maxAction < lenActions / 4)) {
+		// Shrink the array as it counts towards the limit too
+		const int lenActionsNew = std::max(lenActions / 2, 100);
+		Action *actionsNew = new Action[lenActionsNew];
+		for (int i = 0; i <= maxAction; i++)
+			actionsNew[i].Grab(&actions[i]);
+		delete []actions;
+		lenActions = lenActionsNew;
+		actions = actionsNew;
+	}
+	for (int i = 1; i <= maxAction; i++) {
+		if (actions[i].lenData) {
+			arena.FreeBefore(actions[i].data);
+			return;
+		}
+	}
+	arena.FreeAll();
+}
+
+// Drops the oldest user operations until the history uses an eighth less than
+// the limit so this is not repeated for each following operation. The current
+// operation and any tentative one are kept.
+void UndoHistory::LimitMemory() {
+	const size_t use = MemoryUse();
+	if ((memoryLimit == 0) || (use <= memoryLimit))
+		return;
+	const size_t target = memoryLimit - memoryLimit / 8;
+	size_t freed = 0;
+	int actDrop = 0;
+	for (int act = 1; act < currentAction; act++) {
+		if ((tentativePoint >= 0) && (act > tentativePoint))
+			break;
+		if (actions[act].at == startAction) {
+			actDrop = act;
+			if (use - freed <= target)
+				break;
+		} else {
+			freed += actions[act].lenData;
+		}
+	}
+	if (actDrop > 0)
+		DropOldest(actDrop);
+}
+
+void UndoHistory::SetMemoryLimit(size_t limit) {
+	memoryLimit = limit;
+	LimitMemory();
+}
+
+size_t UndoHistory::MemoryUse() const {
+	return arena.Allocated() + lenActions * sizeof(Action);
+}
+
 CellBuffer::CellBuffer() {
 	readOnly = false;
 	utf8LineEnds = 0;
@@ -792,6 +975,18 @@ void CellBuffer::DeleteUndoHistory() {
 	uh.DeleteUndoHistory();
 }
 
+void CellBuffer::SetUndoMemoryLimit(size_t limit) {
+	uh.SetMemoryLimit(limit);
+}
+
+size_t CellBuffer::GetUndoMemoryLimit() const {
+	return uh.GetMemoryLimit();
+}
+
+size_t CellBuffer::UndoMemoryUse() const {
+	return uh.MemoryUse();
+}
+
 bool CellBuffer::CanUndo() const {
 	return uh.CanUndo();
 }
@@ -69,6 +69,7 @@ enum actionType { insertAction, removeAction, startAction, containerAction };
 
 /**
  * Actions are used to store all the information required to perform one undo/redo step.
+ * The text of an action is owned by the UndoArena of its history.
  */
 class Action {
 public:
@@ -79,12 +80,39 @@ public:
 	bool mayCoalesce;
 
 	Action();
-	~Action();
-	void Create(actionType at_, int position_=0, const char *data_=0, int lenData_=0, bool mayCoalesce_=true);
+	void Create(actionType at_, int position_=0, char *data_=0, int lenData_=0, bool mayCoalesce_=true);
 	void Destroy();
 	void Grab(Action *source);
 };
 
+/**
+ * Holds the text of the actions in an UndoHistory packed into large blocks.
+ * As actions are discarded from the end of the history when new ones replace
+ * undone ones and from its start when it is too big, text is only allocated at
+ * the end and freed at either end.
+ */
+class UndoArena {
+	struct Block {
+		char *text;
+		size_t size;
+		size_t used;
+	};
+	std::vector<Block> blocks;
+	size_t allocated;
+
+	// Private so UndoArena objects can not be copied
+	UndoArena(const UndoArena &);
+
+public:
+	UndoArena();
+	~UndoArena();
+	char *Allocate(size_t length);
+	bool Extend(const char *text, size_t length, size_t lengthExtra);
+	void FreeAfter(const char *end);
+	void FreeBefore(const char *start);
+	void FreeAll();
+	size_t Allocated() const { return allocated; }
+};
 /**
  *
  */
@@ -96,8 +124,14 @@ class UndoHistory {
 	int undoSequenceDepth;
 	int savePoint;
 	int tentativePoint;
+	UndoArena arena;
+	size_t memoryLimit;
 
 	void EnsureUndoRoom();
+	const char *EndOfDataBefore(int act) const;
+	bool AppendToPrevious(actionType at, int position, const char *data, int lengthData, bool mayCoalesce);
+	void DropOldest(int act);
+	void LimitMemory();
 
 	// Private so UndoHistory objects can not be copied
 	UndoHistory(const UndoHistory &);
@@ -134,6 +168,11 @@ public:
 	int StartRedo();
 	const Action &GetRedoStep() const;
 	void CompletedRedoStep();
+
+	/// Oldest user operations are dropped to keep the memory used below the limit, 0 for none.
+	void SetMemoryLimit(size_t limit);
+	size_t GetMemoryLimit() const { return memoryLimit; }
+	size_t MemoryUse() const;
 };
 
 /**
@@ -223,6 +262,10 @@ public:
 	int StartRedo();
 	const Action &GetRedoStep() const;
 	void PerformRedoStep();
+
+	void SetUndoMemoryLimit(size_t limit);
+	size_t GetUndoMemoryLimit() const;
+	size_t UndoMemoryUse() const;
 };
 
 #ifdef SCI_NAMESPACE
@@ -20,6 +20,18 @@
 #include <regex>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SCI_FIND_SSE2
+#include <emmintrin.h>
+#if (defined(__x86_64__) || defined(__i386__)) && \
+	((defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 5)) || \
+	(defined(__clang__) && ((__clang_major__ > 3) || ((__clang_major__ == 3) && (__clang_minor__ >= 8)))))
+// AVX2 is used when the processor supports it, which is detected at run time
+#define SCI_FIND_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 #include "Platform.h"
 
 #include "ILexer.h"
@@ -39,6 +51,7 @@
 #include "RESearch.h"
 #include "UniConversion.h"
 #include "UnicodeFromUTF8.h"
+#include "BackgroundLexer.h"
 
 #ifdef SCI_NAMESPACE
 using namespace Scintilla;
@@ -63,17 +76,110 @@ void LexInterface::Colourise(int start, int end) {
 		PLATFORM_ASSERT(len >= 0);
 		PLATFORM_ASSERT(start + len <= lengthDoc);
 
-		int styleStart = 0;
-		if (start > 0)
-			styleStart = pdoc->StyleAt(start - 1);
+		if ((len > 0) && !ColouriseFromCheckpoints(start, end))
+			LexPiece(start, end);
+
+		performingStyle = false;
+	}
+}
+
+void LexInterface::LexPiece(int start, int end) {
+	int styleStart = 0;
+	if (start > 0)
+		styleStart = pdoc->StyleAt(start - 1);
+	instance->Lex(start, end - start, styleStart, pdoc);
+	instance->Fold(start, end - start, styleStart, pdoc);
+}
+
+// Records the state of a lexer and the document it lexed at the start of line.
+// Returns false when the lexer can not continue from there.
+bool LexInterface::SaveCheckpoint(ILexer *instance_, IDocument *pAccess, int line, StyleCheckpoint &checkpoint) {
+	LexerCheckpoint lexerCheckpoint = {pAccess, line, 0, 0};
+	if (!instance_->PrivateCall(lpcCheckpointSave, &lexerCheckpoint))
+		return false;
+	checkpoint.lexerState.assign(lexerCheckpoint.state, lexerCheckpoint.lengthState);
+	const int position = pAccess->LineStart(line);
+	checkpoint.styleBefore = (position > 0) ? pAccess->StyleAt(position - 1) : 0;
+	checkpoint.levelBefore = (line > 0) ? pAccess->GetLevel(line - 1) : SC_FOLDLEVELBASE;
+	checkpoint.lineStateBefore = (line > 0) ? pAccess->GetLineState(line - 1) : 0;
+	checkpoint.intact = false;
+	return true;
+}
+
+bool LexInterface::RestoreCheckpoint(int line) {
+	const StyleCheckpoint *checkpoint = pdoc->Checkpoints()->At(line);
+	LexerCheckpoint lexerCheckpoint = {pdoc, line, "", 0};
+	if (checkpoint) {
+		lexerCheckpoint.state = checkpoint->lexerState.c_str();
+		lexerCheckpoint.lengthState = static_cast<Sci_Position>(checkpoint->lexerState.length());
+	} else if (line != 0) {
+		return false;
+	}
+	return instance->PrivateCall(lpcCheckpointRestore, &lexerCheckpoint) != 0;
+}
 
-		if (len > 0) {
-			instance->Lex(start, len, styleStart, pdoc);
-			instance->Fold(start, len, styleStart, pdoc);
+// Lexes from the checkpoint before start in pieces which end at the following
+// checkpoints. When the state at the end of a piece is the same as before and the
+// text after it has not been modified since it was lexed, that text is skipped.
+// Returns false if the lexer does not support checkpoints.
+bool LexInterface::ColouriseFromCheckpoints(int start, int end) {
+	LineCheckpoints *checkpoints = pdoc->Checkpoints();
+	const int lengthDoc = pdoc->Length();
+	const int linesTotal = pdoc->LinesTotal();
+	int line = std::max(checkpoints->Before(pdoc->LineFromPosition(start)), 0);
+	if (!RestoreCheckpoint(line))
+		return false;
+	int position = pdoc->LineStart(line);
+	while (position < end) {
+		StyleCheckpoint *checkpointPiece = checkpoints->At(line);
+		if (checkpointPiece)
+			checkpointPiece->intact = false;
+		int lineNext = checkpoints->After(line, line + LineCheckpoints::spacing);
+		if (lineNext < 0)
+			lineNext = line + LineCheckpoints::spacing;
+		if (lineNext >= linesTotal) {
+			LexPiece(position, lengthDoc);
+			break;
 		}
+		const int positionNext = pdoc->LineStart(lineNext);
+		LexPiece(position, positionNext);
 
-		performingStyle = false;
+		StyleCheckpoint checkpoint;
+		if (!SaveCheckpoint(instance, pdoc, lineNext, checkpoint)) {
+			checkpoints->Remove(lineNext);
+		} else {
+			if (checkpointPiece)
+				checkpointPiece->intact = true;
+			const StyleCheckpoint *checkpointOld = checkpoints->At(lineNext);
+			if (checkpointOld && checkpointOld->intact && checkpointOld->SameState(checkpoint)) {
+				// The text up to the first checkpoint which is not intact is already styled.
+				// The lexer is restored to each checkpoint in turn as it may only keep
+				// what changed since the one before.
+				int lineSkip = lineNext;
+				while (checkpoints->At(lineSkip)->intact) {
+					const int lineAfter = checkpoints->After(lineSkip, linesTotal);
+					if ((lineAfter < 0) || !RestoreCheckpoint(lineAfter))
+						break;
+					lineSkip = lineAfter;
+				}
+				if (lineSkip > lineNext) {
+					lineNext = lineSkip;
+					pdoc->StartStyling(pdoc->LineStart(lineNext), '\377');
+				}
+			} else {
+				checkpoints->Set(lineNext, checkpoint);
+			}
+		}
+		line = lineNext;
+		position = pdoc->LineStart(line);
 	}
+	return true;
+}
+
+void LexInterface::ReplaceInstance(ILexer *instance_) {
+	if (instance)
+		instance->Release();
+	instance = instance_;
 }
 
 int LexInterface::LineEndTypesSupported() {
@@ -114,6 +220,8 @@ Document::Document() {
 	matchesValid = false;
 	regex = 0;
 
+	backgroundLexer = 0;
+
 	UTF8BytesOfLeadInitialise();
 
 	perLineData[ldMarkers] = new LineMarkers();
@@ -121,6 +229,7 @@ Document::Document() {
 	perLineData[ldState] = new LineState();
 	perLineData[ldMargin] = new LineAnnotation();
 	perLineData[ldAnnotation] = new LineAnnotation();
+	perLineData[ldCheckpoints] = new LineCheckpoints();
 
 	cb.SetPerLine(this);
 
@@ -131,6 +240,8 @@ Document::~Document() {
 	for (std::vector<WatcherWithUserData>::iterator it = watchers.begin(); it != watchers.end(); ++it) {
 		it->watcher->NotifyDeleted(this, it->userData);
 	}
+	delete backgroundLexer;
+	backgroundLexer = 0;
 	for (int j=0; j<ldSize; j++) {
 		delete perLineData[j];
 		perLineData[j] = 0;
@@ -159,6 +270,8 @@ int Document::LineEndTypesSupported() const {
 
 bool Document::SetDBCSCodePage(int dbcsCodePage_) {
 	if (dbcsCodePage != dbcsCodePage_) {
+		CancelBackgroundStyling();
+		ClearCheckpoints();
 		dbcsCodePage = dbcsCodePage_;
 		SetCaseFolder(NULL);
 		cb.SetLineEndTypes(lineEndBitSet & LineEndTypesSupported());
@@ -173,6 +286,7 @@ bool Document::SetLineEndTypesAllowed(int lineEndBitSet_) {
 		lineEndBitSet = lineEndBitSet_;
 		int lineEndBitSetActive = lineEndBitSet & LineEndTypesSupported();
 		if (lineEndBitSetActive != cb.GetLineEndTypes()) {
+			ClearCheckpoints();
 			ModifiedAt(0);
 			cb.SetLineEndTypes(lineEndBitSetActive);
 			return true;
@@ -430,6 +544,16 @@ int SCI_METHOD Document::GetLevel(Sci_Position line) const {
 
 void Document::ClearLevels() {
 	static_cast<LineLevels *>(perLineData[ldLevels])->ClearLevels();
+	ClearCheckpoints();
+}
+
+LineCheckpoints *Document::Checkpoints() const {
+	return static_cast<LineCheckpoints *>(perLineData[ldCheckpoints]);
+}
+
+// Forget the states lexing could continue from, as when the lexer or its settings change
+void Document::ClearCheckpoints() {
+	Checkpoints()->Init();
 }
 
 static bool IsSubordinate(int levelStart, int levelTry) {
@@ -943,6 +1067,9 @@ EncodingFamily Document::CodePageFamily() const {
 }
 
 void Document::ModifiedAt(int pos) {
+	CancelBackgroundStyling();
+	etModified.Duration(true);
+	Checkpoints()->Modified(LineFromPosition(pos));
 	if (endStyled > pos)
 		endStyled = pos;
 }
@@ -1640,6 +1767,232 @@ Document::CharacterExtracted Document::ExtractCharacter(int position) const {
 	}
 }
 
+namespace {
+
+// Forward search for a literal string over the two contiguous parts of the gap buffer.
+// Candidate positions are found by testing the first and last bytes of the string at
+// many positions at once. A byte b passes a test when (b | mask) == value so ASCII
+// letters can be tested case insensitively; mask and value 0xff accept any byte.
+struct LiteralFilter {
+	unsigned char firstValue;
+	unsigned char firstMask;
+	unsigned char lastValue;
+	unsigned char lastMask;
+	size_t lastOffset;
+};
+
+// Returns the index of the first candidate below count, or count if there is none.
+// text[count - 1 + lastOffset] has to be readable.
+typedef size_t (*CandidateScanner)(const char *text, size_t count, const LiteralFilter &filter);
+
+size_t ScanCandidatesScalar(const char *text, size_t count, const LiteralFilter &filter) {
+	const unsigned char *us = reinterpret_cast<const unsigned char *>(text);
+	for (size_t i = 0; i < count; i++) {
+		if (((us[i] | filter.firstMask) == filter.firstValue) &&
+			((us[i + filter.lastOffset] | filter.lastMask) == filter.lastValue))
+			return i;
+	}
+	return count;
+}
+
+#ifdef SCI_FIND_SSE2
+
+inline size_t LowestBit(unsigned int bits) {
+#if defined(__GNUC__)
+	return __builtin_ctz(bits);
+#else
+	size_t bit = 0;
+	while (!(bits & 1)) {
+		bits >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+size_t ScanCandidatesSSE2(const char *text, size_t count, const LiteralFilter &filter) {
+	const __m128i firstValue = _mm_set1_epi8(static_cast<char>(filter.firstValue));
+	const __m128i firstMask = _mm_set1_epi8(static_cast<char>(filter.firstMask));
+	const __m128i lastValue = _mm_set1_epi8(static_cast<char>(filter.lastValue));
+	const __m128i lastMask = _mm_set1_epi8(static_cast<char>(filter.lastMask));
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+		const __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + filter.lastOffset));
+		const __m128i matches = _mm_and_si128(
+			_mm_cmpeq_epi8(_mm_or_si128(first, firstMask), firstValue),
+			_mm_cmpeq_epi8(_mm_or_si128(last, lastMask), lastValue));
+		const unsigned int bits = static_cast<unsigned int>(_mm_movemask_epi8(matches));
+		if (bits)
+			return i + LowestBit(bits);
+	}
+	return i + ScanCandidatesScalar(text + i, count - i, filter);
+}
+
+#endif
+
+#ifdef SCI_FIND_AVX2
+
+__attribute__((target("avx2")))
+size_t ScanCandidatesAVX2(const char *text, size_t count, const LiteralFilter &filter) {
+	const __m256i firstValue = _mm256_set1_epi8(static_cast<char>(filter.firstValue));
+	const __m256i firstMask = _mm256_set1_epi8(static_cast<char>(filter.firstMask));
+	const __m256i lastValue = _mm256_set1_epi8(static_cast<char>(filter.lastValue));
+	const __m256i lastMask = _mm256_set1_epi8(static_cast<char>(filter.lastMask));
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32) {
+		const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+		const __m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + filter.lastOffset));
+		const __m256i matches = _mm256_and_si256(
+			_mm256_cmpeq_epi8(_mm256_or_si256(first, firstMask), firstValue),
+			_mm256_cmpeq_epi8(_mm256_or_si256(last, lastMask), lastValue));
+		const unsigned int bits = static_cast<unsigned int>(_mm256_movemask_epi8(matches));
+		if (bits)
+			return i + LowestBit(bits);
+	}
+	return i + ScanCandidatesSSE2(text + i, count - i, filter);
+}
+
+#endif
+
+CandidateScanner ChooseCandidateScanner() {
+#ifdef SCI_FIND_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return ScanCandidatesAVX2;
+#endif
+#ifdef SCI_FIND_SSE2
+	return ScanCandidatesSSE2;
+#else
+	return ScanCandidatesScalar;
+#endif
+}
+
+// Chosen once for the processor running the application
+const CandidateScanner candidateScanner = ChooseCandidateScanner();
+
+// Sets the test of a byte of the string from the bytes which fold to it
+void SetByteTest(const unsigned char *foldTable, unsigned char folded,
+	unsigned char &value, unsigned char &mask) {
+	if (!foldTable) {
+		value = folded;
+		mask = 0;
+		return;
+	}
+	int matching = 0;
+	unsigned char orBytes = 0;
+	unsigned char andBytes = 0xff;
+	for (int b = 0; b < 256; b++) {
+		if (foldTable[b] == folded) {
+			matching++;
+			orBytes |= static_cast<unsigned char>(b);
+			andBytes &= static_cast<unsigned char>(b);
+		}
+	}
+	if (matching == 1) {
+		value = orBytes;
+		mask = 0;
+	} else if ((matching == 2) && ((orBytes ^ andBytes) == 0x20)) {
+		value = orBytes;
+		mask = 0x20;
+	} else {
+		value = 0xff;
+		mask = 0xff;
+	}
+}
+
+bool MatchesFolded(const char *text, const char *folded, int length, const unsigned char *foldTable) {
+	if (!foldTable)
+		return memcmp(text, folded, length) == 0;
+	for (int i = 0; i < length; i++) {
+		if (foldTable[static_cast<unsigned char>(text[i])] != static_cast<unsigned char>(folded[i]))
+			return false;
+	}
+	return true;
+}
+
+bool MatchesFoldedAt(const Document *pdoc, int pos, const char *folded, int length,
+	const unsigned char *foldTable) {
+	for (int i = 0; i < length; i++) {
+		const unsigned char ch = static_cast<unsigned char>(pdoc->CharAt(pos + i));
+		if ((foldTable ? foldTable[ch] : ch) != static_cast<unsigned char>(folded[i]))
+			return false;
+	}
+	return true;
+}
+
+// Finds the first position in [startPos, endSearch) where folded matches the document
+// text folded through foldTable (or the text itself if foldTable is NULL).
+// In UTF-8 documents only the starts of characters are matched.
+long FindLiteralForward(Document *pdoc, int startPos, int endSearch, const char *folded,
+	int lengthFind, const unsigned char *foldTable, bool word, bool wordStart) {
+	LiteralFilter filter;
+	SetByteTest(foldTable, folded[0], filter.firstValue, filter.firstMask);
+	SetByteTest(foldTable, folded[lengthFind - 1], filter.lastValue, filter.lastMask);
+	filter.lastOffset = lengthFind - 1;
+	const bool checkCharacterStart = pdoc->dbcsCodePage == SC_CP_UTF8;
+
+	const int gapPosition = pdoc->GapPosition();
+	const int segmentStarts[2] = { 0, gapPosition };
+	const int segmentEnds[2] = { gapPosition, pdoc->Length() };
+	int pos = startPos;
+	for (int segment = 0; segment < 2 && pos < endSearch; segment++) {
+		const int segmentStart = segmentStarts[segment];
+		const int segmentEnd = segmentEnds[segment];
+		if (pos >= segmentEnd)
+			continue;
+		pos = Platform::Maximum(pos, segmentStart);
+		// Matches starting before endInside are completely inside the segment
+		const int endInside = Platform::Minimum(endSearch, segmentEnd - lengthFind + 1);
+		if (pos < endInside) {
+			// Does not move the gap as the range doesn't cross it
+			const char *text = pdoc->RangePointer(segmentStart, segmentEnd - segmentStart);
+			while (pos < endInside) {
+				const size_t count = endInside - pos;
+				const size_t offset = candidateScanner(text + (pos - segmentStart), count, filter);
+				if (offset == count) {
+					pos = endInside;
+					break;
+				}
+				pos += static_cast<int>(offset);
+				if (MatchesFolded(text + (pos - segmentStart), folded, lengthFind, foldTable) &&
+					(!checkCharacterStart || (pdoc->MovePositionOutsideChar(pos, 1, false) == pos)) &&
+					pdoc->MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+					return pos;
+				}
+				pos++;
+			}
+		}
+		// Matches crossing the gap
+		const int endSegment = Platform::Minimum(endSearch, segmentEnd);
+		for (; pos < endSegment; pos++) {
+			if (MatchesFoldedAt(pdoc, pos, folded, lengthFind, foldTable) &&
+				(!checkCharacterStart || (pdoc->MovePositionOutsideChar(pos, 1, false) == pos)) &&
+				pdoc->MatchesWordOptions(word, wordStart, pos, lengthFind)) {
+				return pos;
+			}
+		}
+	}
+	return -1;
+}
+
+// Whether a case insensitive search for an ASCII string in UTF-8 can compare bytes as
+// no other character folds to a part of the string. Only some characters like the
+// Kelvin sign, long s, sharp s and the f and st ligatures fold to ASCII letters.
+bool CaseInsensitiveASCIIFoldsBytewise(const char *search, int length) {
+	for (int i = 0; i < length; i++) {
+		const unsigned char ch = static_cast<unsigned char>(search[i]);
+		if (!UTF8IsAscii(ch))
+			return false;
+		const unsigned char lower = static_cast<unsigned char>(ch | 0x20);
+		if ((lower == 'f') || (lower == 'k') || (lower == 's'))
+			return false;
+	}
+	return true;
+}
+
+}
+
 /**
  * Find text in document, supporting both forward and backward
  * searches (just pass minPos > maxPos to do a backward search)
@@ -1676,6 +2029,27 @@ long Document::FindText(int minPos, int maxPos, const char *search,
 			// Back all of a character
 			pos = NextPosition(pos, increment);
 		}
+		if (forward && (!dbcsCodePage || (SC_CP_UTF8 == dbcsCodePage))) {
+			if (caseSensitive) {
+				// In UTF-8 a match of a string starting with a trail byte could start inside a character
+				if ((SC_CP_UTF8 != dbcsCodePage) || !UTF8IsTrailByte(static_cast<unsigned char>(search[0])))
+					return FindLiteralForward(this, pos, endPos - lengthFind + 1, search, lengthFind,
+						NULL, word, wordStart);
+			} else if ((SC_CP_UTF8 != dbcsCodePage) || CaseInsensitiveASCIIFoldsBytewise(search, lengthFind)) {
+				// Single bytes fold independently of each other
+				unsigned char foldTable[256];
+				for (int b = 0; b < 256; b++) {
+					const char ch = static_cast<char>(b);
+					char folded[2];
+					pcf->Fold(folded, sizeof(folded), &ch, 1);
+					foldTable[b] = static_cast<unsigned char>(folded[0]);
+				}
+				std::vector<char> searchThing(lengthFind + 1);
+				pcf->Fold(&searchThing[0], searchThing.size(), search, lengthFind);
+				return FindLiteralForward(this, pos, endPos - lengthFind + 1, &searchThing[0], lengthFind,
+					foldTable, word, wordStart);
+			}
+		}
 		if (caseSensitive) {
 			const int endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
 			const char charStartSearch =  search[0];
@@ -1920,6 +2294,59 @@ void Document::StyleToAdjustingLineDuration(int pos) {
 	}
 }
 
+// Starts lexing the document on another thread when much of it is left to style
+// and it has not been modified recently. Returns true while that is in progress.
+bool Document::StartBackgroundStyling() {
+	// Leave small amounts and text that is being typed to styling in this thread
+	const int minimumToStyle = 0x100000;
+	const double secondsSettled = 0.25;
+
+	if (backgroundLexer)
+		return true;
+	if (!pli || pli->UseContainerLexing())
+		return false;
+	if (dbcsCodePage && (dbcsCodePage != SC_CP_UTF8))
+		return false;
+	if ((Length() - GetEndStyled() < minimumToStyle) || (enteredStyling != 0))
+		return false;
+	if (etModified.Duration() < secondsSettled)
+		return false;
+	ILexer *instance = pli->NewInstance();
+	if (!instance)
+		return false;
+	backgroundLexer = new BackgroundLexer(this, instance);
+	return true;
+}
+
+// Publishes what has been lexed on the other thread for up to secondsAllowed.
+// Returns false when there is nothing more to come.
+bool Document::PublishBackgroundStyles(double secondsAllowed) {
+	if (!backgroundLexer)
+		return false;
+	if ((enteredStyling != 0) || backgroundLexer->Publish(this, secondsAllowed))
+		return true;
+	CancelBackgroundStyling();
+	return false;
+}
+
+void Document::CancelBackgroundStyling() {
+	if (backgroundLexer) {
+		BackgroundLexer *pbl = backgroundLexer;
+		backgroundLexer = 0;
+		pbl->Cancel();
+		if (pbl->Published() && pli) {
+			// The lexer of the document lacks the state, like that of
+			// preprocessor definitions, of the lines styled by the other lexer.
+			// So that lexer carries on from the end of what it lexed.
+			const int positionLexed = pbl->PositionLexed();
+			pli->ReplaceInstance(pbl->TakeInstance());
+			if (endStyled > positionLexed)
+				endStyled = positionLexed;
+		}
+		delete pbl;
+	}
+}
+
 void Document::LexerChanged() {
 	// Tell the watchers the lexer has changed.
 	for (std::vector<WatcherWithUserData>::iterator it = watchers.begin(); it != watchers.end(); ++it) {
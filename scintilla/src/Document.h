@@ -170,6 +170,9 @@ public:
 };
 
 class Document;
+class BackgroundLexer;
+class LineCheckpoints;
+struct StyleCheckpoint;
 
 inline int LevelNumber(int level) {
 	return level & SC_FOLDLEVELNUMBERMASK;
@@ -180,6 +183,9 @@ protected:
 	Document *pdoc;
 	ILexer *instance;
 	bool performingStyle;	///< Prevent reentrance
+	void LexPiece(int start, int end);
+	bool RestoreCheckpoint(int line);
+	bool ColouriseFromCheckpoints(int start, int end);
 public:
 	explicit LexInterface(Document *pdoc_) : pdoc(pdoc_), instance(0), performingStyle(false) {
 	}
@@ -190,6 +196,12 @@ public:
 	bool UseContainerLexing() const {
 		return instance == 0;
 	}
+	/// A new lexer instance set up like the current one, or 0 if there is none
+	virtual ILexer *NewInstance() {
+		return 0;
+	}
+	void ReplaceInstance(ILexer *instance_);
+	static bool SaveCheckpoint(ILexer *instance_, IDocument *pAccess, int line, StyleCheckpoint &checkpoint);
 };
 
 struct RegexError : public std::runtime_error {
@@ -230,12 +242,15 @@ private:
 	std::vector<WatcherWithUserData> watchers;
 
 	// ldSize is not real data - it is for dimensions and loops
-	enum lineData { ldMarkers, ldLevels, ldState, ldMargin, ldAnnotation, ldSize };
+	enum lineData { ldMarkers, ldLevels, ldState, ldMargin, ldAnnotation, ldCheckpoints, ldSize };
 	PerLine *perLineData[ldSize];
 
 	bool matchesValid;
 	RegexSearchBase *regex;
 
+	BackgroundLexer *backgroundLexer;
+	ElapsedTime etModified;
+
 public:
 
 	LexInterface *pli;
@@ -305,6 +320,9 @@ public:
 	bool CanUndo() const { return cb.CanUndo(); }
 	bool CanRedo() const { return cb.CanRedo(); }
 	void DeleteUndoHistory() { cb.DeleteUndoHistory(); }
+	void SetUndoMemoryLimit(size_t limit) { cb.SetUndoMemoryLimit(limit); }
+	size_t GetUndoMemoryLimit() const { return cb.GetUndoMemoryLimit(); }
+	size_t UndoMemoryUse() const { return cb.UndoMemoryUse(); }
 	bool SetUndoCollection(bool collectUndo) {
 		return cb.SetUndoCollection(collectUndo);
 	}
@@ -368,6 +386,8 @@ public:
 	int SCI_METHOD SetLevel(Sci_Position line, int level);
 	int SCI_METHOD GetLevel(Sci_Position line) const;
 	void ClearLevels();
+	LineCheckpoints *Checkpoints() const;
+	void ClearCheckpoints();
 	int GetLastChild(int lineParent, int level=-1, int lastLine=-1);
 	int GetFoldParent(int line) const;
 	void GetHighlightDelimiters(HighlightDelimiter &hDelimiter, int line, int lastLine);
@@ -408,6 +428,10 @@ public:
 	int GetEndStyled() const { return endStyled; }
 	void EnsureStyledTo(int pos);
 	void StyleToAdjustingLineDuration(int pos);
+	bool StartBackgroundStyling();
+	bool BackgroundStylingActive() const { return backgroundLexer != 0; }
+	bool PublishBackgroundStyles(double secondsAllowed);
+	void CancelBackgroundStyling();
 	void LexerChanged();
 	int GetStyleClock() const { return styleClock; }
 	void IncrementStyleClock();
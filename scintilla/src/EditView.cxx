@@ -1952,8 +1952,8 @@ static ColourDesired InvertedLight(ColourDesired orig) {
 
 long EditView::FormatRange(bool draw, Sci_RangeToFormat *pfr, Surface *surface, Surface *surfaceMeasure,
 	const EditModel &model, const ViewStyle &vs) {
-	// Can't use measurements cached for screen
-	posCache.Clear();
+	// Can't use measurements cached for screen and must not store printer measurements for it
+	posCache.SetEnabled(false);
 
 	ViewStyle vsPrint(vs);
 	vsPrint.technology = SC_TECHNOLOGY_DEFAULT;
@@ -2125,8 +2125,7 @@ long EditView::FormatRange(bool draw, Sci_RangeToFormat *pfr, Surface *surface,
 		++lineDoc;
 	}
 
-	// Clear cache so measurements are not used for screen
-	posCache.Clear();
+	posCache.SetEnabled(true);
 
 	return nPrintPos;
 }
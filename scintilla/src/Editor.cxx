@@ -183,6 +183,8 @@ Editor::Editor() {
 	recordingMacro = false;
 	foldAutomatic = 0;
 
+	durationWrapOneLine = 0.00001;
+
 	convertPastes = true;
 
 	SetRepresentations();
@@ -244,6 +246,9 @@ void Editor::SetRepresentations() {
 void Editor::DropGraphics(bool freeObjects) {
 	marginView.DropGraphics(freeObjects);
 	view.DropGraphics(freeObjects);
+	for (size_t i = 0; i < surfacesWrapThread.size(); i++)
+		delete surfacesWrapThread[i];
+	surfacesWrapThread.clear();
 }
 
 void Editor::AllocateGraphics() {
@@ -257,7 +262,6 @@ void Editor::InvalidateStyleData() {
 	DropGraphics(false);
 	AllocateGraphics();
 	view.llc.Invalidate(LineLayout::llInvalid);
-	view.posCache.Clear();
 }
 
 void Editor::InvalidateStyleRedraw() {
@@ -1470,10 +1474,132 @@ bool Editor::WrapOneLine(Surface *surface, int lineToWrap) {
 		(vs.annotationVisible ? pdoc->AnnotationLines(lineToWrap) : 0));
 }
 
+// Number of lines that can be wrapped in one idle slice while keeping interaction smooth.
+int Editor::LinesToWrapInIdle() const {
+	const double secondsAllowed = 0.01;
+	return Platform::Clamp(static_cast<int>(secondsAllowed / durationWrapOneLine),
+		LinesOnScreen() + 100, 0x10000);
+}
+
+void Editor::AdjustWrapDuration(int linesWrapped, double durationWrapping) {
+	// Place bounds on the duration used to avoid glitches spiking it
+	// and so causing too little or too much wrapping in an idle slice
+	const double minDurationOneLine = 0.000001;
+	const double maxDurationOneLine = 0.0001;
+
+	// Alpha value for exponential smoothing.
+	// Most recent value contributes 25% to smoothed value.
+	const double alpha = 0.25;
+
+	// Only adjust for wrapping multiple lines to avoid instability
+	if (linesWrapped >= 8) {
+		const double durationOneLine = durationWrapping / linesWrapped;
+		durationWrapOneLine = alpha * durationOneLine + (1.0 - alpha) * durationWrapOneLine;
+		if (durationWrapOneLine < minDurationOneLine) {
+			durationWrapOneLine = minDurationOneLine;
+		} else if (durationWrapOneLine > maxDurationOneLine) {
+			durationWrapOneLine = maxDurationOneLine;
+		}
+	}
+}
+
+namespace {
+
+// Lines laid out by one thread and how many sub-lines each wraps to.
+// The view, model and style are shared with the other threads so are only read.
+struct WrapRange {
+	EditView *view;
+	const EditModel *model;
+	const ViewStyle *vs;
+	Surface *surface;
+	int width;
+	int lineStart;
+	int lineEnd;
+	std::vector<int> subLines;
+	WrapRange() : view(0), model(0), vs(0), surface(0), width(0), lineStart(0), lineEnd(0) {
+	}
+};
+
+void WrapRangeLines(void *data) {
+	WrapRange *range = static_cast<WrapRange *>(data);
+	Document *pdoc = range->model->pdoc;
+	LineLayout ll(0);
+	for (int line = range->lineStart; line < range->lineEnd; line++) {
+		ll.Resize(pdoc->LineStart(line + 1) - pdoc->LineStart(line));
+		ll.Invalidate(LineLayout::llInvalid);
+		range->view->LayoutLine(*range->model, line, range->surface, *range->vs, &ll, range->width);
+		range->subLines[line - range->lineStart] = ll.lines;
+	}
+}
+
+}
+
+// Number of threads worth wrapping lines on, 1 when they should be wrapped on the main thread.
+int Editor::ThreadsForWrapping(int lines) const {
+	// Fewer lines than this don't pay for starting a thread
+	const int linesPerThreadMin = 0x100;
+	// Each thread has a font map of its own so don't use too many
+	const int threadsMax = 8;
+	return Platform::Clamp(std::min(Thread::Concurrency(), lines / linesPerThreadMin), 1, threadsMax);
+}
+
+// Lay out the lines on several threads, each measuring with a surface of its own, while
+// the document is not changing then set the heights of the lines on the main thread.
+// Return true if the height of any line changed.
+bool Editor::WrapLinesOnThreads(Surface *surface, int lineStart, int lineEnd, int threads) {
+	while (surfacesWrapThread.size() < static_cast<size_t>(threads)) {
+		Surface *surfaceThread = Surface::Allocate(technology);
+		surfaceThread->InitForThread(surface);
+		surfacesWrapThread.push_back(surfaceThread);
+	}
+
+	const int linesEachThread = (lineEnd - lineStart + threads - 1) / threads;
+	std::vector<WrapRange> ranges(threads);
+	for (int i = 0; i < threads; i++) {
+		WrapRange &range = ranges[i];
+		range.view = &view;
+		range.model = this;
+		range.vs = &vs;
+		range.surface = surfacesWrapThread[i];
+		range.surface->SetUnicodeMode(SC_CP_UTF8 == CodePage());
+		range.surface->SetDBCSMode(CodePage());
+		range.width = wrapWidth;
+		range.lineStart = std::min(lineStart + i * linesEachThread, lineEnd);
+		range.lineEnd = std::min(range.lineStart + linesEachThread, lineEnd);
+		range.subLines.resize(range.lineEnd - range.lineStart);
+	}
+
+	// The position cache is shared by all views so can not be used by the threads
+	view.posCache.SetEnabled(false);
+	std::vector<Thread *> workers;
+	for (int i = 1; i < threads; i++) {
+		workers.push_back(Thread::Start(WrapRangeLines, &ranges[i]));
+	}
+	// Wrap the first range here instead of just waiting
+	WrapRangeLines(&ranges[0]);
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i]->Join();
+		delete workers[i];
+	}
+	view.posCache.SetEnabled(true);
+
+	bool heightChanged = false;
+	for (int i = 0; i < threads; i++) {
+		const WrapRange &range = ranges[i];
+		for (int line = range.lineStart; line < range.lineEnd; line++) {
+			if (cs.SetHeight(line, range.subLines[line - range.lineStart] +
+				(vs.annotationVisible ? pdoc->AnnotationLines(line) : 0))) {
+				heightChanged = true;
+			}
+		}
+	}
+	return heightChanged;
+}
+
 // Perform  wrapping for a subset of the lines needing wrapping.
 // wsAll: wrap all lines which need wrapping in this single call
 // wsVisible: wrap currently visible lines
-// wsIdle: wrap one page + 100 lines
+// wsIdle: wrap as many lines as fit in an idle slice, at least one page + 100 lines
 // Return true if wrapping occurred.
 bool Editor::WrapLines(enum wrapScope ws) {
 	int goodTopLine = topLine;
@@ -1518,7 +1644,7 @@ bool Editor::WrapLines(enum wrapScope ws) {
 				return false;
 			}
 		} else if (ws == wsIdle) {
-			lineToWrapEnd = lineToWrap + LinesOnScreen() + 100;
+			lineToWrapEnd = lineToWrap + LinesToWrapInIdle();
 		}
 		const int lineEndNeedWrap = std::min(wrapPending.end, pdoc->LinesTotal());
 		lineToWrapEnd = std::min(lineToWrapEnd, lineEndNeedWrap);
@@ -1537,6 +1663,18 @@ bool Editor::WrapLines(enum wrapScope ws) {
 			if (surface) {
 //Platform::DebugPrintf("Wraplines: scope=%0d need=%0d..%0d perform=%0d..%0d\n", ws, wrapPending.start, wrapPending.end, lineToWrap, lineToWrapEnd);
 
+				const int lineWrapStart = lineToWrap;
+				ElapsedTime etWrapping;
+				const int threads = ThreadsForWrapping(lineToWrapEnd - lineToWrap);
+				if (threads > 1) {
+					if (WrapLinesOnThreads(surface, lineToWrap, lineToWrapEnd, threads)) {
+						wrapOccurred = true;
+					}
+					while (lineToWrap < lineToWrapEnd) {
+						wrapPending.Wrapped(lineToWrap);
+						lineToWrap++;
+					}
+				}
 				while (lineToWrap < lineToWrapEnd) {
 					if (WrapOneLine(surface, lineToWrap)) {
 						wrapOccurred = true;
@@ -1544,6 +1682,7 @@ bool Editor::WrapLines(enum wrapScope ws) {
 					wrapPending.Wrapped(lineToWrap);
 					lineToWrap++;
 				}
+				AdjustWrapDuration(lineToWrap - lineWrapStart, etWrapping.Duration());
 
 				goodTopLine = cs.DisplayFromDoc(lineDocTop) + std::min(subLineTop, cs.GetHeight(lineDocTop)-1);
 			}
@@ -4943,6 +5082,12 @@ void Editor::TickFor(TickReason reason) {
 			}
 			FineTickerCancel(tickDwell);
 			break;
+		case tickStyle:
+			if (!pdoc->PublishBackgroundStyles(0.01)) {
+				FineTickerCancel(tickStyle);
+				StartIdleStyling(false);
+			}
+			break;
 		default:
 			// tickPlatform handled by subclass
 			break;
@@ -5015,6 +5160,10 @@ int Editor::PositionAfterMaxStyling(int posMax, bool scrolling) const {
 		// Both states do not limit styling
 		return posMax;
 	}
+	if (pdoc->BackgroundStylingActive()) {
+		// Wait for the styles lexed on the other thread
+		return std::min(pdoc->GetEndStyled(), posMax);
+	}
 
 	// Try to keep time taken by styling reasonable so interaction remains smooth.
 	// When scrolling, allow less time to ensure responsive
@@ -5029,7 +5178,8 @@ int Editor::PositionAfterMaxStyling(int posMax, bool scrolling) const {
 }
 
 void Editor::StartIdleStyling(bool truncatedLastStyling) {
-	if ((idleStyling == SC_IDLESTYLING_ALL) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE)) {
+	if ((idleStyling == SC_IDLESTYLING_ALL) || (idleStyling == SC_IDLESTYLING_AFTERVISIBLE) ||
+		(idleStyling == SC_IDLESTYLING_BACKGROUND)) {
 		if (pdoc->GetEndStyled() < pdoc->Length()) {
 			// Style remainder of document in idle time
 			needIdleStyling = true;
@@ -5059,6 +5209,15 @@ void Editor::StyleAreaBounded(PRectangle rcArea, bool scrolling) {
 }
 
 void Editor::IdleStyling() {
+	if ((idleStyling == SC_IDLESTYLING_BACKGROUND) && FineTickerAvailable() &&
+		pdoc->StartBackgroundStyling()) {
+		// The rest of the document is lexed on another thread and published on tickStyle
+		if (!FineTickerRunning(tickStyle)) {
+			FineTickerStart(tickStyle, 20, 5);
+		}
+		needIdleStyling = false;
+		return;
+	}
 	const int posAfterArea = PositionAfterArea(GetClientRectangle());
 	const int endGoal = (idleStyling >= SC_IDLESTYLING_AFTERVISIBLE) ?
 		pdoc->Length() : posAfterArea;
@@ -6095,6 +6254,16 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETUNDOCOLLECTION:
 		return pdoc->IsCollectingUndo();
 
+	case SCI_SETUNDOMEMORYLIMIT:
+		pdoc->SetUndoMemoryLimit(static_cast<size_t>(wParam));
+		return 0;
+
+	case SCI_GETUNDOMEMORYLIMIT:
+		return static_cast<sptr_t>(pdoc->GetUndoMemoryLimit());
+
+	case SCI_GETUNDOMEMORYUSE:
+		return static_cast<sptr_t>(pdoc->UndoMemoryUse());
+
 	case SCI_BEGINUNDOACTION:
 		pdoc->BeginUndoAction();
 		return 0;
@@ -6346,6 +6515,8 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 		return pdoc->GetLineEndTypesActive();
 
 	case SCI_STARTSTYLING:
+		// Styles set by the container are not from the state in the checkpoints
+		pdoc->ClearCheckpoints();
 		pdoc->StartStyling(static_cast<int>(wParam), static_cast<char>(lParam));
 		break;
 
@@ -6556,6 +6727,12 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETPOSITIONCACHE:
 		return view.posCache.GetSize();
 
+	case SCI_GETPOSITIONCACHEHITS:
+		return PositionCache::Hits();
+
+	case SCI_GETPOSITIONCACHEMISSES:
+		return PositionCache::Misses();
+
 	case SCI_SETSCROLLWIDTH:
 		PLATFORM_ASSERT(wParam > 0);
 		if ((wParam > 0) && (wParam != static_cast<unsigned int >(scrollWidth))) {
@@ -256,6 +256,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	// Wrapping support
 	WrapPending wrapPending;
+	double durationWrapOneLine;
+	std::vector<Surface *> surfacesWrapThread;
 
 	bool convertPastes;
 
@@ -372,6 +374,10 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void NeedWrapping(int docLineStart=0, int docLineEnd=WrapPending::lineLarge);
 	bool WrapOneLine(Surface *surface, int lineToWrap);
 	enum wrapScope {wsAll, wsVisible, wsIdle};
+	int LinesToWrapInIdle() const;
+	void AdjustWrapDuration(int linesWrapped, double durationWrapping);
+	int ThreadsForWrapping(int lines) const;
+	bool WrapLinesOnThreads(Surface *surface, int lineStart, int lineEnd, int threads);
 	bool WrapLines(enum wrapScope ws);
 	void LinesJoin();
 	void LinesSplit(int pixelWidth);
@@ -513,7 +519,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void Tick();
 	bool Idle();
 	virtual void SetTicking(bool on);
-	enum TickReason { tickCaret, tickScroll, tickWiden, tickDwell, tickPlatform };
+	enum TickReason { tickCaret, tickScroll, tickWiden, tickDwell, tickStyle, tickPlatform };
 	virtual void TickFor(TickReason reason);
 	virtual bool FineTickerAvailable();
 	virtual bool FineTickerRunning(TickReason reason);
@@ -8,6 +8,7 @@
 #include <string.h>
 
 #include <stdexcept>
+#include <string>
 #include <vector>
 #include <algorithm>
 
@@ -488,6 +489,86 @@ int LineAnnotation::Lines(int line) const {
 		return 0;
 }
 
+LineCheckpoints::~LineCheckpoints() {
+	Init();
+}
+
+void LineCheckpoints::Init() {
+	for (int line = 0; line < checkpoints.Length(); line++) {
+		delete checkpoints[line];
+	}
+	checkpoints.DeleteAll();
+}
+
+void LineCheckpoints::InsertLine(int line) {
+	if (checkpoints.Length()) {
+		checkpoints.EnsureLength(line);
+		checkpoints.Insert(line, 0);
+	}
+}
+
+void LineCheckpoints::RemoveLine(int line) {
+	if (checkpoints.Length() > line) {
+		delete checkpoints[line];
+		checkpoints.Delete(line);
+	}
+}
+
+StyleCheckpoint *LineCheckpoints::At(int line) const {
+	if ((line >= 0) && (line < checkpoints.Length()))
+		return checkpoints[line];
+	return 0;
+}
+
+void LineCheckpoints::Set(int line, const StyleCheckpoint &checkpoint) {
+	checkpoints.EnsureLength(line + 1);
+	if (checkpoints[line])
+		*checkpoints[line] = checkpoint;
+	else
+		checkpoints[line] = new StyleCheckpoint(checkpoint);
+}
+
+void LineCheckpoints::Remove(int line) {
+	if ((line >= 0) && (line < checkpoints.Length())) {
+		delete checkpoints[line];
+		checkpoints[line] = 0;
+	}
+}
+
+void LineCheckpoints::RemoveRange(int lineStart, int lineEnd) {
+	lineEnd = std::min(lineEnd, static_cast<int>(checkpoints.Length()));
+	for (int line = std::max(lineStart, 0); line < lineEnd; line++) {
+		delete checkpoints[line];
+		checkpoints[line] = 0;
+	}
+}
+
+// The line of the last checkpoint at or before line or -1 if there is none
+int LineCheckpoints::Before(int line) const {
+	for (line = std::min(line, static_cast<int>(checkpoints.Length()) - 1); line >= 0; line--) {
+		if (checkpoints[line])
+			return line;
+	}
+	return -1;
+}
+
+// The line of the first checkpoint after line and no later than lineLimit or -1 if there is none
+int LineCheckpoints::After(int line, int lineLimit) const {
+	lineLimit = std::min(lineLimit, static_cast<int>(checkpoints.Length()) - 1);
+	for (line = std::max(line + 1, 0); line <= lineLimit; line++) {
+		if (checkpoints[line])
+			return line;
+	}
+	return -1;
+}
+
+// Text was modified on line so the styles after the checkpoint before it may change
+void LineCheckpoints::Modified(int line) {
+	StyleCheckpoint *checkpoint = At(Before(line));
+	if (checkpoint)
+		checkpoint->intact = false;
+}
+
 LineTabstops::~LineTabstops() {
 	Init();
 }
@@ -112,6 +112,46 @@ public:
 	int Lines(int line) const;
 };
 
+/**
+ * The state of the lexer at the start of a line as saved by it together with the
+ * values of the document it continues from.
+ */
+struct StyleCheckpoint {
+	std::string lexerState;
+	int styleBefore;
+	int levelBefore;
+	int lineStateBefore;
+	bool intact;	///< The styles up to the next checkpoint were lexed from this state and not modified since
+	StyleCheckpoint() : styleBefore(0), levelBefore(SC_FOLDLEVELBASE), lineStateBefore(0), intact(false) {
+	}
+	bool SameState(const StyleCheckpoint &other) const {
+		return (styleBefore == other.styleBefore) && (levelBefore == other.levelBefore) &&
+			(lineStateBefore == other.lineStateBefore) && (lexerState == other.lexerState);
+	}
+};
+
+class LineCheckpoints : public PerLine {
+	SplitVector<StyleCheckpoint *> checkpoints;
+public:
+	/// Lines lexed between checkpoints
+	enum { spacing = 100 };
+
+	LineCheckpoints() {
+	}
+	virtual ~LineCheckpoints();
+	virtual void Init();
+	virtual void InsertLine(int line);
+	virtual void RemoveLine(int line);
+
+	StyleCheckpoint *At(int line) const;
+	void Set(int line, const StyleCheckpoint &checkpoint);
+	void Remove(int line);
+	void RemoveRange(int lineStart, int lineEnd);
+	int Before(int line) const;
+	int After(int line, int lineLimit) const;
+	void Modified(int line);
+};
+
 typedef std::vector<int> TabstopList;
 
 class LineTabstops : public PerLine {
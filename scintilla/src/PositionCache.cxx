@@ -554,121 +554,183 @@ bool BreakFinder::More() const {
 	return (subBreak >= 0) || (nextBreak < lineRange.end);
 }
 
-PositionCacheEntry::PositionCacheEntry() :
-	styleNumber(0), len(0), clock(0), positions(0) {
-}
-
-void PositionCacheEntry::Set(unsigned int styleNumber_, const char *s_,
-	unsigned int len_, XYPOSITION *positions_, unsigned int clock_) {
-	Clear();
-	styleNumber = styleNumber_;
-	len = len_;
-	clock = clock_;
-	if (s_ && positions_) {
-		positions = new XYPOSITION[len + (len / 4) + 1];
-		for (unsigned int i=0; i<len; i++) {
-			positions[i] = positions_[i];
+namespace {
+
+// Holds the measurements of all views. The entries live in pools allocated once
+// for the capacity and are grouped into sets of a few ways, evicting the least
+// recently used entry of a set. Only used from the thread running the views.
+class SharedPositionCache {
+	enum { ways = 4, capacityDefault = 0x2000, capacityMax = 0x10000 };
+	struct Entry {
+		unsigned int hash;
+		unsigned int fontKey;
+		int codePage;
+		unsigned int len;
+		unsigned int clock;
+		bool valid;
+	};
+	std::vector<Entry> entries;
+	std::vector<XYPOSITION> positionsPool;
+	std::vector<char> textPool;
+	// The sizes requested by the views and how many views requested each
+	std::map<size_t, int> sizesRequested;
+	size_t capacity;
+	unsigned int clock;
+	unsigned long hits;
+	unsigned long misses;
+
+	static unsigned int Hash(unsigned int fontKey, int codePage, const char *s, unsigned int len) {
+		unsigned int h = (fontKey * 0x9E3779B1U) ^ (static_cast<unsigned int>(codePage) << 8) ^ len;
+		unsigned int i = 0;
+		for (; i + 4 <= len; i += 4) {
+			unsigned int word;
+			memcpy(&word, s + i, 4);
+			h = (h ^ word) * 0x5BD1E995U;
+			h ^= h >> 15;
+		}
+		if (i < len) {
+			unsigned int word = 0;
+			memcpy(&word, s + i, len - i);
+			h = (h ^ word) * 0x5BD1E995U;
+		}
+		h ^= h >> 13;
+		h *= 0x5BD1E995U;
+		h ^= h >> 15;
+		return h;
+	}
+	void Allocate() {
+		Entry entryEmpty = {0, 0, 0, 0, 0, false};
+		// Swap with new vectors so that shrinking releases the memory
+		std::vector<Entry>(capacity, entryEmpty).swap(entries);
+		std::vector<XYPOSITION>(capacity * lengthMax, 0).swap(positionsPool);
+		std::vector<char>(capacity * lengthMax, '\0').swap(textPool);
+		clock = 0;
+	}
+	bool Valid(const Entry &entry) const {
+		return entry.valid;
+	}
+public:
+	// Longer text is rarely repeated and would only churn the cache
+	enum { lengthMax = 30 };
+
+	SharedPositionCache() : capacity(capacityDefault), clock(0), hits(0), misses(0) {
+	}
+	// Replaces the size a view requested, 0 for none. The capacity follows the largest
+	// size requested, but is never less than the default as all views share it.
+	void Request(size_t sizeOld, size_t sizeNew) {
+		if (sizeOld == sizeNew)
+			return;
+		if (sizeOld > 0) {
+			std::map<size_t, int>::iterator it = sizesRequested.find(sizeOld);
+			if ((it != sizesRequested.end()) && (--it->second == 0))
+				sizesRequested.erase(it);
+		}
+		if (sizeNew > 0)
+			sizesRequested[sizeNew]++;
+
+		const size_t sizeMax = sizesRequested.empty() ? 0 : sizesRequested.rbegin()->first;
+		size_t capacityNew = capacityDefault;
+		while ((capacityNew < sizeMax) && (capacityNew < capacityMax))
+			capacityNew *= 2;
+		if (capacityNew != capacity) {
+			capacity = capacityNew;
+			if (!entries.empty())
+				Allocate();
 		}
-		memcpy(reinterpret_cast<char *>(reinterpret_cast<void *>(positions + len)), s_, len);
 	}
-}
-
-PositionCacheEntry::~PositionCacheEntry() {
-	Clear();
-}
-
-void PositionCacheEntry::Clear() {
-	delete []positions;
-	positions = 0;
-	styleNumber = 0;
-	len = 0;
-	clock = 0;
-}
-
-bool PositionCacheEntry::Retrieve(unsigned int styleNumber_, const char *s_,
-	unsigned int len_, XYPOSITION *positions_) const {
-	if ((styleNumber == styleNumber_) && (len == len_) &&
-		(memcmp(reinterpret_cast<char *>(reinterpret_cast<void *>(positions + len)), s_, len)== 0)) {
-		for (unsigned int i=0; i<len; i++) {
-			positions_[i] = positions[i];
+	// Copies the cached positions when found, otherwise returns the entry to
+	// be replaced with the measurement in slot.
+	bool Retrieve(unsigned int fontKey, int codePage, const char *s, unsigned int len,
+		XYPOSITION *positions, size_t &slot) {
+		if (entries.empty())
+			Allocate();
+		const unsigned int hash = Hash(fontKey, codePage, s, len);
+		const size_t setStart = (hash & (capacity / ways - 1)) * ways;
+		slot = setStart;
+		for (size_t way = setStart; way < setStart + ways; way++) {
+			Entry &entry = entries[way];
+			if (Valid(entry) && (entry.hash == hash) && (entry.fontKey == fontKey) &&
+				(entry.codePage == codePage) && (entry.len == len) &&
+				(memcmp(&textPool[way * lengthMax], s, len) == 0)) {
+				std::copy(positionsPool.begin() + way * lengthMax,
+					positionsPool.begin() + way * lengthMax + len, positions);
+				entry.clock = ++clock;
+				hits++;
+				return true;
+			}
+			if (!Valid(entry)) {
+				if (Valid(entries[slot]))
+					slot = way;
+			} else if (Valid(entries[slot]) && (entry.clock < entries[slot].clock)) {
+				slot = way;
+			}
 		}
-		return true;
-	} else {
+		misses++;
 		return false;
 	}
-}
-
-unsigned int PositionCacheEntry::Hash(unsigned int styleNumber_, const char *s, unsigned int len_) {
-	unsigned int ret = s[0] << 7;
-	for (unsigned int i=0; i<len_; i++) {
-		ret *= 1000003;
-		ret ^= s[i];
+	void Store(size_t slot, unsigned int fontKey, int codePage, const char *s, unsigned int len,
+		const XYPOSITION *positions) {
+		clock++;
+		if (clock == 0) {
+			// Wrapped around so restart the recency of all entries
+			for (size_t i = 0; i < entries.size(); i++)
+				entries[i].clock = 0;
+			clock = 1;
+		}
+		Entry &entry = entries[slot];
+		entry.hash = Hash(fontKey, codePage, s, len);
+		entry.fontKey = fontKey;
+		entry.codePage = codePage;
+		entry.len = len;
+		entry.clock = clock;
+		entry.valid = true;
+		memcpy(&textPool[slot * lengthMax], s, len);
+		std::copy(positions, positions + len, positionsPool.begin() + slot * lengthMax);
 	}
-	ret *= 1000003;
-	ret ^= len_;
-	ret *= 1000003;
-	ret ^= styleNumber_;
-	return ret;
-}
+	unsigned long Hits() const {
+		return hits;
+	}
+	unsigned long Misses() const {
+		return misses;
+	}
+};
 
-bool PositionCacheEntry::NewerThan(const PositionCacheEntry &other) const {
-	return clock > other.clock;
+SharedPositionCache &Shared() {
+	// Never destroyed as views may still be destroyed while exiting
+	static SharedPositionCache *cache = new SharedPositionCache();
+	return *cache;
 }
 
-void PositionCacheEntry::ResetClock() {
-	if (clock > 0) {
-		clock = 1;
-	}
 }
 
-PositionCache::PositionCache() {
-	clock = 1;
-	pces.resize(0x400);
-	allClear = true;
+PositionCache::PositionCache() : size(0x400), enabled(true) {
+	Shared().Request(0, size);
 }
 
 PositionCache::~PositionCache() {
-	Clear();
-}
-
-void PositionCache::Clear() {
-	if (!allClear) {
-		for (size_t i=0; i<pces.size(); i++) {
-			pces[i].Clear();
-		}
-	}
-	clock = 1;
-	allClear = true;
+	Shared().Request(size, 0);
 }
 
+// A size of 0 turns caching off for the view. The shared store grows and shrinks
+// with the largest size of the views, see SharedPositionCache::Request().
+// Entries are not dropped when styles change since a font realised differently
+// gets another key.
 void PositionCache::SetSize(size_t size_) {
-	Clear();
-	pces.resize(size_);
+	Shared().Request(size, size_);
+	size = size_;
 }
 
 void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 	const char *s, unsigned int len, XYPOSITION *positions, Document *pdoc) {
 
-	allClear = false;
-	size_t probe = pces.size();	// Out of bounds
-	if ((!pces.empty()) && (len < 30)) {
-		// Only store short strings in the cache so it doesn't churn with
-		// long comments with only a single comment.
-
-		// Two way associative: try two probe positions.
-		unsigned int hashValue = PositionCacheEntry::Hash(styleNumber, s, len);
-		probe = hashValue % pces.size();
-		if (pces[probe].Retrieve(styleNumber, s, len, positions)) {
+	const unsigned int fontKey = vstyle.styles[styleNumber].cacheKey;
+	const bool cacheable = enabled && (size > 0) && (fontKey != 0) && (len > 0) &&
+		(len < static_cast<unsigned int>(SharedPositionCache::lengthMax));
+	size_t slot = 0;
+	if (cacheable) {
+		if (Shared().Retrieve(fontKey, pdoc->dbcsCodePage, s, len, positions, slot)) {
 			return;
 		}
-		unsigned int probe2 = (hashValue * 37) % pces.size();
-		if (pces[probe2].Retrieve(styleNumber, s, len, positions)) {
-			return;
-		}
-		// Not found. Choose the oldest of the two slots to replace
-		if (pces[probe].NewerThan(pces[probe2])) {
-			probe = probe2;
-		}
 	}
 	if (len > BreakFinder::lengthStartSubdivision) {
 		// Break up into segments
@@ -688,17 +750,15 @@ void PositionCache::MeasureWidths(Surface *surface, const ViewStyle &vstyle, uns
 		FontAlias fontStyle = vstyle.styles[styleNumber].font;
 		surface->MeasureWidths(fontStyle, s, len, positions);
 	}
-	if (probe < pces.size()) {
-		// Store into cache
-		clock++;
-		if (clock > 60000) {
-			// Since there are only 16 bits for the clock, wrap it round and
-			// reset all cache entries so none get stuck with a high clock.
-			for (size_t i=0; i<pces.size(); i++) {
-				pces[i].ResetClock();
-			}
-			clock = 2;
-		}
-		pces[probe].Set(styleNumber, s, len, positions, clock);
+	if (cacheable) {
+		Shared().Store(slot, fontKey, pdoc->dbcsCodePage, s, len, positions);
 	}
 }
+
+unsigned long PositionCache::Hits() {
+	return Shared().Hits();
+}
+
+unsigned long PositionCache::Misses() {
+	return Shared().Misses();
+}
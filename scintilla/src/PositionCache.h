@@ -96,22 +96,6 @@ public:
 	void Dispose(LineLayout *ll);
 };
 
-class PositionCacheEntry {
-	unsigned int styleNumber:8;
-	unsigned int len:8;
-	unsigned int clock:16;
-	XYPOSITION *positions;
-public:
-	PositionCacheEntry();
-	~PositionCacheEntry();
-	void Set(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_, unsigned int clock_);
-	void Clear();
-	bool Retrieve(unsigned int styleNumber_, const char *s_, unsigned int len_, XYPOSITION *positions_) const;
-	static unsigned int Hash(unsigned int styleNumber_, const char *s, unsigned int len);
-	bool NewerThan(const PositionCacheEntry &other) const;
-	void ResetClock();
-};
-
 class Representation {
 public:
 	std::string stringRep;
@@ -174,20 +158,26 @@ public:
 	bool More() const;
 };
 
+/**
+ * Measurements of short pieces of text. The entries are kept in a store shared by
+ * all views which is keyed by font, code page and text, so views using the same
+ * fonts do not measure the same text again.
+ */
 class PositionCache {
-	std::vector<PositionCacheEntry> pces;
-	unsigned int clock;
-	bool allClear;
+	size_t size;
+	bool enabled;
 	// Private so PositionCache objects can not be copied
 	PositionCache(const PositionCache &);
 public:
 	PositionCache();
 	~PositionCache();
-	void Clear();
 	void SetSize(size_t size_);
-	size_t GetSize() const { return pces.size(); }
+	size_t GetSize() const { return size; }
+	void SetEnabled(bool enabled_) { enabled = enabled_; }
 	void MeasureWidths(Surface *surface, const ViewStyle &vstyle, unsigned int styleNumber,
 		const char *s, unsigned int len, XYPOSITION *positions, Document *pdoc);
+	static unsigned long Hits();
+	static unsigned long Misses();
 };
 
 inline bool IsSpaceOrTab(int ch) {
@@ -521,6 +521,11 @@ class LexState : public LexInterface {
 	void SetLexerModule(const LexerModule *lex);
 	PropSetSimple props;
 	int interfaceVersion;
+	// What the instance has been told so NewInstance can tell it to another one
+	std::map<std::string, std::string> propertiesSet;
+	std::map<int, std::string> wordListsSet;
+	std::vector<std::pair<int, int> > subStylesAllocated;
+	std::vector<std::pair<int, std::string> > identifiersSet;
 public:
 	int lexLanguage;
 
@@ -550,6 +555,7 @@ public:
 	void SetIdentifiers(int style, const char *identifiers);
 	int DistanceToSecondaryStyles();
 	const char *GetSubStyleBases();
+	virtual ILexer *NewInstance();
 };
 
 #ifdef SCI_NAMESPACE
@@ -579,6 +585,11 @@ LexState *ScintillaBase::DocumentLexState() {
 
 void LexState::SetLexerModule(const LexerModule *lex) {
 	if (lex != lexCurrent) {
+		pdoc->CancelBackgroundStyling();
+		propertiesSet.clear();
+		wordListsSet.clear();
+		subStylesAllocated.clear();
+		identifiersSet.clear();
 		if (instance) {
 			instance->Release();
 			instance = 0;
@@ -589,6 +600,7 @@ void LexState::SetLexerModule(const LexerModule *lex) {
 			instance = lexCurrent->Create();
 			interfaceVersion = instance->Version();
 		}
+		pdoc->ClearCheckpoints();
 		pdoc->LexerChanged();
 	}
 }
@@ -624,8 +636,11 @@ const char *LexState::DescribeWordListSets() {
 
 void LexState::SetWordList(int n, const char *wl) {
 	if (instance) {
+		pdoc->CancelBackgroundStyling();
+		wordListsSet[n] = wl ? wl : "";
 		int firstModification = instance->WordListSet(n, wl);
 		if (firstModification >= 0) {
+			pdoc->ClearCheckpoints();
 			pdoc->ModifiedAt(firstModification);
 		}
 	}
@@ -670,8 +685,11 @@ const char *LexState::DescribeProperty(const char *name) {
 void LexState::PropSet(const char *key, const char *val) {
 	props.Set(key, val);
 	if (instance) {
+		pdoc->CancelBackgroundStyling();
+		propertiesSet[key] = val ? val : "";
 		int firstModification = instance->PropertySet(key, val);
 		if (firstModification >= 0) {
+			pdoc->ClearCheckpoints();
 			pdoc->ModifiedAt(firstModification);
 		}
 	}
@@ -698,6 +716,8 @@ int LexState::LineEndTypesSupported() {
 
 int LexState::AllocateSubStyles(int styleBase, int numberStyles) {
 	if (instance && (interfaceVersion >= lvSubStyles)) {
+		pdoc->CancelBackgroundStyling();
+		subStylesAllocated.push_back(std::pair<int, int>(styleBase, numberStyles));
 		return static_cast<ILexerWithSubStyles *>(instance)->AllocateSubStyles(styleBase, numberStyles);
 	}
 	return -1;
@@ -733,13 +753,20 @@ int LexState::PrimaryStyleFromStyle(int style) {
 
 void LexState::FreeSubStyles() {
 	if (instance && (interfaceVersion >= lvSubStyles)) {
+		pdoc->CancelBackgroundStyling();
+		subStylesAllocated.clear();
+		identifiersSet.clear();
 		static_cast<ILexerWithSubStyles *>(instance)->FreeSubStyles();
+		pdoc->ClearCheckpoints();
 	}
 }
 
 void LexState::SetIdentifiers(int style, const char *identifiers) {
 	if (instance && (interfaceVersion >= lvSubStyles)) {
+		pdoc->CancelBackgroundStyling();
+		identifiersSet.push_back(std::pair<int, std::string>(style, identifiers ? identifiers : ""));
 		static_cast<ILexerWithSubStyles *>(instance)->SetIdentifiers(style, identifiers);
+		pdoc->ClearCheckpoints();
 		pdoc->ModifiedAt(0);
 	}
 }
@@ -758,6 +785,28 @@ const char *LexState::GetSubStyleBases() {
 	return "";
 }
 
+ILexer *LexState::NewInstance() {
+	if (!instance || !lexCurrent)
+		return 0;
+	ILexer *instanceNew = lexCurrent->Create();
+	for (std::map<std::string, std::string>::const_iterator it = propertiesSet.begin(); it != propertiesSet.end(); ++it) {
+		instanceNew->PropertySet(it->first.c_str(), it->second.c_str());
+	}
+	for (std::map<int, std::string>::const_iterator it = wordListsSet.begin(); it != wordListsSet.end(); ++it) {
+		instanceNew->WordListSet(it->first, it->second.c_str());
+	}
+	if (interfaceVersion >= lvSubStyles) {
+		ILexerWithSubStyles *ssinstance = static_cast<ILexerWithSubStyles *>(instanceNew);
+		for (std::vector<std::pair<int, int> >::const_iterator it = subStylesAllocated.begin(); it != subStylesAllocated.end(); ++it) {
+			ssinstance->AllocateSubStyles(it->first, it->second);
+		}
+		for (std::vector<std::pair<int, std::string> >::const_iterator it = identifiersSet.begin(); it != identifiersSet.end(); ++it) {
+			ssinstance->SetIdentifiers(it->first, it->second.c_str());
+		}
+	}
+	return instanceNew;
+}
+
 #endif
 
 void ScintillaBase::NotifyStyleToNeeded(int endStyleNeeded) {
@@ -73,6 +73,7 @@ void FontMeasurements::Clear() {
 	aveCharWidth = 1;
 	spaceWidth = 1;
 	sizeZoomed = 2;
+	cacheKey = 0;
 }
 
 Style::Style() : FontSpecification() {
@@ -49,6 +49,7 @@ struct FontMeasurements {
 	XYPOSITION aveCharWidth;
 	XYPOSITION spaceWidth;
 	int sizeZoomed;
+	unsigned int cacheKey;	// Same for fonts realised with the same parameters, 0 if not realised
 	FontMeasurements();
 	void Clear();
 };
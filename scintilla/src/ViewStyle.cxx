@@ -5,10 +5,12 @@
 // Copyright 1998-2003 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <stdio.h>
 #include <string.h>
 #include <assert.h>
 
 #include <stdexcept>
+#include <string>
 #include <vector>
 #include <map>
 
@@ -64,6 +66,22 @@ const char *FontNames::Save(const char *name) {
 	return nameSave;
 }
 
+// Fonts realised with the same parameters measure text the same way in every view
+// so they get the same key for the position cache which is shared between views.
+static unsigned int CacheKeyFromParameters(const FontParameters &fp) {
+	static std::map<std::string, unsigned int> keys;
+	char parameters[100];
+	sprintf(parameters, "%.4f|%d|%d|%d|%d|%d|", fp.size, fp.weight, fp.italic ? 1 : 0,
+		fp.extraFontFlag, fp.technology, fp.characterSet);
+	const std::string description = std::string(parameters) + fp.faceName;
+	std::map<std::string, unsigned int>::const_iterator it = keys.find(description);
+	if (it != keys.end())
+		return it->second;
+	const unsigned int key = static_cast<unsigned int>(keys.size()) + 1;
+	keys[description] = key;
+	return key;
+}
+
 FontRealised::FontRealised() {
 }
 
@@ -80,6 +98,7 @@ void FontRealised::Realise(Surface &surface, int zoomLevel, int technology, cons
 	float deviceHeight = static_cast<float>(surface.DeviceHeightFont(sizeZoomed));
 	FontParameters fp(fs.fontName, deviceHeight / SC_FONT_SIZE_MULTIPLIER, fs.weight, fs.italic, fs.extraFontFlag, technology, fs.characterSet);
 	font.Create(fp);
+	cacheKey = CacheKeyFromParameters(fp);
 
 	ascent = static_cast<unsigned int>(surface.Ascent(font));
 	descent = static_cast<unsigned int>(surface.Descent(font));
@@ -65,12 +65,25 @@
 
 /* Number of editor indicators to draw - limited as this can affect performance */
 #define GEANY_BUILD_ERR_HIGHLIGHT_MAX 50
+/* Time in microseconds spent showing build output per main loop iteration */
+#define GEANY_BUILD_OUTPUT_SLICE 10000
 
 
 GeanyBuildInfo build_info = {GEANY_GBG_FT, 0, 0, NULL, GEANY_FILETYPES_NONE, NULL, 0};
 
 static gchar *current_dir_entered = NULL;
 
+/* Build output waiting to be shown, see show_build_output_idle() */
+static struct
+{
+	GString *lines;		/* each line as its colour, the text and a nul */
+	gsize shown;		/* offset of the first line not shown yet */
+	guint source_id;
+	gboolean exited;	/* the build exited and its result is shown after the output */
+	gint exit_status;
+}
+build_output;
+
 typedef struct RunInfo
 {
 	GPid pid;
@@ -125,11 +138,17 @@ static void on_build_previous_error(GtkWidget *menuitem, gpointer user_data);
 static void kill_process(GPid *pid);
 static void show_build_result_message(gboolean failure);
 static void process_build_output_line(gchar *msg, gint color);
+static void reset_build_output(void);
 static void show_build_commands_dialog(void);
 static void on_build_menu_item(GtkWidget *w, gpointer user_data);
 
 void build_finalize(void)
 {
+	if (build_output.source_id != 0)
+		g_source_remove(build_output.source_id);
+	if (build_output.lines != NULL)
+		g_string_free(build_output.lines, TRUE);
+
 	g_free(build_info.dir);
 	g_free(build_info.custom_target);
 
@@ -739,13 +758,14 @@ static void build_spawn_cmd(GeanyDocument *doc, const gchar *cmd, const gchar *d
 		return;
 	}
 
+	reset_build_output();
 	clear_all_errors();
 	SETPTR(current_dir_entered, NULL);
 
 	utf8_working_dir = !EMPTY(dir) ? g_strdup(dir) : g_path_get_dirname(doc->file_name);
 	working_dir = utils_get_locale_from_utf8(utf8_working_dir);
 
-	gtk_list_store_clear(msgwindow.store_compiler);
+	msgwin_compiler_clear();
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_COMPILER);
 	msgwin_compiler_add(COLOR_BLUE, _("%s (in directory: %s)"), cmd, utf8_working_dir);
 	g_free(utf8_working_dir);
@@ -765,7 +785,7 @@ static void build_spawn_cmd(GeanyDocument *doc, const gchar *cmd, const gchar *d
 	build_info.file_type_id = (doc == NULL) ? GEANY_FILETYPES_NONE : doc->file_type->id;
 	build_info.message_count = 0;
 
-	if (!spawn_with_callbacks(working_dir, cmd, argv, NULL, 0, NULL, NULL, build_iofunc,
+	if (!spawn_with_callbacks(working_dir, cmd, argv, NULL, SPAWN_LINE_BATCHES, NULL, NULL, build_iofunc,
 		GINT_TO_POINTER(0), 0, build_iofunc, GINT_TO_POINTER(1), 0, build_exit_cb, NULL,
 		&build_info.pid, &error))
 	{
@@ -921,8 +941,6 @@ static void build_run_cmd(GeanyDocument *doc, guint cmdindex)
 static void process_build_output_line(gchar *msg, gint color)
 {
 	gchar *tmp;
-	gchar *filename;
-	gint line;
 
 	g_strchomp(msg);
 
@@ -933,35 +951,149 @@ static void process_build_output_line(gchar *msg, gint color)
 	{
 		SETPTR(current_dir_entered, tmp);
 	}
-	msgwin_parse_compiler_error_line(msg, current_dir_entered, &filename, &line);
+	/* the line is only parsed for errors when it is displayed or for set_error_indicators() */
+	msgwin_compiler_add_output(color, msg, current_dir_entered);
+}
 
-	if (line != -1 && filename != NULL)
+
+/* Marks the errors of the build output shown so far in the open documents, until
+ * end_time or until GEANY_BUILD_ERR_HIGHLIGHT_MAX errors have been found.
+ * Returns TRUE if there are more lines to check. */
+static gboolean set_error_indicators(gint64 end_time)
+{
+	gchar *filename;
+	gint line;
+	guint count = 0;
+
+	while (editor_prefs.use_indicators &&
+		build_info.message_count < GEANY_BUILD_ERR_HIGHLIGHT_MAX)
 	{
-		GeanyDocument *doc = document_find_by_filename(filename);
+		if (! msgwin_compiler_parse_next(&filename, &line))
+			return FALSE;
 
-		/* limit number of indicators */
-		if (doc && editor_prefs.use_indicators &&
-			build_info.message_count < GEANY_BUILD_ERR_HIGHLIGHT_MAX)
+		if (filename != NULL)
 		{
-			if (line > 0) /* some compilers, like pdflatex report errors on line 0 */
-				line--;   /* so only adjust the line number if it is greater than 0 */
-			editor_indicator_set_on_line(doc->editor, GEANY_INDICATOR_ERROR, line);
+			GeanyDocument *doc = document_find_by_filename(filename);
+
+			if (doc)
+			{
+				if (line > 0) /* some compilers, like pdflatex report errors on line 0 */
+					line--;   /* so only adjust the line number if it is greater than 0 */
+				editor_indicator_set_on_line(doc->editor, GEANY_INDICATOR_ERROR, line);
+			}
+			build_info.message_count++;
+			g_free(filename);
 		}
-		build_info.message_count++;
-		color = COLOR_RED;	/* error message parsed on the line */
+
+		if (++count % 64 == 0 && g_get_monotonic_time() >= end_time)
+			return TRUE;
 	}
-	g_free(filename);
+	return FALSE;
+}
+
+
+static void show_build_result(gint status);
+
+
+/* Shows the build output received so far, as many lines as fit in a time slice at once,
+ * so that the UI stays responsive for builds printing many lines. */
+static gboolean show_build_output_idle(gpointer data)
+{
+	const gint64 end_time = g_get_monotonic_time() + GEANY_BUILD_OUTPUT_SLICE;
+	GString *lines = build_output.lines;
+	guint count = 0;
+
+	msgwin_compiler_begin_batch();
+	while (build_output.shown < lines->len)
+	{
+		gchar *line = lines->str + build_output.shown;
+
+		build_output.shown += strlen(line + 1) + 2;
+		process_build_output_line(line + 1, line[0]);
+
+		/* checking the time is cheap but not free */
+		if (++count % 64 == 0 && g_get_monotonic_time() >= end_time)
+			break;
+	}
+	msgwin_compiler_end_batch();
 
-	msgwin_compiler_add_string(color, msg);
+	if (build_output.shown < lines->len)
+	{
+		/* drop what is shown once it is the bigger part, so this stays linear */
+		if (build_output.shown > lines->len / 2)
+		{
+			g_string_erase(lines, 0, build_output.shown);
+			build_output.shown = 0;
+		}
+		return TRUE;
+	}
+
+	g_string_truncate(lines, 0);
+	build_output.shown = 0;
+	if (build_output.exited)
+	{
+		build_output.exited = FALSE;
+		show_build_result(build_output.exit_status);
+	}
+
+	/* the error indicators are less urgent than the output */
+	if (set_error_indicators(end_time))
+		return TRUE;
+
+	build_output.source_id = 0;
+	return FALSE;
+}
+
+
+/* Drops the output of a previous build not shown yet */
+static void reset_build_output(void)
+{
+	if (build_output.source_id != 0)
+	{
+		g_source_remove(build_output.source_id);
+		build_output.source_id = 0;
+	}
+	if (build_output.lines != NULL)
+		g_string_truncate(build_output.lines, 0);
+	build_output.shown = 0;
+	if (build_output.exited)
+	{
+		build_output.exited = FALSE;
+		show_build_result(build_output.exit_status);
+	}
 }
 
 
+/* Queues the lines received to be shown in idle time */
 static void build_iofunc(GString *string, GIOCondition condition, gpointer data)
 {
 	if (condition & (G_IO_IN | G_IO_PRI))
 	{
-		process_build_output_line(string->str,
-			(GPOINTER_TO_INT(data)) ? COLOR_DARK_RED : COLOR_BLACK);
+		const gchar color = (GPOINTER_TO_INT(data)) ? COLOR_DARK_RED : COLOR_BLACK;
+		const gchar *line = string->str;
+		const gchar *end = string->str + string->len;
+
+		if (build_output.lines == NULL)
+			build_output.lines = g_string_sized_new(65536);
+
+		while (line < end)
+		{
+			const gchar *eol = line;
+
+			while (eol < end && *eol != '\n' && *eol != '\r' && *eol != '\0')
+				eol++;
+
+			g_string_append_c(build_output.lines, color);
+			g_string_append_len(build_output.lines, line, eol - line);
+			g_string_append_c(build_output.lines, '\0');
+
+			if (eol + 1 < end && eol[0] == '\r' && eol[1] == '\n')
+				eol++;
+			line = eol + 1;
+		}
+
+		if (build_output.source_id == 0)
+			build_output.source_id = g_idle_add(show_build_output_idle, NULL);
 	}
 }
 
@@ -1038,12 +1170,24 @@ static void show_build_result_message(gboolean failure)
 
 static void build_exit_cb(GPid child_pid, gint status, gpointer user_data)
 {
-	show_build_result_message(!SPAWN_WIFEXITED(status) || SPAWN_WEXITSTATUS(status) != EXIT_SUCCESS);
-	utils_beep();
-
 	build_info.pid = 0;
 	/* enable build items again */
 	build_menu_update(NULL);
+
+	if (build_output.source_id != 0)
+	{	/* show the result after the rest of the output */
+		build_output.exited = TRUE;
+		build_output.exit_status = status;
+	}
+	else
+		show_build_result(status);
+}
+
+
+static void show_build_result(gint status)
+{
+	show_build_result_message(!SPAWN_WIFEXITED(status) || SPAWN_WEXITSTATUS(status) != EXIT_SUCCESS);
+	utils_beep();
 	ui_progress_bar_stop();
 }
 
@@ -453,6 +453,7 @@ static void on_notebook1_switch_page_after(GtkNotebook *notebook, gpointer page,
 		ui_update_popup_reundo_items(doc);
 		ui_document_show_hide(doc); /* update the document menu */
 		build_menu_update(doc);
+		document_update_pending_tags(doc);
 		sidebar_update_tag_list(doc, FALSE);
 		document_highlight_tags(doc);
 
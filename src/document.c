@@ -114,6 +114,7 @@ static void document_undo_clear(GeanyDocument *doc);
 static void document_undo_add_internal(GeanyDocument *doc, guint type, gpointer data);
 static void document_redo_add(GeanyDocument *doc, guint type, gpointer data);
 static gboolean remove_page(guint page_num);
+static void stream_load_cancel(GeanyDocument *doc);
 static GtkWidget* document_show_message(GeanyDocument *doc, GtkMessageType msgtype,
 	void (*response_cb)(GtkWidget *info_bar, gint response_id, GeanyDocument *doc),
 	const gchar *btn_1, GtkResponseType response_1,
@@ -391,6 +392,9 @@ void document_finalize(void)
 {
 	guint i;
 
+	if (preload_pool != NULL)
+		g_thread_pool_free(preload_pool, TRUE, TRUE);
+
 	for (i = 0; i < documents_array->len; i++)
 		g_free(documents[i]);
 	g_ptr_array_free(documents_array, TRUE);
@@ -712,6 +716,8 @@ static gboolean remove_page(guint page_num)
 	if (! main_status.closing_all && doc->real_path != NULL)
 		ui_add_recent_document(doc);
 
+	stream_load_cancel(doc);
+
 	doc->is_valid = FALSE;
 	doc->id = 0;
 
@@ -909,6 +915,29 @@ GeanyDocument *document_open_file(const gchar *locale_filename, gboolean readonl
 }
 
 
+/* Files of at least this size are displayed once their first chunk has been read and
+ * the remaining chunks are appended in the background */
+#define STREAM_LOAD_MIN_SIZE	(16 * 1024 * 1024)
+#define STREAM_LOAD_CHUNK_SIZE	(4 * 1024 * 1024)
+/* the longest incomplete character carried over to the next chunk */
+#define STREAM_LOAD_CARRY_MAX	8
+
+typedef struct
+{
+	GeanyDocument	*doc;
+	GInputStream	*stream;
+	GIConv			 conv;		/* converts the chunks to UTF-8, or (GIConv) -1 for UTF-8 files */
+	gchar			*buffer;	/* the carried over bytes followed by the chunk read */
+	gsize			 carry_len;	/* the length of the incomplete character at the start of buffer */
+	goffset			 offset;	/* the number of bytes read from the file */
+	goffset			 size;		/* the file size */
+	gboolean		 invalid;	/* whether a chunk wasn't valid in the detected encoding */
+	gchar			*locale_filename;
+	gchar			*forced_enc;
+	gchar			*display_filename;
+} StreamLoad;
+
+
 typedef struct
 {
 	gchar		*data;	/* null-terminated file data */
@@ -917,13 +946,33 @@ typedef struct
 	gboolean	 bom;
 	time_t		 mtime;	/* modification time, read by stat::st_mtime */
 	gboolean	 readonly;
+	gint		 eol_mode;
+	StreamLoad	*stream_load;	/* reads the rest of the file if data is only its first chunk */
 } FileData;
 
 
-static gboolean get_mtime(const gchar *locale_filename, time_t *time)
+/* A session file read by a worker thread, see document_preload_file() */
+struct DocumentPreload
+{
+	gchar		*locale_filename;
+	gchar		*forced_enc;
+	FileData	 filedata;
+	gboolean	 loaded;		/* whether filedata was read */
+	gchar		*error_msg;		/* the status bar message if loading failed, or NULL */
+	gboolean	 done;			/* set by the worker thread, protected by preload_mutex */
+};
+
+static GThreadPool *preload_pool = NULL;
+static GMutex preload_mutex;
+static GCond preload_cond;
+
+
+/* Doesn't touch the UI, so it can be used by worker threads. Returns an error message
+ * to be freed with g_free() on failure, or NULL. */
+static gchar *query_mtime(const gchar *locale_filename, time_t *time)
 {
 	GError *error = NULL;
-	const gchar *err_msg = NULL;
+	gchar *err_msg = NULL;
 
 	if (USE_GIO_FILE_OPERATIONS)
 	{
@@ -939,7 +988,7 @@ static gboolean get_mtime(const gchar *locale_filename, time_t *time)
 			*time = timeval.tv_sec;
 		}
 		else if (error)
-			err_msg = error->message;
+			err_msg = g_strdup(error->message);
 
 		g_object_unref(file);
 	}
@@ -950,39 +999,184 @@ static gboolean get_mtime(const gchar *locale_filename, time_t *time)
 		if (g_stat(locale_filename, &st) == 0)
 			*time = st.st_mtime;
 		else
-			err_msg = g_strerror(errno);
+			err_msg = g_strdup(g_strerror(errno));
 	}
 
 	if (err_msg)
 	{
 		gchar *utf8_filename = utils_get_utf8_from_locale(locale_filename);
 
-		ui_set_statusbar(TRUE, _("Could not open file %s (%s)"),
-			utf8_filename, err_msg);
+		SETPTR(err_msg, g_strdup_printf(_("Could not open file %s (%s)"), utf8_filename, err_msg));
 		g_free(utf8_filename);
 	}
 
 	if (error)
 		g_error_free(error);
 
-	return err_msg == NULL;
+	return err_msg;
 }
 
 
-/* loads textfile data, verifies and converts to forced_enc or UTF-8. Also handles BOM. */
-static gboolean load_text_file(const gchar *locale_filename, const gchar *display_filename,
-	FileData *filedata, const gchar *forced_enc)
+static gboolean get_mtime(const gchar *locale_filename, time_t *time)
+{
+	gchar *err_msg = query_mtime(locale_filename, time);
+
+	if (err_msg)
+	{
+		ui_set_statusbar(TRUE, "%s", err_msg);
+		g_free(err_msg);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+
+static void show_truncated_warning(const gchar *display_filename)
+{
+	const gchar *warn_msg = _(
+		"The file \"%s\" could not be opened properly and has been truncated. " \
+		"This can occur if the file contains a NULL byte. " \
+		"Be aware that saving it can cause data loss.\nThe file was set to read-only.");
+
+	if (main_status.main_window_realized)
+		dialogs_show_msgbox(GTK_MESSAGE_WARNING, warn_msg, display_filename);
+
+	ui_set_statusbar(TRUE, warn_msg, display_filename);
+}
+
+
+static void stream_load_free(gpointer data)
+{
+	StreamLoad *load = data;
+
+	g_input_stream_close(load->stream, NULL, NULL);
+	g_object_unref(load->stream);
+	if (load->conv != (GIConv) -1)
+		g_iconv_close(load->conv);
+	g_free(load->buffer);
+	g_free(load->locale_filename);
+	g_free(load->forced_enc);
+	g_free(load->display_filename);
+	g_free(load);
+}
+
+
+/* Reads the first chunk of a big file into filedata, up to its last line break so that
+ * no character is split. Returns FALSE if the file should rather be read as a whole,
+ * e.g. because it is small or its encoding isn't ASCII compatible. */
+static gboolean load_text_file_first_chunk(const gchar *locale_filename,
+	const gchar *display_filename, FileData *filedata, const gchar *forced_enc)
+{
+	StreamLoad *load;
+	GFile *file;
+	GFileInputStream *stream;
+	GStatBuf st;
+	GIConv conv = (GIConv) -1;
+	gchar *buffer;
+	gsize n_read = 0, len = 0;
+
+	/* the chunks are read with GIO, so respect the preference to not use it */
+	if (! USE_GIO_FILE_OPERATIONS ||
+		g_stat(locale_filename, &st) != 0 || ! S_ISREG(st.st_mode) ||
+		st.st_size < STREAM_LOAD_MIN_SIZE)
+		return FALSE;
+
+	file = g_file_new_for_path(locale_filename);
+	stream = g_file_read(file, NULL, NULL);
+	g_object_unref(file);
+	if (stream == NULL)
+		return FALSE;
+
+	buffer = g_malloc(STREAM_LOAD_CHUNK_SIZE + STREAM_LOAD_CARRY_MAX);
+	if (g_input_stream_read_all(G_INPUT_STREAM(stream), buffer, STREAM_LOAD_CHUNK_SIZE,
+			&n_read, NULL, NULL) && n_read == STREAM_LOAD_CHUNK_SIZE)
+	{
+		for (len = n_read; len > 0 && buffer[len - 1] != '\n'; len--);
+
+		if (len > 0)
+		{
+			filedata->data = g_strndup(buffer, len);
+			filedata->len = len;
+		}
+	}
+
+	if (filedata->data != NULL &&
+		encodings_convert_to_utf8_auto(&filedata->data, &filedata->len, forced_enc,
+			&filedata->enc, &filedata->bom, &filedata->readonly) &&
+		/* leave the NULL byte warning to the whole file path */
+		! filedata->readonly &&
+		(utils_str_equal(filedata->enc, "UTF-8") || (
+			! encodings_is_unicode_charset(filedata->enc) &&
+			! utils_str_equal(filedata->enc, encodings[GEANY_ENCODING_NONE].charset) &&
+			(conv = g_iconv_open("UTF-8", filedata->enc)) != (GIConv) -1)) &&
+		/* the bytes after the line break are read again with the next chunk */
+		g_seekable_seek(G_SEEKABLE(stream), len, G_SEEK_SET, NULL, NULL))
+	{
+		load = g_new0(StreamLoad, 1);
+		load->stream = G_INPUT_STREAM(stream);
+		load->conv = conv;
+		load->buffer = buffer;
+		load->offset = len;
+		load->size = st.st_size;
+		load->locale_filename = g_strdup(locale_filename);
+		load->forced_enc = g_strdup(forced_enc);
+		load->display_filename = g_strdup(display_filename);
+		filedata->stream_load = load;
+		return TRUE;
+	}
+
+	if (conv != (GIConv) -1)
+		g_iconv_close(conv);
+	g_object_unref(stream);
+	g_free(buffer);
+	g_free(filedata->data);
+	g_free(filedata->enc);
+	filedata->data = NULL;
+	filedata->len = 0;
+	filedata->enc = NULL;
+	filedata->bom = FALSE;
+	filedata->readonly = FALSE;
+	return FALSE;
+}
+
+
+/* Reads the file like load_text_file() without touching the UI, so it can be used by
+ * worker threads. On failure, error_msg is set to the message for the status bar. */
+static gboolean read_text_file(const gchar *locale_filename, const gchar *display_filename,
+	FileData *filedata, const gchar *forced_enc, gboolean allow_stream, gchar **error_msg)
 {
 	GError *err = NULL;
+	GStatBuf st;
 
 	filedata->data = NULL;
 	filedata->len = 0;
 	filedata->enc = NULL;
 	filedata->bom = FALSE;
 	filedata->readonly = FALSE;
+	filedata->stream_load = NULL;
+
+	*error_msg = query_mtime(locale_filename, &filedata->mtime);
+	if (*error_msg)
+		return FALSE;
+
+	/* files of 2 GB and more aren't supported: Scintilla's document positions and
+	 * lengths, and those of the sci_* API, are ints and would overflow */
+	if (g_stat(locale_filename, &st) == 0 && st.st_size > G_MAXINT)
+	{
+		gchar *size = g_format_size(st.st_size);
 
-	if (!get_mtime(locale_filename, &filedata->mtime))
+		*error_msg = g_strdup_printf(_("The file \"%s\" is too large to be opened (%s)."),
+			display_filename, size);
+		g_free(size);
 		return FALSE;
+	}
+
+	if (allow_stream &&
+		load_text_file_first_chunk(locale_filename, display_filename, filedata, forced_enc))
+	{
+		filedata->eol_mode = utils_get_line_endings(filedata->data, filedata->len);
+		return TRUE;
+	}
 
 	if (USE_GIO_FILE_OPERATIONS)
 	{
@@ -996,7 +1190,7 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 
 	if (err)
 	{
-		ui_set_statusbar(TRUE, "%s", err->message);
+		*error_msg = g_strdup(err->message);
 		g_error_free(err);
 		return FALSE;
 	}
@@ -1006,12 +1200,12 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 	{
 		if (forced_enc)
 		{
-			ui_set_statusbar(TRUE, _("The file \"%s\" is not valid %s."),
+			*error_msg = g_strdup_printf(_("The file \"%s\" is not valid %s."),
 				display_filename, forced_enc);
 		}
 		else
 		{
-			ui_set_statusbar(TRUE,
+			*error_msg = g_strdup_printf(
 	_("The file \"%s\" does not look like a text file or the file encoding is not supported."),
 			display_filename);
 		}
@@ -1019,23 +1213,356 @@ static gboolean load_text_file(const gchar *locale_filename, const gchar *displa
 		return FALSE;
 	}
 
+	filedata->eol_mode = utils_get_line_endings(filedata->data, filedata->len);
+	return TRUE;
+}
+
+
+/* loads textfile data, verifies and converts to forced_enc or UTF-8. Also handles BOM.
+ * If allow_stream is set, only the first chunk of a big file might be loaded and
+ * filedata->stream_load is set to read the rest. */
+static gboolean load_text_file(const gchar *locale_filename, const gchar *display_filename,
+	FileData *filedata, const gchar *forced_enc, gboolean allow_stream)
+{
+	gchar *error_msg;
+
+	if (! read_text_file(locale_filename, display_filename, filedata, forced_enc,
+			allow_stream, &error_msg))
+	{
+		ui_set_statusbar(TRUE, "%s", error_msg);
+		g_free(error_msg);
+		return FALSE;
+	}
+
 	if (filedata->readonly)
+		show_truncated_warning(display_filename);
+
+	return TRUE;
+}
+
+
+static void preload_file_thread(gpointer data, gpointer user_data)
+{
+	DocumentPreload *preload = data;
+	gchar *utf8_filename = utils_get_utf8_from_locale(preload->locale_filename);
+	gchar *display_filename = utils_str_middle_truncate(utf8_filename, 100);
+
+	preload->loaded = read_text_file(preload->locale_filename, display_filename,
+		&preload->filedata, preload->forced_enc, TRUE, &preload->error_msg);
+
+	g_free(display_filename);
+	g_free(utf8_filename);
+
+	g_mutex_lock(&preload_mutex);
+	preload->done = TRUE;
+	g_cond_broadcast(&preload_cond);
+	g_mutex_unlock(&preload_mutex);
+}
+
+
+/* Starts reading and decoding a session file in a worker thread, so the files of a session
+ * are read in parallel while the main thread sets up the tabs of the files read before.
+ * The result must be passed to document_open_file_preloaded().
+ * filename should be locale encoded, forced_enc can be NULL to detect the file encoding. */
+DocumentPreload *document_preload_file(const gchar *filename, const gchar *forced_enc)
+{
+	DocumentPreload *preload = g_new0(DocumentPreload, 1);
+
+	if (preload_pool == NULL)
+	{
+		guint n_threads = 4;
+
+#if GLIB_CHECK_VERSION(2, 36, 0)
+		n_threads = MAX(g_get_num_processors(), 1);
+#endif
+		preload_pool = g_thread_pool_new(preload_file_thread, NULL, n_threads, FALSE, NULL);
+	}
+
+	preload->locale_filename = g_strdup(filename);
+	/* remove relative junk like document_open_file_full() does */
+	utils_tidy_path(preload->locale_filename);
+	preload->forced_enc = g_strdup(forced_enc);
+	g_thread_pool_push(preload_pool, preload, NULL);
+	return preload;
+}
+
+
+/* Waits for the worker thread and takes the file data if it was read from locale_filename */
+static gboolean preload_take_file(DocumentPreload *preload, const gchar *locale_filename,
+		const gchar *display_filename, FileData *filedata)
+{
+	g_mutex_lock(&preload_mutex);
+	while (! preload->done)
+		g_cond_wait(&preload_cond, &preload_mutex);
+	g_mutex_unlock(&preload_mutex);
+
+	/* e.g. a resolved Windows shortcut, read it again */
+	if (! utils_str_equal(preload->locale_filename, locale_filename))
+		return load_text_file(locale_filename, display_filename, filedata,
+			preload->forced_enc, TRUE);
+
+	if (! preload->loaded)
+	{
+		ui_set_statusbar(TRUE, "%s", preload->error_msg);
+		return FALSE;
+	}
+	*filedata = preload->filedata;
+	preload->loaded = FALSE;	/* filedata is owned by the caller now */
+
+	if (filedata->readonly)
+		show_truncated_warning(display_filename);
+	return TRUE;
+}
+
+
+static void preload_free(DocumentPreload *preload)
+{
+	g_mutex_lock(&preload_mutex);
+	while (! preload->done)
+		g_cond_wait(&preload_cond, &preload_mutex);
+	g_mutex_unlock(&preload_mutex);
+
+	if (preload->loaded)
+	{
+		g_free(preload->filedata.data);
+		g_free(preload->filedata.enc);
+		if (preload->filedata.stream_load)
+			stream_load_free(preload->filedata.stream_load);
+	}
+	g_free(preload->locale_filename);
+	g_free(preload->forced_enc);
+	g_free(preload->error_msg);
+	g_free(preload);
+}
+
+
+/* Converts the len bytes in load->buffer to UTF-8 and appends them to the document.
+ * An incomplete character at the end is moved to the start of the buffer for the
+ * next chunk. Returns FALSE if the data is invalid or contains a NULL byte, after
+ * appending the text before it, or if the text couldn't be appended completely.
+ * load->invalid is set for invalid data. */
+static gboolean stream_load_append(StreamLoad *load, gsize len, gboolean last)
+{
+	ScintillaObject *sci = load->doc->editor->sci;
+	gboolean changed = load->doc->changed;
+	gboolean valid = TRUE;
+	gchar *text = NULL;
+	gsize text_len, used;
+	gint doc_len;
+
+	if (load->conv == (GIConv) -1)
+	{
+		const gchar *end;
+
+		if (g_utf8_validate(load->buffer, len, &end))
+			used = len;
+		else
+		{
+			used = end - load->buffer;
+			if (last || *end == '\0' || len - used >= STREAM_LOAD_CARRY_MAX)
+			{
+				valid = FALSE;
+				load->invalid = *end != '\0';
+			}
+		}
+		text_len = used;
+	}
+	else
+	{
+		gchar *in = load->buffer;
+		gchar *out, *end;
+		gsize in_left = len;
+		gsize out_size = len * 2 + STREAM_LOAD_CARRY_MAX;
+		gsize out_left = out_size;
+
+		text = out = g_malloc(out_size);
+		while (g_iconv(load->conv, &in, &in_left, &out, &out_left) == (gsize) -1)
+		{
+			if (errno == E2BIG)
+			{
+				gsize out_len = out - text;
+
+				out_size *= 2;
+				text = g_realloc(text, out_size);
+				out = text + out_len;
+				out_left = out_size - out_len;
+			}
+			else if (errno == EINVAL && ! last && in_left < STREAM_LOAD_CARRY_MAX)
+				break;	/* incomplete character at the end of the chunk */
+			else
+			{
+				valid = FALSE;
+				load->invalid = TRUE;
+				break;
+			}
+		}
+		used = len - in_left;
+		text_len = out - text;
+		end = memchr(text, '\0', text_len);
+		if (end != NULL)
+		{
+			/* the NULL byte comes before any invalid data */
+			text_len = end - text;
+			valid = FALSE;
+			load->invalid = FALSE;
+		}
+	}
+
+	/* the loaded text isn't an edit of the document, and Scintilla drops text inserted
+	 * into a read-only document */
+	doc_len = sci_get_length(sci);
+	sci_set_undo_collection(sci, FALSE);
+	sci_set_readonly(sci, FALSE);
+	sci_append_text(sci, text ? text : load->buffer, (gint) text_len);
+	sci_set_readonly(sci, TRUE);
+	sci_set_undo_collection(sci, TRUE);
+	if (! changed)
+		sci_set_savepoint(sci);
+	g_free(text);
+
+	if ((gsize) (sci_get_length(sci) - doc_len) != text_len)
+	{
+		/* the document doesn't have all of the file, so don't let it be saved */
+		geany_debug("%s: only %d of %" G_GSIZE_FORMAT " bytes were appended", G_STRFUNC,
+			sci_get_length(sci) - doc_len, text_len);
+		load->invalid = FALSE;
+		return FALSE;
+	}
+
+	if (! valid)
+		return FALSE;
+
+	load->carry_len = len - used;
+	memmove(load->buffer, load->buffer + used, load->carry_len);
+	return TRUE;
+}
+
+
+/* Reads the whole file again when a chunk isn't valid in the encoding detected from the
+ * first one, so that the encoding is detected from all of it like for smaller files */
+static gboolean stream_load_reload(GeanyDocument *doc)
+{
+	StreamLoad *load = doc->priv->stream_load;
+	ScintillaObject *sci = doc->editor->sci;
+	FileData filedata;
+
+	if (! load_text_file(load->locale_filename, load->display_filename, &filedata,
+			load->forced_enc, FALSE))
+		return FALSE;
+
+	/* the document can't be edited while it's loaded, so it has no changes to keep */
+	sci_set_readonly(sci, FALSE);
+	sci_set_undo_collection(sci, FALSE);
+	sci_set_text(sci, filedata.data);
+	sci_set_undo_collection(sci, TRUE);
+	sci_set_savepoint(sci);
+	sci_set_eol_mode(sci, filedata.eol_mode);
+	g_free(filedata.data);
+
+	doc->priv->line_count = sci_get_line_count(sci);
+	sci_set_line_numbers(sci, editor_prefs.show_linenumber_margin);
+	doc->priv->mtime = filedata.mtime;
+	SETPTR(doc->encoding, filedata.enc);
+	doc->has_bom = filedata.bom;
+	store_saved_encoding(doc);
+	doc->readonly = doc->readonly || filedata.readonly;
+
+	ui_update_tab_status(doc);
+	if (doc == document_get_current())
+		ui_document_show_hide(doc);	/* update the encoding menu */
+	return TRUE;
+}
+
+
+/* the caller has to return FALSE from stream_load_next_chunk() to free the StreamLoad */
+static void stream_load_finish(GeanyDocument *doc, gboolean truncated)
+{
+	StreamLoad *load = doc->priv->stream_load;
+
+	if (truncated)
+	{
+		doc->readonly = TRUE;
+		ui_update_tab_status(doc);
+		show_truncated_warning(load->display_filename);
+	}
+	else
+		ui_set_statusbar(TRUE, _("File %s loaded."), load->display_filename);
+
+	sci_set_readonly(doc->editor->sci, doc->readonly);
+	doc->priv->stream_load = NULL;
+	doc->priv->stream_load_source = 0;
+
+	queue_colourise(doc);
+	if (! doc->priv->tags_pending)
+		document_update_tags(doc);
+}
+
+
+static gboolean stream_load_next_chunk(gpointer data)
+{
+	StreamLoad *load = data;
+	GeanyDocument *doc = load->doc;
+	GError *error = NULL;
+	gsize n_read = 0;
+	gboolean last;
+
+	if (! g_input_stream_read_all(load->stream, load->buffer + load->carry_len,
+			STREAM_LOAD_CHUNK_SIZE, &n_read, NULL, &error))
+	{
+		ui_set_statusbar(TRUE, "%s", error->message);
+		g_error_free(error);
+		stream_load_finish(doc, TRUE);
+		return FALSE;
+	}
+	load->offset += n_read;
+	last = n_read < STREAM_LOAD_CHUNK_SIZE;
+
+	if (! stream_load_append(load, load->carry_len + n_read, last))
 	{
-		const gchar *warn_msg = _(
-			"The file \"%s\" could not be opened properly and has been truncated. " \
-			"This can occur if the file contains a NULL byte. " \
-			"Be aware that saving it can cause data loss.\nThe file was set to read-only.");
+		stream_load_finish(doc, ! (load->invalid && stream_load_reload(doc)));
+		return FALSE;
+	}
 
-		if (main_status.main_window_realized)
-			dialogs_show_msgbox(GTK_MESSAGE_WARNING, warn_msg, display_filename);
+	/* update line number margin width */
+	doc->priv->line_count = sci_get_line_count(doc->editor->sci);
+	sci_set_line_numbers(doc->editor->sci, editor_prefs.show_linenumber_margin);
 
-		ui_set_statusbar(TRUE, warn_msg, display_filename);
+	if (last)
+	{
+		stream_load_finish(doc, FALSE);
+		return FALSE;
 	}
 
+	ui_set_statusbar(FALSE, _("Loading %s (%d%%)..."), load->display_filename,
+		(gint) (load->offset * 100 / MAX(load->size, load->offset)));
 	return TRUE;
 }
 
 
+/* Appends the rest of a big file chunk by chunk while the document can already be viewed.
+ * The document can't be edited until the whole file has been read. */
+static void stream_load_start(GeanyDocument *doc, StreamLoad *load)
+{
+	load->doc = doc;
+	doc->priv->stream_load = load;
+	sci_set_readonly(doc->editor->sci, TRUE);
+	doc->priv->stream_load_source = g_idle_add_full(G_PRIORITY_LOW,
+		stream_load_next_chunk, load, stream_load_free);
+}
+
+
+/* Stops appending the rest of the file, e.g. when the document is closed or reloaded */
+static void stream_load_cancel(GeanyDocument *doc)
+{
+	if (doc->priv->stream_load_source == 0)
+		return;
+
+	g_source_remove(doc->priv->stream_load_source);
+	doc->priv->stream_load_source = 0;
+	doc->priv->stream_load = NULL;
+}
+
+
 /* Sets the cursor position on opening a file. First it sets the line when cl_options.goto_line
  * is set, otherwise it sets the line when pos is greater than zero and finally it sets the column
  * if cl_options.goto_column is set.
@@ -1274,15 +1801,12 @@ void document_show_tab(GeanyDocument *doc)
 }
 
 
-/* To open a new file, set doc to NULL; filename should be locale encoded.
- * To reload a file, set the doc for the document to be reloaded; filename should be NULL.
- * pos is the cursor position, which can be overridden by --line and --column.
- * forced_enc can be NULL to detect the file encoding.
- * Returns: doc of the opened file or NULL if an error occurred. */
-GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename, gint pos,
-		gboolean readonly, GeanyFiletype *ft, const gchar *forced_enc)
+/* See document_open_file_full(), preload is the file data read in advance or NULL */
+static GeanyDocument *open_file(GeanyDocument *doc, const gchar *filename, gint pos,
+		gboolean readonly, GeanyFiletype *ft, const gchar *forced_enc, DocumentPreload *preload)
 {
 	gint editor_mode;
+	gboolean loaded;
 	gboolean reload = (doc == NULL) ? FALSE : TRUE;
 	gchar *utf8_filename = NULL;
 	gchar *display_filename = NULL;
@@ -1330,7 +1854,15 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 	{	/* doc possibly changed */
 		display_filename = utils_str_middle_truncate(utf8_filename, 100);
 
-		if (! load_text_file(locale_filename, display_filename, &filedata, forced_enc))
+		if (reload)
+			stream_load_cancel(doc);
+
+		if (preload != NULL)
+			loaded = preload_take_file(preload, locale_filename, display_filename, &filedata);
+		else
+			loaded = load_text_file(locale_filename, display_filename, &filedata, forced_enc,
+				! reload);
+		if (! loaded)
 		{
 			g_free(display_filename);
 			g_free(utf8_filename);
@@ -1382,7 +1914,7 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 		queue_colourise(doc);	/* Ensure the document gets colourised. */
 
 		/* detect & set line endings */
-		editor_mode = utils_get_line_endings(filedata.data, filedata.len);
+		editor_mode = filedata.eol_mode;
 		if (undo_reload_data)
 		{
 			undo_reload_data->eol_mode = editor_get_eol_char_mode(doc->editor);
@@ -1493,6 +2025,9 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 				(readonly) ? _(", read-only") : "");
 		}
 
+		if (filedata.stream_load)
+			stream_load_start(doc, filedata.stream_load);
+
 		/* now the document is fully ready, display it (see notebook_new_tab()) */
 		gtk_widget_show(document_get_notebook_child(doc));
 	}
@@ -1513,6 +2048,32 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 }
 
 
+/* To open a new file, set doc to NULL; filename should be locale encoded.
+ * To reload a file, set the doc for the document to be reloaded; filename should be NULL.
+ * pos is the cursor position, which can be overridden by --line and --column.
+ * forced_enc can be NULL to detect the file encoding.
+ * Returns: doc of the opened file or NULL if an error occurred. */
+GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename, gint pos,
+		gboolean readonly, GeanyFiletype *ft, const gchar *forced_enc)
+{
+	return open_file(doc, filename, pos, readonly, ft, forced_enc, NULL);
+}
+
+
+/* Opens the file read by document_preload_file() like document_open_file_full() and
+ * frees preload.
+ * Returns: doc of the opened file or NULL if an error occurred. */
+GeanyDocument *document_open_file_preloaded(DocumentPreload *preload, gint pos,
+		gboolean readonly, GeanyFiletype *ft)
+{
+	GeanyDocument *doc = open_file(NULL, preload->locale_filename, pos, readonly, ft,
+		preload->forced_enc, preload);
+
+	preload_free(preload);
+	return doc;
+}
+
+
 /* Takes a new line separated list of filename URIs and opens each file.
  * length is the length of the string */
 void document_open_file_list(const gchar *data, gsize length)
@@ -2112,6 +2673,12 @@ gboolean document_save_file(GeanyDocument *doc, gboolean force)
 
 	if (!force && !doc->changed)
 		return FALSE;
+	if (doc->priv->stream_load != NULL)
+	{
+		ui_set_statusbar(TRUE,
+			_("Cannot save document '%s' before it has been loaded completely!"), DOC_FILENAME(doc));
+		return FALSE;
+	}
 	if (doc->readonly)
 	{
 		ui_set_statusbar(TRUE,
@@ -2631,20 +3198,30 @@ gint document_replace_all(GeanyDocument *doc, const gchar *find_text, const gcha
 }
 
 
-/*
- * Parses or re-parses the document's buffer and updates the type
- * keywords and symbol list.
- *
- * @param doc The document.
- */
-void document_update_tags(GeanyDocument *doc)
+/* Called when the background parse started by update_tags() has replaced the tags */
+static void on_tags_updated(TMSourceFile *source_file, gpointer user_data)
 {
-	guchar *buffer_ptr;
-	gsize len;
+	GeanyDocument *doc = document_find_by_id(GPOINTER_TO_UINT(user_data));
+
+	/* the document may have been closed or its TM file replaced meanwhile */
+	if (doc == NULL || doc->tm_file != source_file || main_status.quitting)
+		return;
+
+	sidebar_update_tag_list(doc, TRUE);
+	document_highlight_tags(doc);
+}
+
+
+static void update_tags(GeanyDocument *doc, gboolean in_background)
+{
+	guchar *buffer_ptr, *buffer2_ptr;
+	gsize len, gap;
 
 	g_return_if_fail(DOC_VALID(doc));
 	g_return_if_fail(app->tm_workspace != NULL);
 
+	doc->priv->tags_pending = FALSE;
+
 	/* early out if it's a new file or doesn't support tags */
 	if (! doc->file_name || ! doc->file_type || !filetype_has_tags(doc->file_type))
 	{
@@ -2681,21 +3258,57 @@ void document_update_tags(GeanyDocument *doc)
 	}
 
 	/* Parse Scintilla's buffer directly using TagManager
-	 * Note: this buffer *MUST NOT* be modified */
+	 * Note: this buffer *MUST NOT* be modified
+	 * The text before and after the gap of Scintilla's gap buffer is passed
+	 * separately; SCI_GETCHARACTERPOINTER would move the gap to the end of the
+	 * document first, which means moving all the text after the cursor. */
 	len = sci_get_length(doc->editor->sci);
-	buffer_ptr = (guchar *) scintilla_send_message(doc->editor->sci, SCI_GETCHARACTERPOINTER, 0, 0);
-	tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, len);
+	gap = scintilla_send_message(doc->editor->sci, SCI_GETGAPPOSITION, 0, 0);
+	buffer_ptr = (guchar *) scintilla_send_message(doc->editor->sci, SCI_GETRANGEPOINTER, 0, gap);
+	buffer2_ptr = (guchar *) scintilla_send_message(doc->editor->sci, SCI_GETRANGEPOINTER,
+		gap, len - gap);
+	if (in_background)
+	{
+		/* TagManager parses a snapshot of the buffer in a worker thread and the
+		 * symbol list gets updated by on_tags_updated() once it's done */
+		tm_workspace_update_source_file_buffer_async(doc->tm_file, buffer_ptr, gap,
+			buffer2_ptr, len - gap, on_tags_updated, GUINT_TO_POINTER(doc->id));
+		return;
+	}
+	tm_workspace_update_source_file_buffer(doc->tm_file, buffer_ptr, gap,
+		buffer2_ptr, len - gap);
 
 	sidebar_update_tag_list(doc, TRUE);
 	document_highlight_tags(doc);
 }
 
 
+/*
+ * Parses or re-parses the document's buffer and updates the type
+ * keywords and symbol list.
+ *
+ * @param doc The document.
+ */
+void document_update_tags(GeanyDocument *doc)
+{
+	update_tags(doc, FALSE);
+}
+
+
+/* Parses the tags of a session file when its tab is first shown, see document_load_config() */
+void document_update_pending_tags(GeanyDocument *doc)
+{
+	if (doc->priv->tags_pending)
+		update_tags(doc, TRUE);
+}
+
+
 /* Re-highlights type keywords without re-parsing the whole document. */
 void document_highlight_tags(GeanyDocument *doc)
 {
 	GString *keywords_str;
 	gint keyword_idx;
+	guint generation;
 
 	/* some filetypes support type keywords (such as struct names), but not
 	 * necessarily all filetypes for a particular scintilla lexer.  this
@@ -2726,6 +3339,13 @@ void document_highlight_tags(GeanyDocument *doc)
 	if (!app->tm_workspace->tags_array)
 		return;
 
+	/* most reparses don't add or remove any typename - don't rebuild the keywords
+	 * from all typenames of the workspace then */
+	generation = tm_workspace_get_typenames_generation(doc->file_type->lang);
+	if (generation == doc->priv->keyword_generation)
+		return;
+	doc->priv->keyword_generation = generation;
+
 	/* get any type keywords and tell scintilla about them
 	 * this will cause the type keywords to be colourized in scintilla */
 	keywords_str = symbols_find_typenames_as_string(doc->file_type->lang, FALSE);
@@ -2752,8 +3372,9 @@ static gboolean on_document_update_tag_list_idle(gpointer data)
 	if (! DOC_VALID(doc))
 		return FALSE;
 
+	/* parse in the background so typing isn't blocked by large files */
 	if (! main_status.quitting)
-		document_update_tags(doc);
+		update_tags(doc, TRUE);
 
 	doc->priv->tag_list_update_source = 0;
 
@@ -2766,6 +3387,9 @@ void document_update_tag_list_in_idle(GeanyDocument *doc)
 {
 	if (editor_prefs.autocompletion_update_freq <= 0 || ! filetype_has_tags(doc->file_type))
 		return;
+	/* the tags are updated once the whole file has been appended */
+	if (doc->priv->stream_load != NULL)
+		return;
 
 	/* prevent "stacking up" callback handlers, we only need one to run soon */
 	if (doc->priv->tag_list_update_source != 0)
@@ -2808,7 +3432,12 @@ static void document_load_config(GeanyDocument *doc, GeanyFiletype *type,
 			doc->priv->symbol_list_sort_mode = type->priv->symbol_list_sort_mode;
 	}
 
-	document_update_tags(doc);
+	/* parsing all session files would delay the startup, so it's done when the tab is
+	 * first shown instead */
+	if (main_status.opening_session_files)
+		doc->priv->tags_pending = TRUE;
+	else
+		document_update_tags(doc);
 }
 
 
@@ -2995,6 +3624,15 @@ void document_undo(GeanyDocument *doc)
 		{
 			case UNDO_SCINTILLA:
 			{
+				if (! sci_can_undo(doc->editor->sci))
+				{
+					/* Scintilla dropped the oldest steps of its history to stay within
+					 * editor_private_prefs.undo_memory_limit. The remaining actions are
+					 * older than this step (and reload actions count the dropped steps),
+					 * so none of them can be undone any more. */
+					document_undo_clear_stack(&doc->priv->undo_actions);
+					break;
+				}
 				document_redo_add(doc, UNDO_SCINTILLA, NULL);
 
 				sci_undo(doc->editor->sci);
@@ -3051,7 +3689,8 @@ void document_undo(GeanyDocument *doc)
 				data->eol_mode = editor_get_eol_char_mode(doc->editor);
 
 				/* Undo the rest of the actions which are part of the reloading process. */
-				for (i = 0; i < data->actions_count; i++)
+				for (i = 0; i < data->actions_count &&
+					g_trash_stack_height(&doc->priv->undo_actions) > 0; i++)
 					document_undo(doc);
 
 				/* Restore the previous EOL mode. */
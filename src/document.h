@@ -262,6 +262,13 @@ GeanyDocument *document_open_file_full(GeanyDocument *doc, const gchar *filename
 
 void document_open_file_list(const gchar *data, gsize length);
 
+typedef struct DocumentPreload DocumentPreload;
+
+DocumentPreload *document_preload_file(const gchar *filename, const gchar *forced_enc);
+
+GeanyDocument *document_open_file_preloaded(DocumentPreload *preload, gint pos,
+		gboolean readonly, GeanyFiletype *ft);
+
 gboolean document_search_bar_find(GeanyDocument *doc, const gchar *text, gboolean inc,
 		gboolean backwards);
 
@@ -282,6 +289,8 @@ void document_update_tags(GeanyDocument *doc);
 
 void document_update_tag_list_in_idle(GeanyDocument *doc);
 
+void document_update_pending_tags(GeanyDocument *doc);
+
 void document_highlight_tags(GeanyDocument *doc);
 
 gboolean document_check_disk_status(GeanyDocument *doc, gboolean force);
@@ -92,6 +92,7 @@ typedef struct GeanyDocumentPrivate
 	FileEncoding	 saved_encoding;
 	gboolean		 colourise_needed;	/* use document.c:queue_colourise() instead */
 	guint			 keyword_hash;	/* hash of keyword string used for typename colourisation */
+	guint			 keyword_generation;	/* typenames generation the keywords were set for */
 	gint			 line_count;		/* Number of lines in the document. */
 	gint			 symbol_list_sort_mode;
 	/* indicates whether a file is on a remote filesystem, works only with GIO/GVfs */
@@ -106,6 +107,12 @@ typedef struct GeanyDocumentPrivate
 	time_t			 mtime;
 	/* ID of the idle callback updating the tag list */
 	guint			 tag_list_update_source;
+	/* Whether the tags still need to be parsed, see document_update_pending_tags() */
+	gboolean		 tags_pending;
+	/* Reads the rest of a big file while it's displayed, or NULL (see stream_load_start()) */
+	gpointer		 stream_load;
+	/* ID of the idle callback appending the chunks of stream_load */
+	guint			 stream_load_source;
 	/* Whether it's temporarily protected (read-only and saving needs confirmation). Does
 	 * not imply doc->readonly as writable files can be protected */
 	gint			 protected;
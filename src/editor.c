@@ -84,6 +84,7 @@ static gchar current_word[GEANY_MAX_WORD_LENGTH];
 
 /* Initialised in keyfile.c. */
 GeanyEditorPrefs editor_prefs;
+EditorPrivatePrefs editor_private_prefs;
 
 EditorInfo editor_info = {current_word, -1};
 
@@ -4982,6 +4983,10 @@ static ScintillaObject *create_new_sci(GeanyEditor *editor)
 	/*sci_set_caret_policy_y(sci, CARET_JUMPS | CARET_EVEN, 0);*/
 	SSM(sci, SCI_AUTOCSETSEPARATOR, '\n', 0);
 	SSM(sci, SCI_SETSCROLLWIDTHTRACKING, 1, 0);
+	/* style the rest of big files on another thread rather than blocking when jumping far */
+	SSM(sci, SCI_SETIDLESTYLING, SC_IDLESTYLING_BACKGROUND, 0);
+	/* drop the oldest undo steps rather than letting long sessions on big files grow without bound */
+	SSM(sci, SCI_SETUNDOMEMORYLIMIT, (uptr_t) MAX(editor_private_prefs.undo_memory_limit, 0) * 1024 * 1024, 0);
 
 	/* tag autocompletion images */
 	register_named_icon(sci, 1, "classviewer-var");
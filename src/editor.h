@@ -223,6 +223,14 @@ typedef struct
 
 extern EditorInfo editor_info;
 
+/* Editor preferences not exported to plugins */
+typedef struct
+{
+	gint	undo_memory_limit;	/* MiB of undo history per document, 0 for no limit (hidden pref) */
+} EditorPrivatePrefs;
+
+extern EditorPrivatePrefs editor_private_prefs;
+
 
 void editor_init(void);
 
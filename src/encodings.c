@@ -666,6 +666,137 @@ gchar *encodings_convert_to_utf8_from_charset(const gchar *buffer, gssize size,
 }
 
 
+/* Like g_utf8_validate() for len bytes, but checks eight bytes at once while they are ASCII,
+ * which is most text. Also fails on NUL bytes. */
+static gboolean utf8_validate_fast(const gchar *data, gsize len)
+{
+	const guint64 high_bits = G_GUINT64_CONSTANT(0x8080808080808080);
+	const guint64 low_bits = G_GUINT64_CONSTANT(0x0101010101010101);
+	const guchar *p = (const guchar *) data;
+	const guchar *end = p + len;
+
+	while (p < end)
+	{
+		guchar c, min = 0x80, max = 0xBF;
+		gint n;
+
+		while (end - p >= 8)
+		{
+			guint64 word;
+
+			memcpy(&word, p, sizeof word);
+			/* stop at a non-ASCII or NUL byte */
+			if ((word & high_bits) || ((word - low_bits) & ~word & high_bits))
+				break;
+			p += 8;
+		}
+		if (p == end)
+			break;
+
+		c = *p++;
+		if (c < 0x80)
+		{
+			if (c == 0)
+				return FALSE;
+			continue;
+		}
+
+		/* the valid sequences, see table 3-7 of the Unicode Standard */
+		if (c >= 0xC2 && c <= 0xDF)
+			n = 1;
+		else if (c >= 0xE0 && c <= 0xEF)
+		{
+			n = 2;
+			if (c == 0xE0)
+				min = 0xA0;
+			else if (c == 0xED)
+				max = 0x9F;
+		}
+		else if (c >= 0xF0 && c <= 0xF4)
+		{
+			n = 3;
+			if (c == 0xF0)
+				min = 0x90;
+			else if (c == 0xF4)
+				max = 0x8F;
+		}
+		else
+			return FALSE;
+
+		if (end - p < n || *p < min || *p > max)
+			return FALSE;
+		for (p++, n--; n > 0; p++, n--)
+		{
+			if (*p < 0x80 || *p > 0xBF)
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+
+/* Guesses the charset of data which is not UTF-8 from the byte statistics of its start,
+ * so usually only one conversion is needed. Returns NULL if there is no good guess. */
+static const gchar *guess_charset(const gchar *data, gsize size)
+{
+	const guchar *p = (const guchar *) data;
+	gsize i, sample = MIN(size, 65536);
+	gsize zeros[2] = { 0, 0 };
+	gsize letters = 0, high = 0, c1 = 0, c0_df = 0, e0_ff = 0;
+
+	for (i = 0; i < sample; i++)
+	{
+		guchar c = p[i];
+
+		if (c == 0)
+			zeros[i % 2]++;
+		else if (c < 0x80)
+		{
+			if (g_ascii_isalpha(c))
+				letters++;
+		}
+		else
+		{
+			high++;
+			if (c < 0xA0)
+				c1++;
+			else if (c >= 0xE0)
+				e0_ff++;
+			else if (c >= 0xC0)
+				c0_df++;
+		}
+	}
+
+	/* UTF-16 without a BOM, where every other byte of ASCII text is NUL */
+	if (zeros[0] + zeros[1] > sample / 8)
+	{
+		if (zeros[1] > zeros[0] * 4)
+			return encodings[GEANY_ENCODING_UTF_16LE].charset;
+		if (zeros[0] > zeros[1] * 4)
+			return encodings[GEANY_ENCODING_UTF_16BE].charset;
+		return NULL;
+	}
+	if (high == 0 || zeros[0] + zeros[1] > 0)
+		return NULL;
+
+	/* mostly non-ASCII letters, most likely Cyrillic text. Lower case letters are more frequent,
+	 * which are in 0xE0-0xFF in WINDOWS-1251 and in 0xC0-0xDF in KOI8-R */
+	if (high > letters)
+	{
+		if (e0_ff > c0_df * 2)
+			return encodings[GEANY_ENCODING_WINDOWS_1251].charset;
+		if (c0_df > e0_ff * 2)
+			return encodings[GEANY_ENCODING_KOI8_R].charset;
+		return NULL;
+	}
+	/* Latin text with some accented letters. The C1 controls in ISO-8859-1 are hardly ever
+	 * used, they are mostly typographic quotes and dashes of WINDOWS-1252 */
+	if (c1 > 0)
+		return encodings[GEANY_ENCODING_WINDOWS_1252].charset;
+	return encodings[GEANY_ENCODING_ISO_8859_1].charset;
+}
+
+
 static gchar *encodings_check_regexes(const gchar *buffer, gsize size)
 {
 	guint i;
@@ -681,13 +812,16 @@ static gchar *encodings_check_regexes(const gchar *buffer, gsize size)
 }
 
 
+/* guessed_charset is tried after the suggested, locale and preferred charsets and before
+ * the others, or NULL */
 static gchar *encodings_convert_to_utf8_with_suggestion(const gchar *buffer, gssize size,
-		const gchar *suggested_charset, gchar **used_encoding)
+		const gchar *suggested_charset, const gchar *guessed_charset, gchar **used_encoding)
 {
 	const gchar *locale_charset = NULL;
 	const gchar *charset;
 	gchar *utf8_content;
 	gboolean check_suggestion = suggested_charset != NULL;
+	gboolean check_guess = guessed_charset != NULL;
 	gboolean check_locale = FALSE;
 	gint i, preferred_charset;
 
@@ -739,6 +873,13 @@ static gchar *encodings_convert_to_utf8_with_suggestion(const gchar *buffer, gss
 			else
 				continue;
 		}
+		else if (i == 0 && check_guess)
+		{
+			check_guess = FALSE;
+			charset = guessed_charset;
+			geany_debug("Using guessed charset: %s", charset);
+			i = -1; /* have i at 0 again on the next loop run */
+		}
 		else if (i >= 0)
 			charset = encodings[i].charset;
 		else /* in this case we have i == -2, continue to increase i and go ahead */
@@ -789,7 +930,8 @@ gchar *encodings_convert_to_utf8(const gchar *buffer, gssize size, gchar **used_
 
 	/* first try to read the encoding from the file content */
 	regex_charset = encodings_check_regexes(buffer, size);
-	utf8 = encodings_convert_to_utf8_with_suggestion(buffer, size, regex_charset, used_encoding);
+	utf8 = encodings_convert_to_utf8_with_suggestion(buffer, size, regex_charset, NULL,
+		used_encoding);
 	g_free(regex_charset);
 
 	return utf8;
@@ -883,7 +1025,7 @@ handle_forced_encoding(BufferData *buffer, const gchar *forced_enc)
 
 	if (utils_str_equal(forced_enc, "UTF-8"))
 	{
-		if (! g_utf8_validate(buffer->data, buffer->len, NULL))
+		if (! utf8_validate_fast(buffer->data, buffer->len))
 		{
 			return FALSE;
 		}
@@ -955,7 +1097,7 @@ handle_encoding(BufferData *buffer, GeanyEncodingIndex enc_idx)
 
 			/* try UTF-8 first */
 			if (encodings_get_idx_from_charset(regex_charset) == GEANY_ENCODING_UTF_8 &&
-				(buffer->size == buffer->len) && g_utf8_validate(buffer->data, buffer->len, NULL))
+				(buffer->size == buffer->len) && utf8_validate_fast(buffer->data, buffer->len))
 			{
 				buffer->enc = g_strdup("UTF-8");
 			}
@@ -963,7 +1105,8 @@ handle_encoding(BufferData *buffer, GeanyEncodingIndex enc_idx)
 			{
 				/* detect the encoding */
 				gchar *converted_text = encodings_convert_to_utf8_with_suggestion(buffer->data,
-					buffer->size, regex_charset, &buffer->enc);
+					buffer->size, regex_charset, guess_charset(buffer->data, buffer->size),
+					&buffer->enc);
 
 				if (converted_text == NULL)
 				{
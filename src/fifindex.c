@@ -0,0 +1,680 @@
+/*
+ *      fifindex.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2016 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Trigram index of the project's files, used by the built-in Find in Files to skip files which
+ * can't contain the search text.
+ *
+ * For each file the index keeps its modification time and size, and a Bloom filter of the
+ * trigrams (three byte sequences, with ASCII letters folded to lower case) it contains. A file
+ * whose filter lacks any trigram the search text must contain is skipped without reading it.
+ * Files whose time or size changed are searched and indexed again by the search threads, and
+ * saved documents are indexed again at once.
+ *
+ * The index is used when the project's fif_index setting is enabled. It is loaded on first
+ * use and written next to the project file when the project is closed.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "fifindex.h"
+
+#include "app.h"
+#include "document.h"
+#include "geanyobject.h"
+#include "projectprivate.h"
+#include "tm_source_file.h"
+#include "utils.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+
+#define INDEX_MAGIC "GeanyFifIndex1\n"
+/* bigger files are not indexed and always searched */
+#define MAX_INDEXED_SIZE (16 * 1024 * 1024)
+/* bits of a file's filter for each of its trigrams, giving about 5% false positives
+ * for each trigram of the search text */
+#define BITS_PER_TRIGRAM 8
+#define MIN_FILTER_BITS 64
+
+
+typedef struct
+{
+	gint64 mtime;
+	gint64 size;
+	guint32 n_bits;			/* a power of 2, 0 for binary files */
+	guint8 *bits;
+}
+FifIndexEntry;
+
+struct FifIndex
+{
+	gint refcount;			/* atomic */
+	GMutex lock;
+	gchar *file_name;		/* locale encoding */
+	gchar *project_file;	/* the project's file name, UTF-8 */
+	gchar *base_path;		/* real path in locale encoding */
+	GHashTable *entries;	/* real path -> FifIndexEntry, guarded by lock */
+	gboolean dirty;			/* guarded by lock */
+};
+
+
+static FifIndex *project_index = NULL;
+
+
+static void entry_free(gpointer data)
+{
+	FifIndexEntry *entry = data;
+
+	g_free(entry->bits);
+	g_free(entry);
+}
+
+
+static guint8 fold_byte(gchar c)
+{
+	return (guint8) g_ascii_tolower(c);
+}
+
+
+static void get_bit_positions(guint32 trigram, guint32 n_bits, guint32 *pos1, guint32 *pos2)
+{
+	guint32 h = trigram * 0x9E3779B1u;
+
+	*pos1 = (h >> 7) & (n_bits - 1);
+	*pos2 = ((h >> 16 | h << 16) * 0x85EBCA6Bu) & (n_bits - 1);
+}
+
+
+static gint compare_trigrams(gconstpointer a, gconstpointer b)
+{
+	guint32 ta = *(const guint32 *) a;
+	guint32 tb = *(const guint32 *) b;
+
+	return ta < tb ? -1 : ta > tb;
+}
+
+
+/* Sorts trigrams and removes duplicates */
+static void unique_trigrams(GArray *trigrams)
+{
+	guint i, n = 0;
+
+	g_array_sort(trigrams, compare_trigrams);
+	for (i = 0; i < trigrams->len; i++)
+	{
+		if (n == 0 || g_array_index(trigrams, guint32, i) != g_array_index(trigrams, guint32, n - 1))
+			g_array_index(trigrams, guint32, n++) = g_array_index(trigrams, guint32, i);
+	}
+	g_array_set_size(trigrams, n);
+}
+
+
+/* Appends the trigrams of len bytes of text. If caseless is set, those which can match
+ * non-ASCII text are skipped: the ones with non-ASCII bytes, whose case isn't folded in the
+ * index, and the ones with k or s, which also match U+212A KELVIN SIGN and U+017F LATIN
+ * SMALL LETTER LONG S in caseless regular expressions. */
+static void append_trigrams(GArray *trigrams, const gchar *text, gsize len, gboolean caseless)
+{
+	guint32 trigram = 0;
+	gsize i, last_high = 0;
+	gboolean seen_high = FALSE;
+
+	for (i = 0; i < len; i++)
+	{
+		trigram = ((trigram << 8) | fold_byte(text[i])) & 0xffffff;
+		if ((guchar) text[i] >= 0x80 ||
+			(caseless && ((trigram & 0xff) == 'k' || (trigram & 0xff) == 's')))
+		{
+			last_high = i;
+			seen_high = TRUE;
+		}
+		if (i >= 2 && (! caseless || ! seen_high || i - last_high >= 3))
+			g_array_append_val(trigrams, trigram);
+	}
+}
+
+
+static FifIndexEntry *create_entry(gint64 mtime, gint64 size, const gchar *data, gsize len)
+{
+	FifIndexEntry *entry = g_new0(FifIndexEntry, 1);
+
+	entry->mtime = mtime;
+	entry->size = size;
+	if (data != NULL)
+	{
+		GArray *trigrams = g_array_sized_new(FALSE, FALSE, sizeof(guint32), len);
+		guint i;
+
+		append_trigrams(trigrams, data, len, FALSE);
+		unique_trigrams(trigrams);
+
+		entry->n_bits = MIN_FILTER_BITS;
+		while (entry->n_bits < trigrams->len * BITS_PER_TRIGRAM)
+			entry->n_bits <<= 1;
+		entry->bits = g_malloc0(entry->n_bits / 8);
+
+		for (i = 0; i < trigrams->len; i++)
+		{
+			guint32 pos1, pos2;
+
+			get_bit_positions(g_array_index(trigrams, guint32, i), entry->n_bits, &pos1, &pos2);
+			entry->bits[pos1 / 8] |= 1 << (pos1 % 8);
+			entry->bits[pos2 / 8] |= 1 << (pos2 % 8);
+		}
+		g_array_free(trigrams, TRUE);
+	}
+	return entry;
+}
+
+
+static gboolean entry_matches(const FifIndexEntry *entry, GArray *trigrams)
+{
+	guint i;
+
+	if (entry->n_bits == 0)
+		return FALSE;
+	if (trigrams == NULL)
+		return TRUE;
+
+	for (i = 0; i < trigrams->len; i++)
+	{
+		guint32 pos1, pos2;
+
+		get_bit_positions(g_array_index(trigrams, guint32, i), entry->n_bits, &pos1, &pos2);
+		if (! (entry->bits[pos1 / 8] & (1 << (pos1 % 8))) ||
+			! (entry->bits[pos2 / 8] & (1 << (pos2 % 8))))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+static gboolean read_bytes(const gchar **pos, const gchar *end, gpointer dest, gsize len)
+{
+	if ((gsize) (end - *pos) < len)
+		return FALSE;
+	memcpy(dest, *pos, len);
+	*pos += len;
+	return TRUE;
+}
+
+
+/* The file has the magic line, then for each file its path relative to the base path and
+ * NUL-terminated, its time, size and number of filter bits as little-endian integers and the
+ * filter bits. */
+static void load_index(FifIndex *index)
+{
+	gchar *contents;
+	gsize len;
+	const gchar *pos, *end;
+	gsize base_len = strlen(index->base_path);
+
+	if (! g_file_get_contents(index->file_name, &contents, &len, NULL))
+		return;
+
+	end = contents + len;
+	pos = contents + strlen(INDEX_MAGIC);
+	if (len < strlen(INDEX_MAGIC) || memcmp(contents, INDEX_MAGIC, strlen(INDEX_MAGIC)) != 0)
+		pos = end;
+
+	while (pos < end)
+	{
+		const gchar *name = pos;
+		const gchar *name_end = memchr(pos, '\0', end - pos);
+		FifIndexEntry entry;
+		guint32 n_bits;
+		gchar *path;
+
+		if (name_end == NULL)
+			break;
+		pos = name_end + 1;
+		if (! read_bytes(&pos, end, &entry.mtime, sizeof entry.mtime) ||
+			! read_bytes(&pos, end, &entry.size, sizeof entry.size) ||
+			! read_bytes(&pos, end, &n_bits, sizeof n_bits))
+			break;
+		entry.mtime = GINT64_FROM_LE(entry.mtime);
+		entry.size = GINT64_FROM_LE(entry.size);
+		entry.n_bits = GUINT32_FROM_LE(n_bits);
+		/* n_bits must be 0 or a power of 2 */
+		if ((entry.n_bits & (entry.n_bits - 1)) != 0 || (entry.n_bits != 0 && entry.n_bits < 8))
+			break;
+		entry.bits = g_malloc(entry.n_bits / 8);
+		if (! read_bytes(&pos, end, entry.bits, entry.n_bits / 8))
+		{
+			g_free(entry.bits);
+			break;
+		}
+
+		if (base_len > 0 && G_IS_DIR_SEPARATOR(index->base_path[base_len - 1]))
+			path = g_strconcat(index->base_path, name, NULL);
+		else
+			path = g_build_filename(index->base_path, name, NULL);
+		g_hash_table_insert(index->entries, path, g_memdup(&entry, sizeof entry));
+	}
+	g_free(contents);
+}
+
+
+static void save_index(FifIndex *index)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	GString *data;
+	GError *error = NULL;
+	gsize base_len = strlen(index->base_path);
+
+	g_mutex_lock(&index->lock);
+	if (! index->dirty)
+	{
+		g_mutex_unlock(&index->lock);
+		return;
+	}
+
+	data = g_string_new(INDEX_MAGIC);
+	g_hash_table_iter_init(&iter, index->entries);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		const gchar *path = key;
+		FifIndexEntry *entry = value;
+		gint64 mtime = GINT64_TO_LE(entry->mtime);
+		gint64 size = GINT64_TO_LE(entry->size);
+		guint32 n_bits = GUINT32_TO_LE(entry->n_bits);
+
+		/* forget removed files */
+		if (! g_file_test(path, G_FILE_TEST_EXISTS))
+		{
+			g_hash_table_iter_remove(&iter);
+			continue;
+		}
+		path += base_len;
+		while (G_IS_DIR_SEPARATOR(*path))
+			path++;
+		g_string_append_len(data, path, strlen(path) + 1);
+		g_string_append_len(data, (const gchar *) &mtime, sizeof mtime);
+		g_string_append_len(data, (const gchar *) &size, sizeof size);
+		g_string_append_len(data, (const gchar *) &n_bits, sizeof n_bits);
+		g_string_append_len(data, (const gchar *) entry->bits, entry->n_bits / 8);
+	}
+	index->dirty = FALSE;
+	g_mutex_unlock(&index->lock);
+
+	if (! g_file_set_contents(index->file_name, data->str, data->len, &error))
+	{
+		geany_debug("Could not write the Find in Files index (%s).", error->message);
+		g_error_free(error);
+	}
+	g_string_free(data, TRUE);
+}
+
+
+static FifIndex *create_index(GeanyProject *project)
+{
+	FifIndex *index = g_new0(FifIndex, 1);
+	gchar *utf8_base_path = project_get_base_path();
+	gchar *locale_path;
+
+	index->refcount = 1;
+	g_mutex_init(&index->lock);
+	index->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, entry_free);
+	index->project_file = g_strdup(project->file_name);
+
+	/* foo.geany is indexed in foo.geany-index */
+	locale_path = utils_get_locale_from_utf8(project->file_name);
+	index->file_name = g_strconcat(locale_path, "-index", NULL);
+	g_free(locale_path);
+
+	locale_path = utils_get_locale_from_utf8(utf8_base_path);
+	index->base_path = tm_get_real_path(locale_path);
+	g_free(locale_path);
+	g_free(utf8_base_path);
+
+	load_index(index);
+	return index;
+}
+
+
+void fif_index_unref(FifIndex *index)
+{
+	if (! g_atomic_int_dec_and_test(&index->refcount))
+		return;
+
+	g_hash_table_destroy(index->entries);
+	g_mutex_clear(&index->lock);
+	g_free(index->file_name);
+	g_free(index->project_file);
+	g_free(index->base_path);
+	g_free(index);
+}
+
+
+static void close_project_index(void)
+{
+	if (project_index == NULL)
+		return;
+
+	save_index(project_index);
+	fif_index_unref(project_index);
+	project_index = NULL;
+}
+
+
+/* Whether path, a real path, is the base path of index or inside it */
+static gboolean is_in_base_path(FifIndex *index, const gchar *path)
+{
+	gsize base_len = strlen(index->base_path);
+
+	return strncmp(path, index->base_path, base_len) == 0 &&
+		(path[base_len] == '\0' || G_IS_DIR_SEPARATOR(path[base_len]) ||
+			(base_len > 0 && G_IS_DIR_SEPARATOR(index->base_path[base_len - 1])));
+}
+
+
+/* Returns a new reference to the project's index if it is enabled and locale_dir, a real path,
+ * is in the project's base path, or NULL. */
+FifIndex *fif_index_get(const gchar *locale_dir)
+{
+	GeanyProject *project = app->project;
+
+	if (project == NULL || ! project->priv->fif_index || EMPTY(project->base_path))
+	{
+		close_project_index();
+		return NULL;
+	}
+	if (project_index != NULL && ! utils_str_equal(project_index->project_file, project->file_name))
+		close_project_index();
+	if (project_index == NULL)
+		project_index = create_index(project);
+
+	if (! is_in_base_path(project_index, locale_dir))
+		return NULL;
+
+	g_atomic_int_inc(&project_index->refcount);
+	return project_index;
+}
+
+
+static const gchar *get_unit_end(const gchar *p)
+{
+	if ((guchar) *p >= 0x80 && g_utf8_get_char_validated(p, -1) < (gunichar) -2)
+		return g_utf8_next_char(p);
+	return p + 1;
+}
+
+
+/* Returns the end of the {n}, {n,} or {n,m} quantifier starting at p, or NULL if the brace is
+ * a literal character */
+static const gchar *skip_quantifier(const gchar *p)
+{
+	const gchar *start;
+
+	start = ++p;
+	while (g_ascii_isdigit(*p))
+		p++;
+	if (p == start)
+		return NULL;
+	if (*p == ',')
+	{
+		p++;
+		while (g_ascii_isdigit(*p))
+			p++;
+	}
+	return *p == '}' ? p + 1 : NULL;
+}
+
+
+/* Skips the group or character class starting at p, returns NULL at the end of the pattern */
+static const gchar *skip_bracket(const gchar *p)
+{
+	gint depth = 0;
+	gboolean in_class = FALSE;
+
+	for (; *p != '\0'; p++)
+	{
+		if (*p == '\\')
+		{
+			if (*++p == '\0')
+				return NULL;
+		}
+		else if (in_class)
+		{
+			if (*p == ']')
+			{
+				in_class = FALSE;
+				if (depth == 0)
+					return p + 1;
+			}
+		}
+		else if (*p == '[')
+		{
+			in_class = TRUE;
+			/* a ']' first in the class is literal */
+			if (p[1] == '^')
+				p++;
+			if (p[1] == ']')
+				p++;
+		}
+		else if (*p == '(')
+			depth++;
+		else if (*p == ')' && --depth == 0)
+			return p + 1;
+	}
+	return NULL;
+}
+
+
+/* Adds the runs of text every match of the regular expression contains to runs, returns FALSE
+ * if they can't be told */
+static gboolean get_regex_runs(const gchar *pattern, GPtrArray *runs)
+{
+	GString *run = g_string_new(NULL);
+	const gchar *p = pattern;
+
+	/* options like (?x) and quoting change the meaning of what follows */
+	if (strstr(pattern, "(?") != NULL || strstr(pattern, "\\Q") != NULL)
+		p = NULL;
+
+	while (p != NULL && *p != '\0')
+	{
+		const gchar *unit = p, *unit_end;
+
+		switch (*p)
+		{
+			case '|':
+				/* any alternative may match */
+				p = NULL;
+				continue;
+			case '(':
+			case '[':
+				p = skip_bracket(p);
+				g_ptr_array_add(runs, g_string_free(run, FALSE));
+				run = g_string_new(NULL);
+				continue;
+			case '\\':
+				if (p[1] == '\0' || g_ascii_isdigit(p[1]) || strchr("xcopPgkNu", p[1]) != NULL)
+				{
+					/* escapes of characters or back references */
+					p = NULL;
+					continue;
+				}
+				if (g_ascii_isalnum(p[1]))
+				{
+					/* character types and assertions */
+					g_ptr_array_add(runs, g_string_free(run, FALSE));
+					run = g_string_new(NULL);
+					p += 2;
+					continue;
+				}
+				unit = p + 1;
+				break;
+			case '{':
+				unit_end = skip_quantifier(p);
+				if (unit_end == NULL)
+					break;	/* a literal brace */
+				g_ptr_array_add(runs, g_string_free(run, FALSE));
+				run = g_string_new(NULL);
+				p = unit_end;
+				continue;
+			case '.': case '^': case '$': case '*': case '+': case '?': case ')':
+				g_ptr_array_add(runs, g_string_free(run, FALSE));
+				run = g_string_new(NULL);
+				p++;
+				continue;
+		}
+
+		unit_end = get_unit_end(unit);
+		p = unit_end;
+		if (*p == '*' || *p == '?' || (*p == '{' && skip_quantifier(p) != NULL))
+		{
+			/* the character is optional or repeated */
+			g_ptr_array_add(runs, g_string_free(run, FALSE));
+			run = g_string_new(NULL);
+			continue;
+		}
+		g_string_append_len(run, unit, unit_end - unit);
+		if (*p == '+')
+		{
+			g_ptr_array_add(runs, g_string_free(run, FALSE));
+			run = g_string_new(NULL);
+		}
+	}
+	g_ptr_array_add(runs, g_string_free(run, FALSE));
+	return p != NULL;
+}
+
+
+/* Returns the trigrams any text matching text contains, or NULL if they can't be told.
+ * text is a regular expression if regexp is set. */
+GArray *fif_index_get_trigrams(const gchar *text, gboolean regexp, gboolean matchcase)
+{
+	GPtrArray *runs = g_ptr_array_new_with_free_func(g_free);
+	GArray *trigrams = g_array_new(FALSE, FALSE, sizeof(guint32));
+	guint i;
+
+	if (regexp)
+	{
+		if (! get_regex_runs(text, runs))
+			g_ptr_array_set_size(runs, 0);
+	}
+	else
+		g_ptr_array_add(runs, g_strdup(text));
+
+	for (i = 0; i < runs->len; i++)
+	{
+		const gchar *run = g_ptr_array_index(runs, i);
+
+		append_trigrams(trigrams, run, strlen(run), ! matchcase);
+	}
+	g_ptr_array_free(runs, TRUE);
+
+	unique_trigrams(trigrams);
+	if (trigrams->len == 0)
+	{
+		g_array_free(trigrams, TRUE);
+		return NULL;
+	}
+	return trigrams;
+}
+
+
+/* Tells whether the file at path, a real path, may contain all trigrams. Can be called from
+ * any thread. */
+FifIndexResult fif_index_lookup(FifIndex *index, const gchar *path, gint64 mtime, gint64 size,
+		GArray *trigrams)
+{
+	FifIndexEntry *entry;
+	FifIndexResult result = FIF_INDEX_STALE;
+
+	g_mutex_lock(&index->lock);
+	entry = g_hash_table_lookup(index->entries, path);
+	if (entry != NULL && entry->mtime == mtime && entry->size == size)
+		result = entry_matches(entry, trigrams) ? FIF_INDEX_MATCH : FIF_INDEX_NO_MATCH;
+	g_mutex_unlock(&index->lock);
+
+	return result;
+}
+
+
+/* Indexes the contents of the file at path, a real path. data is NULL for binary files.
+ * Can be called from any thread. */
+void fif_index_update(FifIndex *index, const gchar *path, gint64 mtime, gint64 size,
+		const gchar *data, gsize len)
+{
+	FifIndexEntry *entry;
+
+	if (len > MAX_INDEXED_SIZE)
+		return;
+
+	entry = create_entry(mtime, size, data, len);
+	g_mutex_lock(&index->lock);
+	g_hash_table_insert(index->entries, g_strdup(path), entry);
+	index->dirty = TRUE;
+	g_mutex_unlock(&index->lock);
+}
+
+
+static void on_document_save(GObject *obj, GeanyDocument *doc, gpointer user_data)
+{
+	GMappedFile *map;
+	GStatBuf st;
+
+	if (project_index == NULL || doc->real_path == NULL)
+		return;
+
+	if (! is_in_base_path(project_index, doc->real_path) || g_stat(doc->real_path, &st) != 0)
+		return;
+
+	map = g_mapped_file_new(doc->real_path, FALSE, NULL);
+	if (map != NULL)
+	{
+		const gchar *contents = g_mapped_file_get_contents(map);
+		gsize len = g_mapped_file_get_length(map);
+
+		/* like the search, treat files with a NUL byte early on as binary */
+		if (len > 0 && memchr(contents, '\0', MIN(len, FIF_BINARY_CHECK_LEN)) != NULL)
+			contents = NULL;
+		else if (len == 0)
+			contents = "";
+		fif_index_update(project_index, doc->real_path, st.st_mtime, st.st_size, contents, len);
+		g_mapped_file_unref(map);
+	}
+}
+
+
+static void on_project_close(GObject *obj, gpointer user_data)
+{
+	close_project_index();
+}
+
+
+void fif_index_init(void)
+{
+	g_signal_connect(geany_object, "document-save", G_CALLBACK(on_document_save), NULL);
+	g_signal_connect(geany_object, "project-close", G_CALLBACK(on_project_close), NULL);
+}
+
+
+void fif_index_finalize(void)
+{
+	close_project_index();
+}
@@ -0,0 +1,61 @@
+/*
+ *      fifindex.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2016 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEANY_FIF_INDEX_H
+#define GEANY_FIF_INDEX_H 1
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* like grep, files with a NUL byte in their first part are binary files, not searched */
+#define FIF_BINARY_CHECK_LEN 32768
+
+typedef struct FifIndex FifIndex;
+
+typedef enum
+{
+	FIF_INDEX_STALE,		/* the file is not indexed or has changed */
+	FIF_INDEX_MATCH,		/* the file may contain the text */
+	FIF_INDEX_NO_MATCH		/* the file doesn't contain the text */
+}
+FifIndexResult;
+
+
+void fif_index_init(void);
+
+void fif_index_finalize(void);
+
+FifIndex *fif_index_get(const gchar *locale_dir);
+
+void fif_index_unref(FifIndex *index);
+
+GArray *fif_index_get_trigrams(const gchar *text, gboolean regexp, gboolean matchcase);
+
+FifIndexResult fif_index_lookup(FifIndex *index, const gchar *path, gint64 mtime, gint64 size,
+		GArray *trigrams);
+
+void fif_index_update(FifIndex *index, const gchar *path, gint64 mtime, gint64 size,
+		const gchar *data, gsize len);
+
+
+G_END_DECLS
+
+#endif /* GEANY_FIF_INDEX_H */
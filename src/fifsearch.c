@@ -0,0 +1,1058 @@
+/*
+ *      fifsearch.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2016 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Built-in Find in Files, used instead of the Grep tool when chosen in the dialog, and
+ * Find Usage.
+ *
+ * A walker thread lists the files to search and passes them to a thread pool, whose
+ * threads map each file into memory and search it. The matching lines are formatted like
+ * grep -nH output and queued in batches, which the main thread adds to the Messages tab
+ * in time slices.
+ *
+ * Open documents are searched from a copy of their buffer taken when the search starts, so
+ * unsaved changes are found and the walker skips their files on disk. Find Usage searches
+ * only these copies, with the same threads.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "fifsearch.h"
+
+#include "document.h"
+#include "fifindex.h"
+#include "msgwindow.h"
+#include "sciwrappers.h"
+#include "support.h"
+#include "tm_source_file.h"
+#include "ui_utils.h"
+#include "utils.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+
+/* how often the main thread checks for results, in ms */
+#define FIF_SEARCH_POLL_INTERVAL 50
+/* the time the main thread may spend adding results at once, in µs */
+#define FIF_SEARCH_SLICE 10000
+/* matching lines of a file are queued in batches of this many */
+#define RESULT_BATCH_LINES 1000
+
+
+typedef struct
+{
+	gint refcount;			/* atomic */
+	gint stopped;			/* atomic */
+	FifSearchFlags flags;
+	gchar *dir;				/* real path in locale encoding, NULL for Find Usage */
+	gchar *enc;				/* the encoding of the files, NULL for UTF-8 */
+	GSList *patterns;		/* GPatternSpec, files to search or NULL for all */
+	GHashTable *open_files;	/* real paths of the open documents searched from memory */
+	gchar *literal;			/* search text if it is matched literally */
+	gsize literal_len;
+	gchar *utf8_literal;	/* literal for the open documents */
+	gsize utf8_literal_len;
+	GRegex *regex;			/* for UTF-8 files and open documents */
+	GRegex *raw_regex;		/* for other files */
+	GThreadPool *pool;
+	GAsyncQueue *results;	/* FifResult */
+	guint source_id;
+	FifIndex *index;		/* the project's index, or NULL */
+	GArray *trigrams;		/* trigrams the files must contain, or NULL */
+	/* Find Usage */
+	GeanyFindFlags usage_flags;
+	gchar *usage_text;		/* the text shown in the summary, NULL for Find in Files */
+	/* only used by the main thread */
+	gint match_count;
+}
+FifJob;
+
+typedef struct
+{
+	gchar *path;			/* NULL for an open document */
+	gchar *name;			/* as shown in the results */
+	guint doc_id;			/* the open document, 0 for a file on disk */
+	gchar *text;			/* copy of the document's buffer */
+	gsize len;
+	guint8 *word_chars;		/* table of the document's word characters, for Find Usage */
+	gboolean reindex;		/* whether to update the index for the file */
+	gint64 mtime;
+	gint64 size;
+}
+FifFile;
+
+typedef struct
+{
+	gint color;
+	guint count;			/* number of matches */
+	guint doc_id;			/* the open document the lines are from, or 0 */
+	gint *line_nums;		/* the line number of each line, if doc_id is set */
+	gchar *lines;			/* newline-separated, NULL when the search finished */
+}
+FifResult;
+
+/* collects the results of a file before they are queued */
+typedef struct
+{
+	FifFile *file;
+	GString *lines;
+	GString *tmp;
+	GArray *line_nums;
+	guint n_lines;
+	guint count;
+}
+FifBatch;
+
+
+static FifJob *current_job = NULL;
+
+/* directories of version control systems, which are not searched */
+static const gchar *const skipped_dirs[] = { ".bzr", ".git", ".hg", ".svn", "_darcs", "CVS", NULL };
+
+
+static void result_free(gpointer data)
+{
+	FifResult *result = data;
+
+	g_free(result->line_nums);
+	g_free(result->lines);
+	g_free(result);
+}
+
+
+static void push_result(FifJob *job, gint color, GString *lines, guint count)
+{
+	FifResult *result = g_new0(FifResult, 1);
+
+	result->color = color;
+	result->count = count;
+	result->lines = lines != NULL ? g_strndup(lines->str, lines->len) : NULL;
+	g_async_queue_push(job->results, result);
+}
+
+
+static void file_free(FifFile *file)
+{
+	g_free(file->path);
+	g_free(file->name);
+	g_free(file->text);
+	g_free(file->word_chars);
+	g_free(file);
+}
+
+
+static void job_unref(FifJob *job)
+{
+	if (! g_atomic_int_dec_and_test(&job->refcount))
+		return;
+
+	g_slist_foreach(job->patterns, (GFunc) g_pattern_spec_free, NULL);
+	if (job->pool != NULL)
+		g_thread_pool_free(job->pool, TRUE, TRUE);
+	g_slist_free(job->patterns);
+	if (job->open_files != NULL)
+		g_hash_table_destroy(job->open_files);
+	if (job->index != NULL)
+		fif_index_unref(job->index);
+	if (job->trigrams != NULL)
+		g_array_free(job->trigrams, TRUE);
+	if (job->regex != NULL)
+		g_regex_unref(job->regex);
+	if (job->raw_regex != NULL)
+		g_regex_unref(job->raw_regex);
+	if (job->results != NULL)
+		g_async_queue_unref(job->results);
+	g_free(job->literal);
+	g_free(job->utf8_literal);
+	g_free(job->usage_text);
+	g_free(job->enc);
+	g_free(job->dir);
+	g_free(job);
+}
+
+
+static gboolean job_stopped(FifJob *job)
+{
+	return g_atomic_int_get(&job->stopped);
+}
+
+
+/* Finds needle in [hay, end). memchr() is vectorized, so this is fast for
+ * the usual needles which don't start with a frequent character. */
+static const gchar *find_literal(const gchar *hay, const gchar *end, const gchar *needle, gsize len)
+{
+	const gchar *last;
+
+	if ((gsize) (end - hay) < len)
+		return NULL;
+
+	last = end - len;
+	while (hay <= last)
+	{
+		hay = memchr(hay, needle[0], last - hay + 1);
+		if (hay == NULL)
+			return NULL;
+		if (memcmp(hay + 1, needle + 1, len - 1) == 0)
+			return hay;
+		hay++;
+	}
+	return NULL;
+}
+
+
+/* Finds the first match of regex or of the literal text from pos on, and sets *match_end */
+static const gchar *find_match(FifJob *job, GRegex *regex, const gchar *literal, gsize literal_len,
+		const gchar *data, const gchar *pos, const gchar *end, const gchar **match_end)
+{
+	GMatchInfo *info;
+	const gchar *match = NULL;
+
+	if (regex == NULL)
+	{
+		match = find_literal(pos, end, literal, literal_len);
+		if (match != NULL)
+			*match_end = match + literal_len;
+		return match;
+	}
+
+	if (g_regex_match_full(regex, data, end - data, pos - data, 0, &info, NULL))
+	{
+		gint start, stop;
+
+		g_match_info_fetch_pos(info, 0, &start, &stop);
+		match = data + start;
+		*match_end = data + stop;
+	}
+	g_match_info_free(info);
+	return match;
+}
+
+
+static void batch_init(FifBatch *batch, FifFile *file)
+{
+	batch->file = file;
+	batch->lines = g_string_sized_new(256);
+	batch->tmp = g_string_sized_new(256);
+	batch->line_nums = file->doc_id != 0 ? g_array_new(FALSE, FALSE, sizeof(gint)) : NULL;
+	batch->n_lines = 0;
+	batch->count = 0;
+}
+
+
+static void batch_flush(FifJob *job, FifBatch *batch)
+{
+	FifResult *result;
+
+	if (batch->n_lines == 0)
+		return;
+
+	result = g_new(FifResult, 1);
+	result->color = COLOR_BLACK;
+	result->count = batch->count;
+	result->doc_id = batch->file->doc_id;
+	result->line_nums = batch->line_nums != NULL ?
+		g_memdup(batch->line_nums->data, batch->line_nums->len * sizeof(gint)) : NULL;
+	result->lines = g_strndup(batch->lines->str, batch->lines->len);
+	g_async_queue_push(job->results, result);
+
+	g_string_truncate(batch->lines, 0);
+	if (batch->line_nums != NULL)
+		g_array_set_size(batch->line_nums, 0);
+	batch->n_lines = 0;
+	batch->count = 0;
+}
+
+
+static void batch_free(FifJob *job, FifBatch *batch)
+{
+	batch_flush(job, batch);
+	g_string_free(batch->lines, TRUE);
+	g_string_free(batch->tmp, TRUE);
+	if (batch->line_nums != NULL)
+		g_array_free(batch->line_nums, TRUE);
+}
+
+
+/* tmp holds the formatted line */
+static void batch_add_line(FifJob *job, FifBatch *batch, guint line_num)
+{
+	GString *tmp = batch->tmp;
+	gchar *utf8_line = NULL;
+
+	/* enc is NULL when encoding is set to UTF-8, so we can skip any conversion */
+	if (batch->file->doc_id == 0 && job->enc != NULL && ! g_utf8_validate(tmp->str, -1, NULL))
+		utf8_line = g_convert(tmp->str, -1, "UTF-8", job->enc, NULL, NULL, NULL);
+
+	g_string_append(batch->lines, utf8_line != NULL ? utf8_line : tmp->str);
+	g_string_append_c(batch->lines, '\n');
+	g_free(utf8_line);
+
+	if (batch->line_nums != NULL)
+	{
+		gint line = (gint) line_num;
+
+		g_array_append_val(batch->line_nums, line);
+	}
+	if (++batch->n_lines == RESULT_BATCH_LINES)
+		batch_flush(job, batch);
+}
+
+
+static void search_buffer(FifJob *job, FifFile *file, const gchar *data, gsize len)
+{
+	const gchar *end = data + len;
+	const gchar *line = data;
+	guint line_num = 1;
+	GRegex *regex = NULL;
+	const gchar *literal = job->literal;
+	gsize literal_len = job->literal_len;
+	FifBatch batch;
+
+	if (file->doc_id != 0)
+	{
+		literal = job->utf8_literal;
+		literal_len = job->utf8_literal_len;
+	}
+	if (literal == NULL)
+	{
+		if (file->doc_id != 0 || (job->enc == NULL && g_utf8_validate(data, len, NULL)))
+			regex = job->regex;
+		else
+			regex = job->raw_regex;
+	}
+
+	batch_init(&batch, file);
+	while (line < end && ! job_stopped(job))
+	{
+		const gchar *line_end, *match_end;
+		gboolean matches;
+
+		if (! (job->flags & FIF_SEARCH_INVERT))
+		{
+			/* the match might span lines, so the line still has to be checked on its own */
+			const gchar *candidate = find_match(job, regex, literal, literal_len,
+				data, line, end, &match_end);
+			const gchar *nl;
+
+			if (candidate == NULL)
+				break;
+			/* move to the line of the candidate */
+			while ((nl = memchr(line, '\n', candidate - line)) != NULL)
+			{
+				line = nl + 1;
+				line_num++;
+			}
+		}
+
+		line_end = memchr(line, '\n', end - line);
+		if (line_end == NULL)
+			line_end = end;
+
+		if (regex == NULL)
+			matches = find_literal(line, line_end, literal, literal_len) != NULL;
+		else
+			matches = g_regex_match_full(regex, line, line_end - line, 0, 0, NULL, NULL);
+
+		if (matches != ((job->flags & FIF_SEARCH_INVERT) != 0))
+		{
+			g_string_printf(batch.tmp, "%s:%u:", file->name, line_num);
+			g_string_append_len(batch.tmp, line, line_end - line);
+			g_strchomp(batch.tmp->str);
+			batch.count++;
+			batch_add_line(job, &batch, line_num);
+		}
+
+		line = line_end + 1;
+		line_num++;
+	}
+	batch_free(job, &batch);
+}
+
+
+/* Whether the match from start to end is a word, or starts one, like Scintilla checks it */
+static gboolean is_word_match(FifJob *job, FifFile *file, const gchar *start, const gchar *end)
+{
+	const guchar *text = (const guchar *) file->text;
+
+	if ((const guchar *) start > text && file->word_chars[((const guchar *) start)[-1]])
+		return FALSE;
+	if ((job->usage_flags & GEANY_FIND_WHOLEWORD) && end < file->text + file->len &&
+		file->word_chars[*(const guchar *) end])
+		return FALSE;
+	return TRUE;
+}
+
+
+/* Finds the next usage from pos on, like search_find_text() does in the document */
+static const gchar *find_usage(FifJob *job, FifFile *file, const gchar *pos, const gchar **match_end)
+{
+	const gchar *end = file->text + file->len;
+
+	if ((job->usage_flags & GEANY_FIND_REGEXP) && ! (job->usage_flags & GEANY_FIND_MULTILINE))
+	{
+		/* single-line mode, match against each line without its line ending */
+		const gchar *line = pos;
+
+		while (line > file->text && line[-1] != '\n')
+			line--;
+		while (line < end)
+		{
+			const gchar *line_end = memchr(line, '\n', end - line);
+			const gchar *match;
+
+			if (line_end == NULL)
+				line_end = end;
+			else if (line_end > line && line_end[-1] == '\r')
+				line_end--;
+			if (pos <= line_end)
+			{
+				match = find_match(job, job->regex, NULL, 0, line, MAX(pos, line), line_end, match_end);
+				if (match != NULL)
+					return match;
+			}
+
+			line = memchr(line_end, '\n', end - line_end);
+			if (line == NULL)
+				break;
+			line++;
+		}
+		return NULL;
+	}
+
+	for (;;)
+	{
+		const gchar *match = find_match(job, job->regex, job->utf8_literal, job->utf8_literal_len,
+			file->text, pos, end, match_end);
+
+		if (match == NULL || file->word_chars == NULL || is_word_match(job, file, match, *match_end))
+			return match;
+		pos = match + 1;
+	}
+}
+
+
+static void search_usage(FifJob *job, FifFile *file)
+{
+	const gchar *end = file->text + file->len;
+	const gchar *pos = file->text;
+	const gchar *line = file->text;
+	const gchar *match, *match_end;
+	guint line_num = 1;
+	guint prev_line = 0;
+	FifBatch batch;
+
+	batch_init(&batch, file);
+	while (pos <= end && ! job_stopped(job) &&
+		(match = find_usage(job, file, pos, &match_end)) != NULL)
+	{
+		const gchar *nl;
+
+		while ((nl = memchr(line, '\n', match - line)) != NULL)
+		{
+			line = nl + 1;
+			line_num++;
+		}
+		/* like find_document_usage(), list each line once but count all matches */
+		batch.count++;
+		if (line_num != prev_line)
+		{
+			const gchar *line_end = memchr(line, '\n', end - line);
+			gsize prefix_len;
+
+			if (line_end == NULL)
+				line_end = end;
+			g_string_printf(batch.tmp, "%s:%u: ", file->name, line_num);
+			prefix_len = batch.tmp->len;
+			g_string_append_len(batch.tmp, line, line_end - line);
+			g_strstrip(batch.tmp->str + prefix_len);
+			batch_add_line(job, &batch, line_num);
+			prev_line = line_num;
+		}
+
+		/* avoid rematching with empty matches, like find_range() */
+		pos = match_end > match ? match_end : match + 1;
+	}
+	batch_free(job, &batch);
+}
+
+
+static void push_error(FifJob *job, const gchar *message)
+{
+	GString *str = g_string_new(message);
+
+	g_string_append_c(str, '\n');
+	push_result(job, COLOR_DARK_RED, str, 1);
+	g_string_free(str, TRUE);
+}
+
+
+static void search_disk_file(FifJob *job, FifFile *file)
+{
+	GError *error = NULL;
+	GMappedFile *map = g_mapped_file_new(file->path, FALSE, &error);
+
+	if (map != NULL)
+	{
+		const gchar *contents = g_mapped_file_get_contents(map);
+		gsize len = g_mapped_file_get_length(map);
+
+		gboolean binary = len > 0 && memchr(contents, '\0', MIN(len, FIF_BINARY_CHECK_LEN)) != NULL;
+
+		if (len > 0 && ! binary)
+			search_buffer(job, file, contents, len);
+		if (file->reindex && ! job_stopped(job))
+		{
+			fif_index_update(job->index, file->path, file->mtime, file->size,
+				binary ? NULL : (len > 0 ? contents : ""), len);
+		}
+		g_mapped_file_unref(map);
+	}
+	else
+	{
+		push_error(job, error->message);
+		g_error_free(error);
+	}
+}
+
+
+/* called by the threads of the pool */
+static void search_file(gpointer data, gpointer user_data)
+{
+	FifFile *file = data;
+	FifJob *job = user_data;
+
+	if (! job_stopped(job))
+	{
+		if (file->path != NULL)
+			search_disk_file(job, file);
+		else if (job->usage_text != NULL)
+			search_usage(job, file);
+		else
+			search_buffer(job, file, file->text, file->len);
+	}
+	file_free(file);
+}
+
+
+static gboolean pattern_list_match(GSList *patterns, const gchar *str)
+{
+	GSList *item;
+
+	if (patterns == NULL)
+		return TRUE;
+
+	foreach_slist(item, patterns)
+	{
+		if (g_pattern_match_string(item->data, str))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+static gboolean is_skipped_dir(const gchar *name)
+{
+	const gchar *const *dir;
+
+	for (dir = skipped_dirs; *dir != NULL; dir++)
+	{
+		if (strcmp(name, *dir) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+
+/* prefix is the start of the names shown for the files in dir, or NULL */
+static void walk_dir(FifJob *job, const gchar *dir, const gchar *prefix)
+{
+	GError *error = NULL;
+	GDir *gdir = g_dir_open(dir, 0, &error);
+	const gchar *filename;
+
+	if (gdir == NULL)
+	{
+		push_error(job, error->message);
+		g_error_free(error);
+		return;
+	}
+
+	while (! job_stopped(job) && (filename = g_dir_read_name(gdir)) != NULL)
+	{
+		gchar *path = g_build_filename(dir, filename, NULL);
+		gchar *name = prefix != NULL ?
+			g_strconcat(prefix, "/", filename, NULL) : g_strdup(filename);
+		GStatBuf st;
+		FifIndexResult indexed;
+
+		if (job->flags & FIF_SEARCH_RECURSIVE)
+		{
+			/* like grep -r, don't follow symbolic links */
+			if (g_lstat(path, &st) != 0)
+				st.st_mode = 0;
+#ifdef S_ISLNK
+			if (S_ISLNK(st.st_mode))
+				st.st_mode = 0;
+#endif
+			if (S_ISDIR(st.st_mode) && ! is_skipped_dir(filename))
+				walk_dir(job, path, name);
+		}
+		else if (g_stat(path, &st) != 0)
+			st.st_mode = 0;
+
+		if (S_ISREG(st.st_mode) && pattern_list_match(job->patterns, filename) &&
+			! g_hash_table_contains(job->open_files, path) &&
+			/* skip files the index tells can't match */
+			(indexed = job->index == NULL ? FIF_INDEX_MATCH : fif_index_lookup(job->index,
+				path, st.st_mtime, st.st_size, job->trigrams)) != FIF_INDEX_NO_MATCH)
+		{
+			FifFile *file = g_new0(FifFile, 1);
+
+			file->path = path;
+			file->name = name;
+			file->reindex = indexed == FIF_INDEX_STALE;
+			file->mtime = st.st_mtime;
+			file->size = st.st_size;
+			g_thread_pool_push(job->pool, file, NULL);
+		}
+		else
+		{
+			g_free(path);
+			g_free(name);
+		}
+	}
+	g_dir_close(gdir);
+}
+
+
+static gpointer walk_thread(gpointer data)
+{
+	FifJob *job = data;
+
+	/* use '.' so we get relative paths like grep -r does in search_find_in_files() */
+	if (job->dir != NULL)
+		walk_dir(job, job->dir, (job->flags & FIF_SEARCH_RECURSIVE) ? "." : NULL);
+
+	/* wait for the queued files to be searched */
+	g_thread_pool_free(job->pool, FALSE, TRUE);
+	job->pool = NULL;
+	push_result(job, COLOR_BLUE, NULL, 0);
+
+	job_unref(job);
+	return NULL;
+}
+
+
+static void finish_search(FifJob *job)
+{
+	if (job->usage_text != NULL)
+	{
+		if (job->match_count == 0)
+		{
+			ui_set_statusbar(FALSE, _("No matches found for \"%s\"."), job->usage_text);
+			msgwin_msg_add(COLOR_BLUE, -1, NULL, _("No matches found for \"%s\"."), job->usage_text);
+		}
+		else
+		{
+			ui_set_statusbar(FALSE, ngettext(
+				"Found %d match for \"%s\".", "Found %d matches for \"%s\".", job->match_count),
+				job->match_count, job->usage_text);
+			msgwin_msg_add(COLOR_BLUE, -1, NULL, ngettext(
+				"Found %d match for \"%s\".", "Found %d matches for \"%s\".", job->match_count),
+				job->match_count, job->usage_text);
+		}
+	}
+	else
+	{
+		if (job->match_count > 0)
+		{
+			gchar *text = ngettext(
+						"Search completed with %d match.",
+						"Search completed with %d matches.", job->match_count);
+
+			msgwin_msg_add(COLOR_BLUE, -1, NULL, text, job->match_count);
+			ui_set_statusbar(FALSE, text, job->match_count);
+		}
+		else
+		{
+			const gchar *msg = _("No matches found.");
+
+			msgwin_msg_add_string(COLOR_BLUE, -1, NULL, msg);
+			ui_set_statusbar(FALSE, "%s", msg);
+		}
+		utils_beep();
+	}
+	ui_progress_bar_stop();
+
+	current_job = NULL;
+	job_unref(job);
+}
+
+
+static gboolean show_results(gpointer data)
+{
+	const gint64 end_time = g_get_monotonic_time() + FIF_SEARCH_SLICE;
+	FifJob *job = data;
+	FifResult *result;
+
+	while (g_get_monotonic_time() < end_time &&
+		(result = g_async_queue_try_pop(job->results)) != NULL)
+	{
+		GeanyDocument *doc = NULL;
+		gchar *line, *next;
+		guint i = 0;
+
+		if (result->lines == NULL)
+		{
+			result_free(result);
+			job->source_id = 0;
+			finish_search(job);
+			return FALSE;
+		}
+
+		/* the lines of a closed document can still be opened by their file name */
+		if (result->doc_id != 0)
+			doc = document_find_by_id(result->doc_id);
+
+		for (line = result->lines; *line != '\0'; line = next + 1, i++)
+		{
+			next = strchr(line, '\n');
+			*next = '\0';
+			msgwin_msg_add_string(result->color, doc != NULL ? result->line_nums[i] : -1, doc, line);
+		}
+		if (result->color == COLOR_BLACK)
+			job->match_count += result->count;
+		result_free(result);
+	}
+	return TRUE;
+}
+
+
+/* Escapes the ASCII punctuation in text, which works for text in any encoding */
+static gchar *escape_literal(const gchar *text)
+{
+	GString *str = g_string_sized_new(strlen(text) * 2);
+
+	for (; *text != '\0'; text++)
+	{
+		if (g_ascii_ispunct(*text))
+			g_string_append_c(str, '\\');
+		g_string_append_c(str, *text);
+	}
+	return g_string_free(str, FALSE);
+}
+
+
+static GRegex *compile_regex(const gchar *text, FifSearchFlags flags, gboolean raw, GError **error)
+{
+	GRegexCompileFlags cflags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+	gchar *pattern;
+	GRegex *regex;
+
+	if (raw)
+		cflags |= G_REGEX_RAW;
+	if (! (flags & FIF_SEARCH_MATCHCASE))
+		cflags |= G_REGEX_CASELESS;
+
+	pattern = (flags & FIF_SEARCH_REGEXP) ? g_strdup(text) : escape_literal(text);
+	if (flags & FIF_SEARCH_WHOLEWORD)
+		SETPTR(pattern, g_strconcat("(?<!\\w)(?:", pattern, ")(?!\\w)", NULL));
+
+	regex = g_regex_new(pattern, cflags, 0, error);
+	g_free(pattern);
+	return regex;
+}
+
+
+/* Returns the name shown for the open document at real_path if it is one of the files to
+ * search, like walk_dir() names it, or NULL */
+static gchar *get_document_name(FifJob *job, const gchar *real_path)
+{
+	gsize dir_len = strlen(job->dir);
+	const gchar *rel = real_path + dir_len;
+	gchar **parts, **part;
+	gchar *name = NULL;
+
+	if (strncmp(real_path, job->dir, dir_len) != 0)
+		return NULL;
+	if (dir_len == 0 || ! G_IS_DIR_SEPARATOR(job->dir[dir_len - 1]))
+	{
+		if (! G_IS_DIR_SEPARATOR(*rel))
+			return NULL;
+		rel++;
+	}
+
+	parts = g_strsplit(rel, G_DIR_SEPARATOR_S, -1);
+	/* stop at the file name, or at a directory walk_dir() doesn't enter */
+	for (part = parts; *part != NULL && part[1] != NULL; part++)
+	{
+		if (! (job->flags & FIF_SEARCH_RECURSIVE) || is_skipped_dir(*part))
+			break;
+	}
+	if (*part != NULL && part[1] == NULL && pattern_list_match(job->patterns, *part))
+	{
+		gchar *path = g_strjoinv("/", parts);
+
+		name = (job->flags & FIF_SEARCH_RECURSIVE) ? g_strconcat("./", path, NULL) : g_strdup(path);
+		g_free(path);
+		SETPTR(name, utils_get_utf8_from_locale(name));
+	}
+	g_strfreev(parts);
+	return name;
+}
+
+
+/* Copies the buffer of doc, so it can be searched by the threads */
+static FifFile *snapshot_document(GeanyDocument *doc, gchar *name, gboolean word_chars)
+{
+	ScintillaObject *sci = doc->editor->sci;
+	FifFile *file = g_new0(FifFile, 1);
+
+	file->name = name;
+	file->doc_id = doc->id;
+	file->len = (gsize) sci_get_length(sci);
+	file->text = sci_get_contents(sci, -1);
+
+	if (word_chars)
+	{
+		gint len = (gint) scintilla_send_message(sci, SCI_GETWORDCHARS, 0, 0);
+		guchar *chars = g_malloc(len + 1);
+		gint i;
+
+		scintilla_send_message(sci, SCI_GETWORDCHARS, 0, (sptr_t) chars);
+		file->word_chars = g_malloc0(256);
+		for (i = 0; i < len; i++)
+			file->word_chars[chars[i]] = TRUE;
+		g_free(chars);
+	}
+	return file;
+}
+
+
+static FifJob *job_new(void)
+{
+	FifJob *job = g_new0(FifJob, 1);
+	guint n_threads = 4;
+
+	job->refcount = 1;
+	job->results = g_async_queue_new_full(result_free);
+#if GLIB_CHECK_VERSION(2, 36, 0)
+	n_threads = MAX(g_get_num_processors(), 1);
+#endif
+	job->pool = g_thread_pool_new(search_file, job, n_threads, FALSE, NULL);
+	return job;
+}
+
+
+/* Starts the walker thread, which ends the search once the pool is done */
+static gboolean job_start(FifJob *job, GError **error)
+{
+	GThread *thread;
+
+	/* the walker thread holds a reference until it is done */
+	g_atomic_int_inc(&job->refcount);
+	thread = g_thread_try_new("fifsearch", walk_thread, job, error);
+	if (thread == NULL)
+	{
+		/* stop the queued open documents from being searched */
+		g_atomic_int_set(&job->stopped, TRUE);
+		g_thread_pool_free(job->pool, FALSE, TRUE);
+		job->pool = NULL;
+		job_unref(job);	/* the walker thread's reference */
+		job_unref(job);
+		return FALSE;
+	}
+	g_thread_unref(thread);
+
+	current_job = job;
+	job->source_id = g_timeout_add(FIF_SEARCH_POLL_INTERVAL, show_results, job);
+	return TRUE;
+}
+
+
+/* Starts searching the files in utf8_dir matching the space-separated patterns in files
+ * (NULL for all files), adding the results to the Messages tab as they are found.
+ * The open documents in utf8_dir are searched from memory instead of their files.
+ * A running search must be stopped first. */
+gboolean fif_search_start(const gchar *utf8_search_text, const gchar *utf8_dir,
+		const gchar *files, const gchar *enc, FifSearchFlags flags, GError **error)
+{
+	FifJob *job;
+	gchar *search_text = NULL;
+	gchar *locale_dir;
+	gsize utf8_text_len = strlen(utf8_search_text);
+	guint i;
+
+	g_return_val_if_fail(! EMPTY(utf8_search_text) && utf8_dir != NULL, FALSE);
+	g_return_val_if_fail(current_job == NULL, FALSE);
+
+	/* convert the search text in the preferred encoding (if the text is not valid UTF-8. assume
+	 * it is already in the preferred encoding) */
+	if (enc != NULL && g_utf8_validate(utf8_search_text, utf8_text_len, NULL))
+		search_text = g_convert(utf8_search_text, utf8_text_len, enc, "UTF-8", NULL, NULL, NULL);
+	if (search_text == NULL)
+		search_text = g_strdup(utf8_search_text);
+
+	job = job_new();
+	job->flags = flags;
+	job->enc = g_strdup(enc);
+	/* with inverted results, any file can have non-matching lines */
+	if (! (flags & FIF_SEARCH_INVERT))
+	{
+		job->trigrams = fif_index_get_trigrams(search_text, (flags & FIF_SEARCH_REGEXP) != 0,
+			(flags & FIF_SEARCH_MATCHCASE) != 0);
+	}
+
+	if ((flags & FIF_SEARCH_MATCHCASE) && ! (flags & (FIF_SEARCH_REGEXP | FIF_SEARCH_WHOLEWORD)))
+	{
+		job->literal = search_text;
+		job->literal_len = strlen(search_text);
+		job->utf8_literal = g_strdup(utf8_search_text);
+		job->utf8_literal_len = utf8_text_len;
+	}
+	else
+	{
+		/* the open documents are always UTF-8 */
+		job->regex = compile_regex(utf8_search_text, flags, FALSE, error);
+		if (job->regex != NULL)
+			job->raw_regex = compile_regex(search_text, flags, TRUE, error);
+		g_free(search_text);
+
+		if (job->raw_regex == NULL)
+		{
+			job_unref(job);
+			return FALSE;
+		}
+	}
+
+	if (files != NULL)
+	{
+		gchar **patterns = g_strsplit_set(files, " \t", -1);
+		gchar **pattern;
+
+		foreach_strv(pattern, patterns)
+		{
+			if (**pattern != '\0')
+				job->patterns = g_slist_prepend(job->patterns, g_pattern_spec_new(*pattern));
+		}
+		g_strfreev(patterns);
+	}
+
+	/* use the real path so the open documents' files are recognized */
+	locale_dir = utils_get_locale_from_utf8(utf8_dir);
+	job->dir = tm_get_real_path(locale_dir);
+	g_free(locale_dir);
+	if (! (flags & FIF_SEARCH_INVERT))
+		job->index = fif_index_get(job->dir);
+
+	job->open_files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	foreach_document(i)
+	{
+		GeanyDocument *doc = documents[i];
+		gchar *name;
+
+		if (doc->real_path == NULL || (name = get_document_name(job, doc->real_path)) == NULL)
+			continue;
+
+		g_hash_table_add(job->open_files, g_strdup(doc->real_path));
+		g_thread_pool_push(job->pool, snapshot_document(doc, name, FALSE), NULL);
+	}
+
+	return job_start(job, error);
+}
+
+
+/* Starts searching doc, or all open documents if it is NULL, like find_document_usage() does
+ * but with the threads. regex is used instead of search_text if flags contain
+ * GEANY_FIND_REGEXP. */
+gboolean fif_search_start_usage(const gchar *search_text, const gchar *original_search_text,
+		GeanyFindFlags flags, GRegex *regex, GeanyDocument *doc, GError **error)
+{
+	FifJob *job;
+	gboolean word_chars = FALSE;
+	guint i;
+
+	g_return_val_if_fail(! EMPTY(search_text) && original_search_text != NULL, FALSE);
+	g_return_val_if_fail(! (flags & GEANY_FIND_REGEXP) || regex != NULL, FALSE);
+	g_return_val_if_fail(current_job == NULL, FALSE);
+
+	job = job_new();
+	job->usage_flags = flags;
+	job->usage_text = g_strdup(original_search_text);
+
+	if (flags & GEANY_FIND_REGEXP)
+		job->regex = g_regex_ref(regex);
+	else
+	{
+		word_chars = (flags & (GEANY_FIND_WHOLEWORD | GEANY_FIND_WORDSTART)) != 0;
+		if (flags & GEANY_FIND_MATCHCASE)
+		{
+			job->utf8_literal = g_strdup(search_text);
+			job->utf8_literal_len = strlen(search_text);
+		}
+		else
+		{
+			job->regex = compile_regex(search_text, 0, FALSE, error);
+			if (job->regex == NULL)
+			{
+				job_unref(job);
+				return FALSE;
+			}
+		}
+	}
+
+	foreach_document(i)
+	{
+		if (doc == NULL || documents[i] == doc)
+		{
+			gchar *name = g_path_get_basename(DOC_FILENAME(documents[i]));
+
+			g_thread_pool_push(job->pool, snapshot_document(documents[i], name, word_chars), NULL);
+		}
+	}
+
+	return job_start(job, error);
+}
+
+
+gboolean fif_search_is_running(void)
+{
+	return current_job != NULL;
+}
+
+
+/* Stops the running search, the threads finish in the background. */
+void fif_search_stop(void)
+{
+	FifJob *job = current_job;
+
+	if (job == NULL)
+		return;
+
+	current_job = NULL;
+	g_atomic_int_set(&job->stopped, TRUE);
+	g_source_remove(job->source_id);
+	msgwin_msg_add_string(COLOR_BLUE, -1, NULL, _("Search stopped."));
+	ui_progress_bar_stop();
+	job_unref(job);
+}
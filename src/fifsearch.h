@@ -0,0 +1,54 @@
+/*
+ *      fifsearch.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2016 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEANY_FIF_SEARCH_H
+#define GEANY_FIF_SEARCH_H 1
+
+#include "document.h"
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+	FIF_SEARCH_REGEXP		= 1 << 0,
+	FIF_SEARCH_MATCHCASE	= 1 << 1,
+	FIF_SEARCH_WHOLEWORD	= 1 << 2,
+	FIF_SEARCH_INVERT		= 1 << 3,
+	FIF_SEARCH_RECURSIVE	= 1 << 4
+}
+FifSearchFlags;
+
+
+gboolean fif_search_start(const gchar *utf8_search_text, const gchar *utf8_dir,
+		const gchar *files, const gchar *enc, FifSearchFlags flags, GError **error);
+
+gboolean fif_search_start_usage(const gchar *search_text, const gchar *original_search_text,
+		GeanyFindFlags flags, GRegex *regex, GeanyDocument *doc, GError **error);
+
+gboolean fif_search_is_running(void);
+
+void fif_search_stop(void);
+
+
+G_END_DECLS
+
+#endif /* GEANY_FIF_SEARCH_H */
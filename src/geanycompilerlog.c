@@ -0,0 +1,614 @@
+/*
+ *      geanycompilerlog.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2016 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * A list GtkTreeModel for the Compiler tab, storing the lines in one text buffer.
+ * Lines can only be appended, and the oldest ones are dropped when there are more than
+ * the maximum number of lines. Whether a build output line is an error line is only
+ * checked when its color is requested, e.g. when the line is displayed.
+ *
+ * Iters store the number of the line counted since the last clear, so they remain valid
+ * until their line is dropped.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "geanycompilerlog.h"
+
+#include <string.h>
+
+
+/* flags stored with the color of a line */
+#define COLOR_MASK		0x3f
+#define PARSE_LINE		0x40	/* the line is build output */
+#define PARSE_PENDING	0x80	/* the line has not been parsed yet */
+
+/* dropped lines are only removed from the buffers once they are most of them */
+#define MIN_DROPPED_COMPACT 1024
+
+
+typedef struct
+{
+	guint line;		/* number of the first line the directory applies to */
+	gchar *dir;
+}
+LogDir;
+
+struct GeanyCompilerLogClass
+{
+	GObjectClass parent_class;
+};
+
+struct GeanyCompilerLog
+{
+	GObject parent;
+
+	gint stamp;
+	GString *text;			/* the lines, each one followed by a NUL */
+	GArray *offsets;		/* gsize offset of each line in text */
+	GArray *colors;			/* guint8 color and flags of each line */
+	guint first;			/* index of the first line which was not dropped */
+	guint base;				/* number of the line at index 0 */
+	guint max_lines;		/* 0 for no limit */
+	guint next_scan;		/* number of the line geany_compiler_log_scan_next() checks next */
+	GArray *dirs;			/* LogDir, by line number */
+	guint longest;			/* number of the longest line */
+	gsize longest_len;
+	GeanyCompilerLogParseFunc parse_func;
+};
+
+
+static void geany_compiler_log_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(GeanyCompilerLog, geany_compiler_log, G_TYPE_OBJECT,
+	G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, geany_compiler_log_tree_model_init))
+
+
+static guint get_n_lines(GeanyCompilerLog *log)
+{
+	return log->offsets->len - log->first;
+}
+
+
+static gboolean iter_is_valid(GeanyCompilerLog *log, GtkTreeIter *iter)
+{
+	guint line;
+
+	if (iter == NULL || iter->stamp != log->stamp)
+		return FALSE;
+
+	line = GPOINTER_TO_UINT(iter->user_data);
+	return line - log->base >= log->first && line - log->base < log->offsets->len;
+}
+
+
+static void set_iter(GeanyCompilerLog *log, GtkTreeIter *iter, guint index)
+{
+	iter->stamp = log->stamp;
+	iter->user_data = GUINT_TO_POINTER(log->base + index);
+	iter->user_data2 = NULL;
+	iter->user_data3 = NULL;
+}
+
+
+/* index of the iter's line in offsets and colors */
+static guint get_index(GeanyCompilerLog *log, GtkTreeIter *iter)
+{
+	return GPOINTER_TO_UINT(iter->user_data) - log->base;
+}
+
+
+static const gchar *get_line(GeanyCompilerLog *log, guint index)
+{
+	return log->text->str + g_array_index(log->offsets, gsize, index);
+}
+
+
+static const gchar *find_dir(GeanyCompilerLog *log, guint line)
+{
+	guint lo = 0;
+	guint hi = log->dirs->len;
+
+	/* find the last directory entered before line */
+	while (lo < hi)
+	{
+		guint mid = lo + (hi - lo) / 2;
+
+		if (g_array_index(log->dirs, LogDir, mid).line <= line)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo > 0 ? g_array_index(log->dirs, LogDir, lo - 1).dir : NULL;
+}
+
+
+static void set_dir(GeanyCompilerLog *log, guint line, const gchar *dir)
+{
+	LogDir entry;
+
+	if (log->dirs->len > 0 &&
+		g_strcmp0(g_array_index(log->dirs, LogDir, log->dirs->len - 1).dir, dir) == 0)
+		return;
+	if (log->dirs->len == 0 && dir == NULL)
+		return;
+
+	entry.line = line;
+	entry.dir = g_strdup(dir);
+	g_array_append_val(log->dirs, entry);
+}
+
+
+/* removes the dropped lines from the buffers */
+static void compact(GeanyCompilerLog *log)
+{
+	gsize start = g_array_index(log->offsets, gsize, log->first);
+	guint i;
+
+	g_string_erase(log->text, 0, start);
+	g_array_remove_range(log->offsets, 0, log->first);
+	g_array_remove_range(log->colors, 0, log->first);
+	for (i = 0; i < log->offsets->len; i++)
+		g_array_index(log->offsets, gsize, i) -= start;
+
+	log->base += log->first;
+	log->first = 0;
+}
+
+
+static void drop_first_line(GeanyCompilerLog *log)
+{
+	GtkTreePath *path = gtk_tree_path_new_from_indices(0, -1);
+	guint first_line;
+
+	log->first++;
+	gtk_tree_model_row_deleted(GTK_TREE_MODEL(log), path);
+	gtk_tree_path_free(path);
+
+	/* forget the directories no remaining line needs */
+	first_line = log->base + log->first;
+	while (log->dirs->len > 1 && g_array_index(log->dirs, LogDir, 1).line <= first_line)
+	{
+		g_free(g_array_index(log->dirs, LogDir, 0).dir);
+		g_array_remove_index(log->dirs, 0);
+	}
+
+	if (log->first >= MIN_DROPPED_COMPACT && log->first >= log->offsets->len / 2)
+		compact(log);
+}
+
+
+static void limit_lines(GeanyCompilerLog *log)
+{
+	if (log->max_lines == 0)
+		return;
+
+	while (get_n_lines(log) > log->max_lines)
+		drop_first_line(log);
+}
+
+
+/* Appends a line with the color @a color. If @a parse is set, the line is build output
+ * and @a dir the directory make entered before it, and whether the line is an error
+ * message is checked when its color is requested. Other lines use the directory of the
+ * previous build output. */
+void geany_compiler_log_append(GeanyCompilerLog *log, gint color, const gchar *string,
+		const gchar *dir, gboolean parse, GtkTreeIter *iter)
+{
+	gsize offset = log->text->len;
+	gsize len = strlen(string);
+	guint8 flags = color & COLOR_MASK;
+	guint index = log->offsets->len;
+	GtkTreePath *path;
+	GtkTreeIter new_iter;
+
+	g_return_if_fail(IS_GEANY_COMPILER_LOG(log));
+
+	if (parse)
+	{
+		flags |= PARSE_LINE | PARSE_PENDING;
+		set_dir(log, log->base + index, dir);
+	}
+
+	/* copy the terminating NUL as well */
+	g_string_append_len(log->text, string, len + 1);
+	g_array_append_val(log->offsets, offset);
+	g_array_append_val(log->colors, flags);
+
+	if (len > log->longest_len || get_n_lines(log) == 1)
+	{
+		log->longest = log->base + index;
+		log->longest_len = len;
+	}
+
+	set_iter(log, &new_iter, index);
+	path = gtk_tree_path_new_from_indices(index - log->first, -1);
+	gtk_tree_model_row_inserted(GTK_TREE_MODEL(log), path, &new_iter);
+	gtk_tree_path_free(path);
+
+	limit_lines(log);
+
+	/* the line numbers don't change when dropping lines */
+	if (iter != NULL)
+		*iter = new_iter;
+}
+
+
+void geany_compiler_log_clear(GeanyCompilerLog *log)
+{
+	guint i;
+
+	g_return_if_fail(IS_GEANY_COMPILER_LOG(log));
+
+	/* remove the lines from the last one, which is the cheapest for views */
+	while (get_n_lines(log) > 0)
+	{
+		GtkTreePath *path = gtk_tree_path_new_from_indices(get_n_lines(log) - 1, -1);
+
+		g_array_set_size(log->offsets, log->offsets->len - 1);
+		g_array_set_size(log->colors, log->colors->len - 1);
+		gtk_tree_model_row_deleted(GTK_TREE_MODEL(log), path);
+		gtk_tree_path_free(path);
+	}
+
+	for (i = 0; i < log->dirs->len; i++)
+		g_free(g_array_index(log->dirs, LogDir, i).dir);
+	g_array_set_size(log->dirs, 0);
+
+	g_string_truncate(log->text, 0);
+	log->first = 0;
+	log->base = 0;
+	log->next_scan = 0;
+	log->longest = 0;
+	log->longest_len = 0;
+	log->stamp++;
+}
+
+
+/* Sets the maximum number of lines kept, 0 for no limit. */
+void geany_compiler_log_set_max_lines(GeanyCompilerLog *log, guint max_lines)
+{
+	g_return_if_fail(IS_GEANY_COMPILER_LOG(log));
+
+	log->max_lines = max_lines;
+	limit_lines(log);
+}
+
+
+/* Returns the color of the line, parsing it first if that has not been done yet. */
+gint geany_compiler_log_get_color(GeanyCompilerLog *log, GtkTreeIter *iter)
+{
+	guint index;
+	guint8 flags;
+
+	g_return_val_if_fail(IS_GEANY_COMPILER_LOG(log), 0);
+	g_return_val_if_fail(iter_is_valid(log, iter), 0);
+
+	index = get_index(log, iter);
+	flags = g_array_index(log->colors, guint8, index);
+	if (flags & PARSE_PENDING)
+	{
+		gint color = flags & COLOR_MASK;
+
+		if (log->parse_func != NULL)
+			color = log->parse_func(get_line(log, index),
+				find_dir(log, GPOINTER_TO_UINT(iter->user_data)), color);
+		flags = (flags & PARSE_LINE) | (color & COLOR_MASK);
+		g_array_index(log->colors, guint8, index) = flags;
+	}
+	return flags & COLOR_MASK;
+}
+
+
+/* Sets the color of a line, e.g. after parsing it for geany_compiler_log_scan_next(). */
+void geany_compiler_log_set_color(GeanyCompilerLog *log, GtkTreeIter *iter, gint color)
+{
+	guint index;
+	guint8 flags;
+	GtkTreePath *path;
+
+	g_return_if_fail(IS_GEANY_COMPILER_LOG(log));
+	g_return_if_fail(iter_is_valid(log, iter));
+
+	index = get_index(log, iter);
+	flags = g_array_index(log->colors, guint8, index);
+	g_array_index(log->colors, guint8, index) = (flags & PARSE_LINE) | (color & COLOR_MASK);
+
+	/* views have not seen the color of a line which was not parsed yet */
+	if ((flags & PARSE_PENDING) || (flags & COLOR_MASK) == (color & COLOR_MASK))
+		return;
+
+	path = gtk_tree_path_new_from_indices(index - log->first, -1);
+	gtk_tree_model_row_changed(GTK_TREE_MODEL(log), path, iter);
+	gtk_tree_path_free(path);
+}
+
+
+/* The returned string is owned by the log and valid until the next change. */
+const gchar *geany_compiler_log_get_string(GeanyCompilerLog *log, GtkTreeIter *iter)
+{
+	g_return_val_if_fail(IS_GEANY_COMPILER_LOG(log), NULL);
+	g_return_val_if_fail(iter_is_valid(log, iter), NULL);
+
+	return get_line(log, get_index(log, iter));
+}
+
+
+/* Returns the directory make entered before the line, or NULL. */
+const gchar *geany_compiler_log_get_dir(GeanyCompilerLog *log, GtkTreeIter *iter)
+{
+	g_return_val_if_fail(IS_GEANY_COMPILER_LOG(log), NULL);
+	g_return_val_if_fail(iter_is_valid(log, iter), NULL);
+
+	return find_dir(log, GPOINTER_TO_UINT(iter->user_data));
+}
+
+
+/* Returns the longest line added since the last clear, or NULL if it has been dropped. */
+const gchar *geany_compiler_log_get_longest(GeanyCompilerLog *log)
+{
+	GtkTreeIter iter;
+
+	g_return_val_if_fail(IS_GEANY_COMPILER_LOG(log), NULL);
+
+	iter.stamp = log->stamp;
+	iter.user_data = GUINT_TO_POINTER(log->longest);
+	if (! iter_is_valid(log, &iter))
+		return NULL;
+	return get_line(log, get_index(log, &iter));
+}
+
+
+/* Gets the next build output line in the order they were added, whether it has been
+ * parsed already or not. Returns FALSE when all have been returned. */
+gboolean geany_compiler_log_scan_next(GeanyCompilerLog *log, GtkTreeIter *iter)
+{
+	guint index;
+
+	g_return_val_if_fail(IS_GEANY_COMPILER_LOG(log), FALSE);
+
+	if (log->next_scan < log->base + log->first)
+		log->next_scan = log->base + log->first;
+
+	for (index = log->next_scan - log->base; index < log->offsets->len; index++)
+	{
+		if (g_array_index(log->colors, guint8, index) & PARSE_LINE)
+		{
+			log->next_scan = log->base + index + 1;
+			set_iter(log, iter, index);
+			return TRUE;
+		}
+	}
+	log->next_scan = log->base + index;
+	return FALSE;
+}
+
+
+static GtkTreeModelFlags compiler_log_get_flags(GtkTreeModel *model)
+{
+	return GTK_TREE_MODEL_ITERS_PERSIST | GTK_TREE_MODEL_LIST_ONLY;
+}
+
+
+static gint compiler_log_get_n_columns(GtkTreeModel *model)
+{
+	return GEANY_COMPILER_LOG_N_COLUMNS;
+}
+
+
+static GType compiler_log_get_column_type(GtkTreeModel *model, gint column)
+{
+	switch (column)
+	{
+		case GEANY_COMPILER_LOG_COLUMN_COLOR: return G_TYPE_INT;
+		case GEANY_COMPILER_LOG_COLUMN_STRING: return G_TYPE_STRING;
+	}
+	g_return_val_if_reached(G_TYPE_INVALID);
+}
+
+
+static gboolean compiler_log_iter_nth_child(GtkTreeModel *model, GtkTreeIter *iter,
+		GtkTreeIter *parent, gint n)
+{
+	GeanyCompilerLog *log = GEANY_COMPILER_LOG(model);
+
+	if (parent != NULL || n < 0 || (guint) n >= get_n_lines(log))
+		return FALSE;
+
+	set_iter(log, iter, log->first + n);
+	return TRUE;
+}
+
+
+static gboolean compiler_log_get_iter(GtkTreeModel *model, GtkTreeIter *iter, GtkTreePath *path)
+{
+	if (gtk_tree_path_get_depth(path) != 1)
+		return FALSE;
+
+	return compiler_log_iter_nth_child(model, iter, NULL, gtk_tree_path_get_indices(path)[0]);
+}
+
+
+static GtkTreePath *compiler_log_get_path(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GeanyCompilerLog *log = GEANY_COMPILER_LOG(model);
+
+	g_return_val_if_fail(iter_is_valid(log, iter), NULL);
+
+	return gtk_tree_path_new_from_indices(get_index(log, iter) - log->first, -1);
+}
+
+
+static void compiler_log_get_value(GtkTreeModel *model, GtkTreeIter *iter, gint column,
+		GValue *value)
+{
+	GeanyCompilerLog *log = GEANY_COMPILER_LOG(model);
+
+	g_return_if_fail(iter_is_valid(log, iter));
+
+	switch (column)
+	{
+		case GEANY_COMPILER_LOG_COLUMN_COLOR:
+			g_value_init(value, G_TYPE_INT);
+			g_value_set_int(value, geany_compiler_log_get_color(log, iter));
+			break;
+
+		case GEANY_COMPILER_LOG_COLUMN_STRING:
+			g_value_init(value, G_TYPE_STRING);
+			g_value_set_string(value, get_line(log, get_index(log, iter)));
+			break;
+
+		default:
+			g_return_if_reached();
+	}
+}
+
+
+static gboolean compiler_log_iter_next(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GeanyCompilerLog *log = GEANY_COMPILER_LOG(model);
+	guint index;
+
+	g_return_val_if_fail(iter_is_valid(log, iter), FALSE);
+
+	index = get_index(log, iter) + 1;
+	if (index >= log->offsets->len)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+	set_iter(log, iter, index);
+	return TRUE;
+}
+
+
+#if GTK_CHECK_VERSION(3, 0, 0)
+static gboolean compiler_log_iter_previous(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	GeanyCompilerLog *log = GEANY_COMPILER_LOG(model);
+	guint index;
+
+	g_return_val_if_fail(iter_is_valid(log, iter), FALSE);
+
+	index = get_index(log, iter);
+	if (index == log->first)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+	set_iter(log, iter, index - 1);
+	return TRUE;
+}
+#endif
+
+
+static gboolean compiler_log_iter_children(GtkTreeModel *model, GtkTreeIter *iter,
+		GtkTreeIter *parent)
+{
+	return compiler_log_iter_nth_child(model, iter, parent, 0);
+}
+
+
+static gboolean compiler_log_iter_has_child(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	return FALSE;
+}
+
+
+static gint compiler_log_iter_n_children(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	if (iter != NULL)
+		return 0;
+
+	return get_n_lines(GEANY_COMPILER_LOG(model));
+}
+
+
+static gboolean compiler_log_iter_parent(GtkTreeModel *model, GtkTreeIter *iter,
+		GtkTreeIter *child)
+{
+	return FALSE;
+}
+
+
+static void geany_compiler_log_tree_model_init(GtkTreeModelIface *iface)
+{
+	iface->get_flags = compiler_log_get_flags;
+	iface->get_n_columns = compiler_log_get_n_columns;
+	iface->get_column_type = compiler_log_get_column_type;
+	iface->get_iter = compiler_log_get_iter;
+	iface->get_path = compiler_log_get_path;
+	iface->get_value = compiler_log_get_value;
+	iface->iter_next = compiler_log_iter_next;
+#if GTK_CHECK_VERSION(3, 0, 0)
+	iface->iter_previous = compiler_log_iter_previous;
+#endif
+	iface->iter_children = compiler_log_iter_children;
+	iface->iter_has_child = compiler_log_iter_has_child;
+	iface->iter_n_children = compiler_log_iter_n_children;
+	iface->iter_nth_child = compiler_log_iter_nth_child;
+	iface->iter_parent = compiler_log_iter_parent;
+}
+
+
+static void geany_compiler_log_finalize(GObject *object)
+{
+	GeanyCompilerLog *log = GEANY_COMPILER_LOG(object);
+	guint i;
+
+	for (i = 0; i < log->dirs->len; i++)
+		g_free(g_array_index(log->dirs, LogDir, i).dir);
+	g_array_free(log->dirs, TRUE);
+	g_array_free(log->colors, TRUE);
+	g_array_free(log->offsets, TRUE);
+	g_string_free(log->text, TRUE);
+
+	G_OBJECT_CLASS(geany_compiler_log_parent_class)->finalize(object);
+}
+
+
+static void geany_compiler_log_class_init(GeanyCompilerLogClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+	object_class->finalize = geany_compiler_log_finalize;
+}
+
+
+static void geany_compiler_log_init(GeanyCompilerLog *log)
+{
+	log->stamp = g_random_int();
+	log->text = g_string_new(NULL);
+	log->offsets = g_array_new(FALSE, FALSE, sizeof(gsize));
+	log->colors = g_array_new(FALSE, FALSE, sizeof(guint8));
+	log->dirs = g_array_new(FALSE, FALSE, sizeof(LogDir));
+}
+
+
+/* @a parse_func is called to get the color of build output lines when it is needed. */
+GeanyCompilerLog *geany_compiler_log_new(GeanyCompilerLogParseFunc parse_func)
+{
+	GeanyCompilerLog *log = g_object_new(GEANY_COMPILER_LOG_TYPE, NULL);
+
+	log->parse_func = parse_func;
+	return log;
+}
@@ -0,0 +1,74 @@
+/*
+ *      geanycompilerlog.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      Copyright 2016 The Geany contributors
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef GEANY_COMPILER_LOG_H
+#define GEANY_COMPILER_LOG_H 1
+
+#include "gtkcompat.h"
+
+G_BEGIN_DECLS
+
+
+#define GEANY_COMPILER_LOG_TYPE				(geany_compiler_log_get_type())
+#define GEANY_COMPILER_LOG(obj)				(G_TYPE_CHECK_INSTANCE_CAST((obj), \
+	GEANY_COMPILER_LOG_TYPE, GeanyCompilerLog))
+#define GEANY_COMPILER_LOG_CLASS(klass)		(G_TYPE_CHECK_CLASS_CAST((klass), \
+	GEANY_COMPILER_LOG_TYPE, GeanyCompilerLogClass))
+#define IS_GEANY_COMPILER_LOG(obj)			(G_TYPE_CHECK_INSTANCE_TYPE((obj), \
+	GEANY_COMPILER_LOG_TYPE))
+#define IS_GEANY_COMPILER_LOG_CLASS(klass)	(G_TYPE_CHECK_CLASS_TYPE((klass), \
+	GEANY_COMPILER_LOG_TYPE))
+
+
+/* columns of the model */
+enum
+{
+	GEANY_COMPILER_LOG_COLUMN_COLOR = 0,	/* G_TYPE_INT, a MsgColors value */
+	GEANY_COMPILER_LOG_COLUMN_STRING,		/* G_TYPE_STRING */
+	GEANY_COMPILER_LOG_N_COLUMNS
+};
+
+/* Returns the color of the line @a string added with the color @a color;
+ * @a dir is the directory make entered before the line or NULL. */
+typedef gint (*GeanyCompilerLogParseFunc)(const gchar *string, const gchar *dir, gint color);
+
+typedef struct GeanyCompilerLog       GeanyCompilerLog;
+typedef struct GeanyCompilerLogClass  GeanyCompilerLogClass;
+
+GType				geany_compiler_log_get_type			(void);
+GeanyCompilerLog*	geany_compiler_log_new				(GeanyCompilerLogParseFunc parse_func);
+
+void		geany_compiler_log_append		(GeanyCompilerLog *log, gint color, const gchar *string,
+											 const gchar *dir, gboolean parse, GtkTreeIter *iter);
+void		geany_compiler_log_clear		(GeanyCompilerLog *log);
+void		geany_compiler_log_set_max_lines	(GeanyCompilerLog *log, guint max_lines);
+
+gint		geany_compiler_log_get_color	(GeanyCompilerLog *log, GtkTreeIter *iter);
+const gchar*	geany_compiler_log_get_string	(GeanyCompilerLog *log, GtkTreeIter *iter);
+const gchar*	geany_compiler_log_get_dir		(GeanyCompilerLog *log, GtkTreeIter *iter);
+const gchar*	geany_compiler_log_get_longest	(GeanyCompilerLog *log);
+
+gboolean	geany_compiler_log_scan_next	(GeanyCompilerLog *log, GtkTreeIter *iter);
+void		geany_compiler_log_set_color	(GeanyCompilerLog *log, GtkTreeIter *iter, gint color);
+
+
+G_END_DECLS
+
+#endif /* GEANY_COMPILER_LOG_H */
@@ -234,6 +234,8 @@ static void init_pref_groups(void)
 		"use_gtk_word_boundaries", TRUE);
 	stash_group_add_boolean(group, &editor_prefs.complete_snippets_whilst_editing,
 		"complete_snippets_whilst_editing", FALSE);
+	stash_group_add_integer(group, &editor_private_prefs.undo_memory_limit,
+		"undo_memory_limit", 256);
 	stash_group_add_boolean(group, &file_prefs.use_safe_file_saving,
 		atomic_file_saving_key, FALSE);
 	stash_group_add_boolean(group, &file_prefs.gio_unsafe_save_backup,
@@ -1145,22 +1147,14 @@ gboolean configuration_load(void)
 }
 
 
-static gboolean open_session_file(gchar **tmp, guint len)
+/* Starts reading the session file in a worker thread, returns NULL if it doesn't exist */
+static DocumentPreload *preload_session_file(gchar **tmp)
 {
-	guint pos;
-	const gchar *ft_name;
 	gchar *locale_filename;
 	gchar *unescaped_filename;
 	const gchar *encoding;
-	gint  indent_type;
-	gboolean ro, auto_indent, line_wrapping;
-	/** TODO when we have a global pref for line breaking, use its value */
-	gboolean line_breaking = FALSE;
-	gboolean ret = FALSE;
+	DocumentPreload *preload = NULL;
 
-	pos = atoi(tmp[0]);
-	ft_name = tmp[1];
-	ro = atoi(tmp[2]);
 	if (isdigit(tmp[3][0]))
 	{
 		encoding = encodings_get_charset_from_index(atoi(tmp[3]));
@@ -1169,43 +1163,57 @@ static gboolean open_session_file(gchar **tmp, guint len)
 	{
 		encoding = &(tmp[3][1]);
 	}
-	indent_type = atoi(tmp[4]);
-	auto_indent = atoi(tmp[5]);
-	line_wrapping = atoi(tmp[6]);
 	/* try to get the locale equivalent for the filename */
 	unescaped_filename = g_uri_unescape_string(tmp[7], NULL);
 	locale_filename = utils_get_locale_from_utf8(unescaped_filename);
 
-	if (len > 8)
-		line_breaking = atoi(tmp[8]);
-
 	if (g_file_test(locale_filename, G_FILE_TEST_IS_REGULAR))
-	{
-		GeanyFiletype *ft = filetypes_lookup_by_name(ft_name);
-		GeanyDocument *doc = document_open_file_full(
-			NULL, locale_filename, pos, ro, ft, encoding);
-
-		if (doc)
-		{
-			gint indent_width = doc->editor->indent_width;
-
-			if (len > 9)
-				indent_width = atoi(tmp[9]);
-			editor_set_indent(doc->editor, indent_type, indent_width);
-			editor_set_line_wrapping(doc->editor, line_wrapping);
-			doc->editor->line_breaking = line_breaking;
-			doc->editor->auto_indent = auto_indent;
-			ret = TRUE;
-		}
-	}
+		preload = document_preload_file(locale_filename, encoding);
 	else
-	{
 		geany_debug("Could not find file '%s'.", tmp[7]);
-	}
 
 	g_free(locale_filename);
 	g_free(unescaped_filename);
-	return ret;
+	return preload;
+}
+
+
+static gboolean open_session_file(gchar **tmp, guint len, DocumentPreload *preload)
+{
+	guint pos;
+	const gchar *ft_name;
+	gint  indent_type;
+	gboolean ro, auto_indent, line_wrapping;
+	/** TODO when we have a global pref for line breaking, use its value */
+	gboolean line_breaking = FALSE;
+	GeanyFiletype *ft;
+	GeanyDocument *doc;
+
+	pos = atoi(tmp[0]);
+	ft_name = tmp[1];
+	ro = atoi(tmp[2]);
+	indent_type = atoi(tmp[4]);
+	auto_indent = atoi(tmp[5]);
+	line_wrapping = atoi(tmp[6]);
+
+	if (len > 8)
+		line_breaking = atoi(tmp[8]);
+
+	ft = filetypes_lookup_by_name(ft_name);
+	doc = document_open_file_preloaded(preload, pos, ro, ft);
+	if (doc)
+	{
+		gint indent_width = doc->editor->indent_width;
+
+		if (len > 9)
+			indent_width = atoi(tmp[9]);
+		editor_set_indent(doc->editor, indent_type, indent_width);
+		editor_set_line_wrapping(doc->editor, line_wrapping);
+		doc->editor->line_breaking = line_breaking;
+		doc->editor->auto_indent = auto_indent;
+		return TRUE;
+	}
+	return FALSE;
 }
 
 
@@ -1216,19 +1224,31 @@ void configuration_open_files(void)
 {
 	gint i;
 	gboolean failure = FALSE;
+	GPtrArray *preloads;
 
 	/* necessary to set it to TRUE for project session support */
 	main_status.opening_session_files = TRUE;
 
+	/* read all files in parallel while the tabs are set up */
+	preloads = g_ptr_array_sized_new(session_files->len);
+	for (i = 0; i < (gint)session_files->len; i++)
+	{
+		gchar **tmp = g_ptr_array_index(session_files, i);
+
+		g_ptr_array_add(preloads, (tmp != NULL && g_strv_length(tmp) >= 8) ?
+			preload_session_file(tmp) : NULL);
+	}
+
 	i = file_prefs.tab_order_ltr ? 0 : (session_files->len - 1);
 	while (TRUE)
 	{
 		gchar **tmp = g_ptr_array_index(session_files, i);
+		DocumentPreload *preload = g_ptr_array_index(preloads, i);
 		guint len;
 
 		if (tmp != NULL && (len = g_strv_length(tmp)) >= 8)
 		{
-			if (! open_session_file(tmp, len))
+			if (preload == NULL || ! open_session_file(tmp, len, preload))
 				failure = TRUE;
 		}
 		g_strfreev(tmp);
@@ -1247,11 +1267,19 @@ void configuration_open_files(void)
 		}
 	}
 
+	g_ptr_array_free(preloads, TRUE);
 	g_ptr_array_free(session_files, TRUE);
 	session_files = NULL;
 
 	if (failure)
+	{
+		GeanyDocument *doc = document_get_current();
+
+		/* there is no page switch to parse the tags of the shown file */
+		if (doc != NULL)
+			document_update_pending_tags(doc);
 		ui_set_statusbar(TRUE, _("Failed to load one or more session files."));
+	}
 	else
 	{
 		/* explicitly trigger a notebook page switch after unsetting main_status.opening_session_files
@@ -105,6 +105,7 @@ static gchar *lib_vte = NULL;
 #endif
 static gboolean generate_tags = FALSE;
 static gboolean no_preprocessing = FALSE;
+static gboolean binary_tags = FALSE;
 static gboolean ft_names = FALSE;
 static gboolean print_prefix = FALSE;
 #ifdef HAVE_PLUGINS
@@ -115,6 +116,7 @@ static gboolean dummy = FALSE;
 /* in alphabetical order of short options */
 static GOptionEntry entries[] =
 {
+	{ "binary-tags", 0, 0, G_OPTION_ARG_NONE, &binary_tags, N_("Write the global tags file in the binary format (use with --generate-tags)"), NULL },
 	{ "column", 0, 0, G_OPTION_ARG_INT, &cl_options.goto_column, N_("Set initial column number for the first opened file (useful in conjunction with --line)"), NULL },
 	{ "config", 'c', 0, G_OPTION_ARG_FILENAME, &alternate_config, N_("Use an alternate configuration directory"), NULL },
 	{ "ft-names", 0, 0, G_OPTION_ARG_NONE, &ft_names, N_("Print internal filetype names"), NULL },
@@ -590,7 +592,7 @@ static void parse_command_line_options(gint *argc, gchar ***argv)
 		gboolean ret;
 
 		filetypes_init_types();
-		ret = symbols_generate_global_tags(*argc, *argv, ! no_preprocessing);
+		ret = symbols_generate_global_tags(*argc, *argv, ! no_preprocessing, binary_tags);
 		filetypes_free_types();
 		wait_for_input_on_windows();
 		exit(ret);
@@ -1190,6 +1192,8 @@ gint main_lib(gint argc, gchar **argv)
 	ui_save_buttons_toggle(FALSE);
 
 	doc = document_get_current();
+	if (doc != NULL)
+		document_update_pending_tags(doc);
 	sidebar_select_openfiles_item(doc);
 	build_menu_update(doc);
 	sidebar_update_tag_list(doc, FALSE);
@@ -41,6 +41,9 @@
 #endif
 
 static GString *log_buffer = NULL;
+/* messages can also be logged by worker threads, e.g. while reading session files */
+static GMutex log_mutex;
+static GThread *main_thread = NULL;
 static GtkTextBuffer *dialog_textbuffer = NULL;
 
 enum
@@ -56,7 +59,9 @@ static void update_dialog(void)
 		GtkTextMark *mark;
 		GtkTextView *textview = g_object_get_data(G_OBJECT(dialog_textbuffer), "textview");
 
+		g_mutex_lock(&log_mutex);
 		gtk_text_buffer_set_text(dialog_textbuffer, log_buffer->str, log_buffer->len);
+		g_mutex_unlock(&log_mutex);
 		/* scroll to the end of the messages as this might be most interesting */
 		mark = gtk_text_buffer_get_insert(dialog_textbuffer);
 		gtk_text_view_scroll_to_mark(textview, mark, 0.0, FALSE, 0.0, 0.0);
@@ -64,6 +69,19 @@ static void update_dialog(void)
 }
 
 
+/* The dialog is only updated from the main thread, messages of other threads are shown
+ * with the next update */
+static void append_log(const gchar *text)
+{
+	g_mutex_lock(&log_mutex);
+	g_string_append(log_buffer, text);
+	g_mutex_unlock(&log_mutex);
+
+	if (g_thread_self() == main_thread)
+		update_dialog();
+}
+
+
 /* Geany's main debug/log function, declared in geany.h */
 void geany_debug(gchar const *format, ...)
 {
@@ -79,8 +97,10 @@ static void handler_print(const gchar *msg)
 	printf("%s\n", msg);
 	if (G_LIKELY(log_buffer != NULL))
 	{
-		g_string_append_printf(log_buffer, "%s\n", msg);
-		update_dialog();
+		gchar *text = g_strconcat(msg, "\n", NULL);
+
+		append_log(text);
+		g_free(text);
 	}
 }
 
@@ -90,8 +110,10 @@ static void handler_printerr(const gchar *msg)
 	fprintf(stderr, "%s\n", msg);
 	if (G_LIKELY(log_buffer != NULL))
 	{
-		g_string_append_printf(log_buffer, "%s\n", msg);
-		update_dialog();
+		gchar *text = g_strconcat(msg, "\n", NULL);
+
+		append_log(text);
+		g_free(text);
 	}
 }
 
@@ -120,6 +142,7 @@ static const gchar *get_log_prefix(GLogLevelFlags log_level)
 static void handler_log(const gchar *domain, GLogLevelFlags level, const gchar *msg, gpointer data)
 {
 	gchar *time_str;
+	gchar *text;
 
 	if (G_LIKELY(app != NULL && app->debug_mode) ||
 		! ((G_LOG_LEVEL_DEBUG | G_LOG_LEVEL_INFO | G_LOG_LEVEL_MESSAGE) & level))
@@ -140,18 +163,18 @@ static void handler_log(const gchar *domain, GLogLevelFlags level, const gchar *
 
 	time_str = utils_get_current_time_string();
 
-	g_string_append_printf(log_buffer, "%s: %s %s: %s\n", time_str, domain,
-		get_log_prefix(level), msg);
+	text = g_strdup_printf("%s: %s %s: %s\n", time_str, domain, get_log_prefix(level), msg);
+	append_log(text);
 
+	g_free(text);
 	g_free(time_str);
-
-	update_dialog();
 }
 
 
 void log_handlers_init(void)
 {
 	log_buffer = g_string_sized_new(2048);
+	main_thread = g_thread_self();
 
 	g_set_print_handler(handler_print);
 	g_set_printerr_handler(handler_printerr);
@@ -169,7 +192,9 @@ static void on_dialog_response(GtkDialog *dialog, gint response, gpointer user_d
 		gtk_text_buffer_get_end_iter(dialog_textbuffer, &end_iter);
 		gtk_text_buffer_delete(dialog_textbuffer, &start_iter, &end_iter);
 
+		g_mutex_lock(&log_mutex);
 		g_string_erase(log_buffer, 0, -1);
+		g_mutex_unlock(&log_mutex);
 	}
 	else
 	{
@@ -37,10 +37,12 @@
 #include "document.h"
 #include "callbacks.h"
 #include "filetypes.h"
+#include "geanycompilerlog.h"
 #include "keybindings.h"
 #include "main.h"
 #include "navqueue.h"
 #include "prefs.h"
+#include "search.h"
 #include "support.h"
 #include "ui_utils.h"
 #include "utils.h"
@@ -77,15 +79,17 @@ enum
 
 enum
 {
-	COMPILER_COL_COLOR = 0,
-	COMPILER_COL_STRING,
-	COMPILER_COL_COUNT
+	COMPILER_COL_COLOR = GEANY_COMPILER_LOG_COLUMN_COLOR,
+	COMPILER_COL_STRING = GEANY_COMPILER_LOG_COLUMN_STRING
 };
 
 
 static void prepare_msg_tree_view(void);
 static void prepare_status_tree_view(void);
 static void prepare_compiler_tree_view(void);
+static void compiler_color_data_func(GtkTreeViewColumn *column, GtkCellRenderer *cell,
+		GtkTreeModel *model, GtkTreeIter *iter, gpointer data);
+static gint parse_compiler_line(const gchar *string, const gchar *dir, gint color);
 static GtkWidget *create_message_popup_menu(gint type);
 static gboolean on_msgwin_button_press_event(GtkWidget *widget, GdkEventButton *event,
 																			gpointer user_data);
@@ -233,14 +237,18 @@ static void prepare_compiler_tree_view(void)
 	GtkTreeViewColumn *column;
 	GtkTreeSelection *selection;
 
-	msgwindow.store_compiler = gtk_list_store_new(COMPILER_COL_COUNT, GDK_TYPE_COLOR, G_TYPE_STRING);
+	msgwindow.store_compiler = geany_compiler_log_new(parse_compiler_line);
 	gtk_tree_view_set_model(GTK_TREE_VIEW(msgwindow.tree_compiler), GTK_TREE_MODEL(msgwindow.store_compiler));
 	g_object_unref(msgwindow.store_compiler);
 
 	renderer = gtk_cell_renderer_text_new();
 	column = gtk_tree_view_column_new_with_attributes(NULL, renderer,
-		"foreground-gdk", COMPILER_COL_COLOR, "text", COMPILER_COL_STRING, NULL);
+		"text", COMPILER_COL_STRING, NULL);
+	gtk_tree_view_column_set_cell_data_func(column, renderer, compiler_color_data_func, NULL, NULL);
+	/* only the displayed lines are measured and parsed for errors, see compiler_update_width() */
+	gtk_tree_view_column_set_sizing(column, GTK_TREE_VIEW_COLUMN_FIXED);
 	gtk_tree_view_append_column(GTK_TREE_VIEW(msgwindow.tree_compiler), column);
+	gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(msgwindow.tree_compiler), TRUE);
 
 	gtk_tree_view_set_enable_search(GTK_TREE_VIEW(msgwindow.tree_compiler), FALSE);
 
@@ -280,6 +288,16 @@ static const GdkColor *get_color(gint msg_color)
 }
 
 
+static void compiler_color_data_func(GtkTreeViewColumn *column, GtkCellRenderer *cell,
+		GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+	gint color;
+
+	gtk_tree_model_get(model, iter, COMPILER_COL_COLOR, &color, -1);
+	g_object_set(cell, "foreground-gdk", get_color(color), NULL);
+}
+
+
 /**
  *  Adds a new message in the compiler tab treeview in the messages window.
  *
@@ -301,25 +319,50 @@ void msgwin_compiler_add(gint msg_color, const gchar *format, ...)
 }
 
 
-void msgwin_compiler_add_string(gint msg_color, const gchar *msg)
+/* While a batch of compiler messages is added, scrolling and updating the build menu
+ * is only done for the last one */
+static struct
 {
-	GtkTreeIter iter;
-	const GdkColor *color = get_color(msg_color);
-	gchar *utf8_msg;
+	gboolean active;
+	gboolean added;
+	GtkTreeIter last;
+}
+compiler_batch;
 
-	if (! g_utf8_validate(msg, -1, NULL))
-		utf8_msg = utils_get_utf8_from_locale(msg);
-	else
-		utf8_msg = (gchar *) msg;
+/* length of the line the width of the compiler column was set for */
+static gsize compiler_width_len = 0;
 
-	gtk_list_store_append(msgwindow.store_compiler, &iter);
-	gtk_list_store_set(msgwindow.store_compiler, &iter,
-		COMPILER_COL_COLOR, color, COMPILER_COL_STRING, utf8_msg, -1);
+
+/* The compiler column has a fixed width so that the view does not need to measure
+ * every line, so make it wide enough for the longest line. */
+static void compiler_update_width(void)
+{
+	const gchar *longest = geany_compiler_log_get_longest(msgwindow.store_compiler);
+	gsize len = longest != NULL ? strlen(longest) : 0;
+
+	if (len > compiler_width_len)
+	{
+		GtkTreeViewColumn *column = gtk_tree_view_get_column(GTK_TREE_VIEW(msgwindow.tree_compiler), 0);
+		PangoLayout *layout = gtk_widget_create_pango_layout(msgwindow.tree_compiler, longest);
+		gint width;
+
+		pango_layout_get_pixel_size(layout, &width, NULL);
+		g_object_unref(layout);
+		/* add some room for the cell padding */
+		gtk_tree_view_column_set_fixed_width(column, width + 16);
+		compiler_width_len = len;
+	}
+}
+
+
+static void compiler_show_added(GtkTreeIter *iter)
+{
+	compiler_update_width();
 
 	if (ui_prefs.msgwindow_visible && interface_prefs.compiler_tab_autoscroll)
 	{
 		GtkTreePath *path = gtk_tree_model_get_path(
-			gtk_tree_view_get_model(GTK_TREE_VIEW(msgwindow.tree_compiler)), &iter);
+			gtk_tree_view_get_model(GTK_TREE_VIEW(msgwindow.tree_compiler)), iter);
 
 		gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(msgwindow.tree_compiler), path, NULL, TRUE, 0.5, 0.5);
 		gtk_tree_path_free(path);
@@ -328,12 +371,120 @@ void msgwin_compiler_add_string(gint msg_color, const gchar *msg)
 	/* calling build_menu_update for every build message would be overkill, TODO really should call it once when all done */
 	gtk_widget_set_sensitive(build_get_menu_items(-1)->menu_item[GBG_FIXED][GBF_NEXT_ERROR], TRUE);
 	gtk_widget_set_sensitive(build_get_menu_items(-1)->menu_item[GBG_FIXED][GBF_PREV_ERROR], TRUE);
+}
+
+
+static void compiler_add(gint msg_color, const gchar *msg, const gchar *dir, gboolean parse)
+{
+	GtkTreeIter iter;
+	gchar *utf8_msg;
+
+	if (! g_utf8_validate(msg, -1, NULL))
+		utf8_msg = utils_get_utf8_from_locale(msg);
+	else
+		utf8_msg = (gchar *) msg;
+
+	geany_compiler_log_set_max_lines(msgwindow.store_compiler,
+		(guint) MAX(ui_prefs.compiler_tab_max_lines, 0));
+	geany_compiler_log_append(msgwindow.store_compiler, msg_color, utf8_msg, dir, parse, &iter);
+
+	if (compiler_batch.active)
+	{
+		compiler_batch.added = TRUE;
+		compiler_batch.last = iter;
+	}
+	else
+		compiler_show_added(&iter);
 
 	if (utf8_msg != msg)
 		g_free(utf8_msg);
 }
 
 
+void msgwin_compiler_add_string(gint msg_color, const gchar *msg)
+{
+	compiler_add(msg_color, msg, NULL, FALSE);
+}
+
+
+/* Adds a line of build output. Whether it is an error message is only checked once its color
+ * is needed, using @a dir as the directory make entered before the line. */
+void msgwin_compiler_add_output(gint msg_color, const gchar *msg, const gchar *dir)
+{
+	compiler_add(msg_color, msg, dir, TRUE);
+}
+
+
+static gint parse_compiler_line(const gchar *string, const gchar *dir, gint color)
+{
+	gchar *filename;
+	gint line;
+
+	msgwin_parse_compiler_error_line(string, dir, &filename, &line);
+	if (line != -1 && filename != NULL)
+		color = COLOR_RED;	/* error message parsed on the line */
+	g_free(filename);
+	return color;
+}
+
+
+/* Parses the next line of build output this function has not checked yet, whether it was
+ * displayed already or not. *filename is set to the file of the error message on the line,
+ * or NULL if it is none. Returns FALSE when there are no more lines. */
+gboolean msgwin_compiler_parse_next(gchar **filename, gint *line)
+{
+	GeanyCompilerLog *log = msgwindow.store_compiler;
+	GtkTreeIter iter;
+
+	if (! geany_compiler_log_scan_next(log, &iter))
+		return FALSE;
+
+	msgwin_parse_compiler_error_line(geany_compiler_log_get_string(log, &iter),
+		geany_compiler_log_get_dir(log, &iter), filename, line);
+	if (*line != -1 && *filename != NULL)
+		geany_compiler_log_set_color(log, &iter, COLOR_RED);
+	else
+	{
+		g_free(*filename);
+		*filename = NULL;
+	}
+	return TRUE;
+}
+
+
+void msgwin_compiler_clear(void)
+{
+	GtkTreeView *view = GTK_TREE_VIEW(msgwindow.tree_compiler);
+
+	/* detach the log so that the view does not update for each removed line */
+	g_object_ref(msgwindow.store_compiler);
+	gtk_tree_view_set_model(view, NULL);
+	geany_compiler_log_clear(msgwindow.store_compiler);
+	gtk_tree_view_set_model(view, GTK_TREE_MODEL(msgwindow.store_compiler));
+	g_object_unref(msgwindow.store_compiler);
+
+	compiler_batch.added = FALSE;
+	compiler_width_len = 0;
+}
+
+
+/* Starts adding many compiler messages at once, see msgwin_compiler_end_batch() */
+void msgwin_compiler_begin_batch(void)
+{
+	compiler_batch.active = TRUE;
+	compiler_batch.added = FALSE;
+}
+
+
+/* Scrolls to the last message added since msgwin_compiler_begin_batch() */
+void msgwin_compiler_end_batch(void)
+{
+	compiler_batch.active = FALSE;
+	if (compiler_batch.added)
+		compiler_show_added(&compiler_batch.last);
+}
+
+
 void msgwin_show_hide(gboolean show)
 {
 	ui_prefs.msgwindow_visible = show;
@@ -508,7 +659,7 @@ on_compiler_treeview_copy_activate(GtkMenuItem *menuitem, gpointer user_data)
 
 static void on_compiler_treeview_copy_all_activate(GtkMenuItem *menuitem, gpointer user_data)
 {
-	GtkListStore *store = msgwindow.store_compiler;
+	GtkTreeModel *model = GTK_TREE_MODEL(msgwindow.store_compiler);
 	GtkTreeIter iter;
 	GString *str = g_string_new("");
 	gint str_idx = COMPILER_COL_STRING;
@@ -517,7 +668,7 @@ static void on_compiler_treeview_copy_all_activate(GtkMenuItem *menuitem, gpoint
 	switch (GPOINTER_TO_INT(user_data))
 	{
 		case MSG_STATUS:
-		store = msgwindow.store_status;
+		model = GTK_TREE_MODEL(msgwindow.store_status);
 		str_idx = 0;
 		break;
 
@@ -526,18 +677,18 @@ static void on_compiler_treeview_copy_all_activate(GtkMenuItem *menuitem, gpoint
 		break;
 
 		case MSG_MESSAGE:
-		store = msgwindow.store_msg;
+		model = GTK_TREE_MODEL(msgwindow.store_msg);
 		str_idx = MSG_COL_STRING;
 		break;
 	}
 
 	/* walk through the list and copy every line into a string */
-	valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(store), &iter);
+	valid = gtk_tree_model_get_iter_first(model, &iter);
 	while (valid)
 	{
 		gchar *line;
 
-		gtk_tree_model_get(GTK_TREE_MODEL(store), &iter, str_idx, &line, -1);
+		gtk_tree_model_get(model, &iter, str_idx, &line, -1);
 		if (!EMPTY(line))
 		{
 			g_string_append(str, line);
@@ -545,7 +696,7 @@ static void on_compiler_treeview_copy_all_activate(GtkMenuItem *menuitem, gpoint
 		}
 		g_free(line);
 
-		valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(store), &iter);
+		valid = gtk_tree_model_iter_next(model, &iter);
 	}
 
 	/* copy the string into the clipboard */
@@ -567,6 +718,18 @@ on_hide_message_window(GtkMenuItem *menuitem, gpointer user_data)
 }
 
 
+static void on_message_treeview_stop_activate(GtkMenuItem *menuitem, gpointer user_data)
+{
+	search_stop_find_in_files();
+}
+
+
+static void on_message_popup_menu_show(GtkWidget *menu, gpointer stop_item)
+{
+	gtk_widget_set_sensitive(GTK_WIDGET(stop_item), search_find_in_files_is_running());
+}
+
+
 static GtkWidget *create_message_popup_menu(gint type)
 {
 	GtkWidget *message_popup_menu, *clear, *copy, *copy_all, *image;
@@ -597,6 +760,21 @@ static GtkWidget *create_message_popup_menu(gint type)
 	g_signal_connect(copy_all, "activate",
 		G_CALLBACK(on_compiler_treeview_copy_all_activate), GINT_TO_POINTER(type));
 
+	if (type == MSG_MESSAGE)
+	{
+		GtkWidget *stop;
+
+		stop = gtk_image_menu_item_new_with_mnemonic(_("_Stop Search"));
+		gtk_widget_show(stop);
+		gtk_container_add(GTK_CONTAINER(message_popup_menu), stop);
+		image = gtk_image_new_from_stock(GTK_STOCK_STOP, GTK_ICON_SIZE_MENU);
+		gtk_widget_show(image);
+		gtk_image_menu_item_set_image(GTK_IMAGE_MENU_ITEM(stop), image);
+		g_signal_connect(stop, "activate", G_CALLBACK(on_message_treeview_stop_activate), NULL);
+		g_signal_connect(message_popup_menu, "show",
+			G_CALLBACK(on_message_popup_menu_show), stop);
+	}
+
 	msgwin_menu_add_common_items(GTK_MENU(message_popup_menu));
 
 	return message_popup_menu;
@@ -625,32 +803,6 @@ void msgwin_menu_add_common_items(GtkMenu *menu)
 }
 
 
-/* look back up from the current path and find the directory we came from */
-static gboolean
-find_prev_build_dir(GtkTreePath *cur, GtkTreeModel *model, gchar **prefix)
-{
-	GtkTreeIter iter;
-	*prefix = NULL;
-
-	while (gtk_tree_path_prev(cur))
-	{
-		if (gtk_tree_model_get_iter(model, &iter, cur))
-		{
-			gchar *string;
-			gtk_tree_model_get(model, &iter, COMPILER_COL_STRING, &string, -1);
-			if (string != NULL && build_parse_make_dir(string, prefix))
-			{
-				g_free(string);
-				return TRUE;
-			}
-			g_free(string);
-		}
-	}
-
-	return FALSE;
-}
-
-
 static gboolean goto_compiler_file_line(const gchar *fname, gint line, gboolean focus_editor)
 {
 	gboolean ret = FALSE;
@@ -723,35 +875,26 @@ gboolean msgwin_goto_compiler_file_line(gboolean focus_editor)
 	GtkTreeModel *model;
 	GtkTreeSelection *selection;
 	gchar *string;
-	GdkColor *color;
+	gint color;
 
 	selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(msgwindow.tree_compiler));
 	if (gtk_tree_selection_get_selected(selection, &model, &iter))
 	{
 		/* if the item is not coloured red, it's not an error line */
 		gtk_tree_model_get(model, &iter, COMPILER_COL_COLOR, &color, -1);
-		if (color == NULL || ! gdk_color_equal(color, &color_error))
-		{
-			if (color != NULL)
-				gdk_color_free(color);
+		if (color != COLOR_RED)
 			return FALSE;
-		}
-		gdk_color_free(color);
 
 		gtk_tree_model_get(model, &iter, COMPILER_COL_STRING, &string, -1);
 		if (string != NULL)
 		{
 			gint line;
-			gchar *filename, *dir;
-			GtkTreePath *path;
+			gchar *filename;
 			gboolean ret;
 
-			path = gtk_tree_model_get_path(model, &iter);
-			find_prev_build_dir(path, model, &dir);
-			gtk_tree_path_free(path);
-			msgwin_parse_compiler_error_line(string, dir, &filename, &line);
+			msgwin_parse_compiler_error_line(string,
+				geany_compiler_log_get_dir(msgwindow.store_compiler, &iter), &filename, &line);
 			g_free(string);
-			g_free(dir);
 
 			ret = goto_compiler_file_line(filename, line, focus_editor);
 			g_free(filename);
@@ -1259,7 +1402,7 @@ void msgwin_clear_tab(gint tabnum)
 			break;
 
 		case MSG_COMPILER:
-			gtk_list_store_clear(msgwindow.store_compiler);
+			msgwin_compiler_clear();
 			build_menu_update(NULL);	/* update next error items */
 			return;
 
@@ -68,11 +68,13 @@ void msgwin_set_messages_dir(const gchar *messages_dir);
 
 #ifdef GEANY_PRIVATE
 
+struct GeanyCompilerLog;
+
 typedef struct
 {
 	GtkListStore	*store_status;
 	GtkListStore	*store_msg;
-	GtkListStore	*store_compiler;
+	struct GeanyCompilerLog	*store_compiler;
 	GtkWidget		*tree_compiler;
 	GtkWidget		*tree_status;
 	GtkWidget		*tree_msg;
@@ -97,6 +99,16 @@ void msgwin_msg_add_string(gint msg_color, gint line, GeanyDocument *doc, const
 
 void msgwin_compiler_add_string(gint msg_color, const gchar *msg);
 
+void msgwin_compiler_add_output(gint msg_color, const gchar *msg, const gchar *dir);
+
+gboolean msgwin_compiler_parse_next(gchar **filename, gint *line);
+
+void msgwin_compiler_clear(void);
+
+void msgwin_compiler_begin_batch(void);
+
+void msgwin_compiler_end_batch(void);
+
 void msgwin_show_hide_tabs(void);
 
 
@@ -1316,6 +1316,11 @@ static void init_stash_prefs(void)
 		"auto_continue_multiline", editor_prefs.auto_continue_multiline,
 		"check_auto_multiline1");
 	add_stash_group(group, TRUE);
+
+	group = stash_group_new("search");
+	/* 'hidden' pref, there's no widget for it yet */
+	stash_group_add_boolean(group, &priv.fif_index, "fif_index", FALSE);
+	add_stash_group(group, TRUE);
 }
 
 
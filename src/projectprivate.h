@@ -45,6 +45,9 @@ typedef struct GeanyProjectPrivate
 	gint		long_line_behaviour; /* 0 - disabled, 1 - follow global settings, 2 - enabled (custom) */
 	gint		long_line_column; /* Long line marker position. */
 
+	// search prefs
+	gboolean	fif_index; /* keep a trigram index of the files for Find in Files */
+
 	GPtrArray *build_filetypes_list; /* Project has custom filetype builds for these. */
 }
 GeanyProjectPrivate;
@@ -791,6 +791,13 @@ void sci_set_savepoint(ScintillaObject *sci)
 }
 
 
+/* Appends len bytes of text at the end of the document without scrolling */
+void sci_append_text(ScintillaObject *sci, const gchar *text, gint len)
+{
+	SSM(sci, SCI_APPENDTEXT, (uptr_t) len, (sptr_t) text);
+}
+
+
 void sci_set_indentation_guides(ScintillaObject *sci, gint mode)
 {
 	SSM(sci, SCI_SETINDENTATIONGUIDES, (uptr_t) mode, 0);
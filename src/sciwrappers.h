@@ -156,6 +156,7 @@ void				sci_clear_all				(ScintillaObject *sci);
 gint				sci_get_end_styled			(ScintillaObject *sci);
 void				sci_set_tab_width			(ScintillaObject *sci, gint width);
 void				sci_set_savepoint			(ScintillaObject *sci);
+void				sci_append_text				(ScintillaObject *sci, const gchar *text, gint len);
 void				sci_set_indentation_guides	(ScintillaObject *sci, gint mode);
 void				sci_use_popup				(ScintillaObject *sci, gboolean enable);
 void				sci_goto_pos				(ScintillaObject *sci, gint pos, gboolean unfold);
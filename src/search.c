@@ -34,6 +34,8 @@
 #include "document.h"
 #include "encodings.h"
 #include "encodingsprivate.h"
+#include "fifindex.h"
+#include "fifsearch.h"
 #include "keyfile.h"
 #include "msgwindow.h"
 #include "prefs.h"
@@ -87,6 +89,7 @@ static struct
 	gboolean fif_match_whole_word;
 	gboolean fif_invert_results;
 	gboolean fif_recursive;
+	gboolean fif_builtin;
 	gboolean fif_use_extra_options;
 	gchar *fif_extra_options;
 	gint fif_files_mode;
@@ -145,6 +148,19 @@ static struct
 }
 fif_dlg = {NULL, NULL, NULL, NULL, NULL, NULL, {0, 0}};
 
+/* The data of the callbacks of a grep process, freed by search_finished() */
+typedef struct
+{
+	const gchar	*enc;
+}
+FifGrep;
+
+/* the running grep process and whether it is being stopped. The output of stopped ones is
+ * ignored, their callbacks get another FifGrep than fif_grep. */
+static GPid fif_grep_pid = 0;
+static FifGrep *fif_grep = NULL;
+static gboolean fif_grep_stopped = FALSE;
+
 
 static void search_read_io(GString *string, GIOCondition condition, gpointer data);
 static void search_read_io_stderr(GString *string, GIOCondition condition, gpointer data);
@@ -184,6 +200,11 @@ static gboolean
 search_find_in_files(const gchar *utf8_search_text, const gchar *dir, const gchar *opts,
 	const gchar *enc);
 
+static gboolean
+search_find_in_files_builtin(const gchar *utf8_search_text, const gchar *utf8_dir, const gchar *enc);
+
+static void stop_previous_search(void);
+
 
 static void init_prefs(void)
 {
@@ -222,6 +243,8 @@ static void init_prefs(void)
 		"fif_invert_results", FALSE, "check_invert");
 	stash_group_add_toggle_button(group, &settings.fif_recursive,
 		"fif_recursive", FALSE, "check_recursive");
+	stash_group_add_toggle_button(group, &settings.fif_builtin,
+		"fif_builtin", FALSE, "check_builtin");
 	stash_group_add_entry(group, &settings.fif_extra_options,
 		"fif_extra_options", "", "entry_extra");
 	stash_group_add_toggle_button(group, &settings.fif_use_extra_options,
@@ -276,6 +299,7 @@ void search_init(void)
 	search_data.text = NULL;
 	search_data.original_text = NULL;
 	init_prefs();
+	fif_index_init();
 }
 
 
@@ -289,6 +313,8 @@ void search_finalize(void)
 	FREE_WIDGET(fif_dlg.dialog);
 	g_free(search_data.text);
 	g_free(search_data.original_text);
+	search_stop_find_in_files();
+	fif_index_finalize();
 }
 
 
@@ -859,7 +885,7 @@ static void create_fif_dialog(void)
 {
 	GtkWidget *dir_combo, *combo, *fcombo, *e_combo, *entry;
 	GtkWidget *label, *label1, *label2, *label3, *checkbox1, *checkbox2, *check_wholeword,
-		*check_recursive, *check_extra, *entry_extra, *check_regexp, *combo_files_mode;
+		*check_recursive, *check_builtin, *check_extra, *entry_extra, *check_regexp, *combo_files_mode;
 	GtkWidget *dbox, *sbox, *lbox, *rbox, *hbox, *vbox, *ebox;
 	GtkSizeGroup *size_group;
 
@@ -981,6 +1007,13 @@ static void create_fif_dialog(void)
 	gtk_widget_set_tooltip_text(checkbox2,
 			_("Invert the sense of matching, to select non-matching lines"));
 
+	check_builtin = gtk_check_button_new_with_mnemonic(_("Use _built-in search"));
+	ui_hookup_widget(fif_dlg.dialog, check_builtin, "check_builtin");
+	gtk_button_set_focus_on_click(GTK_BUTTON(check_builtin), FALSE);
+	gtk_widget_set_tooltip_text(check_builtin,
+			_("Search the files with several threads inside Geany instead of running the Grep tool. "
+			"Version control directories are skipped and the extra options are not used"));
+
 	lbox = gtk_vbox_new(FALSE, 0);
 	gtk_container_add(GTK_CONTAINER(lbox), check_regexp);
 	gtk_container_add(GTK_CONTAINER(lbox), checkbox2);
@@ -989,7 +1022,7 @@ static void create_fif_dialog(void)
 	rbox = gtk_vbox_new(FALSE, 0);
 	gtk_container_add(GTK_CONTAINER(rbox), checkbox1);
 	gtk_container_add(GTK_CONTAINER(rbox), check_wholeword);
-	gtk_container_add(GTK_CONTAINER(rbox), gtk_label_new(NULL));
+	gtk_container_add(GTK_CONTAINER(rbox), check_builtin);
 
 	hbox = gtk_hbox_new(FALSE, 6);
 	gtk_container_add(GTK_CONTAINER(hbox), lbox);
@@ -1616,18 +1649,26 @@ on_find_in_files_dialog_response(GtkDialog *dialog, gint response,
 			ui_set_statusbar(FALSE, _("Invalid directory for find in files."));
 		else if (!EMPTY(search_text))
 		{
-			GString *opts = get_grep_options();
 			const gchar *enc = (enc_idx == GEANY_ENCODING_UTF_8) ? NULL :
 				encodings_get_charset_from_index(enc_idx);
+			gboolean started;
 
-			if (search_find_in_files(search_text, utf8_dir, opts->str, enc))
+			if (settings.fif_builtin)
+				started = search_find_in_files_builtin(search_text, utf8_dir, enc);
+			else
+			{
+				GString *opts = get_grep_options();
+
+				started = search_find_in_files(search_text, utf8_dir, opts->str, enc);
+				g_string_free(opts, TRUE);
+			}
+			if (started)
 			{
 				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(search_combo), search_text, 0);
 				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(fif_dlg.files_combo), NULL, 0);
 				ui_combo_box_add_to_history(GTK_COMBO_BOX_TEXT(dir_combo), utf8_dir, 0);
 				gtk_widget_hide(fif_dlg.dialog);
 			}
-			g_string_free(opts, TRUE);
 		}
 		else
 			ui_set_statusbar(FALSE, _("No text to find."));
@@ -1641,6 +1682,7 @@ static gboolean
 search_find_in_files(const gchar *utf8_search_text, const gchar *utf8_dir, const gchar *opts,
 	const gchar *enc)
 {
+	FifGrep *grep;
 	gchar **argv_prefix, **argv;
 	gchar *command_grep;
 	gchar *command_line, *dir;
@@ -1695,17 +1737,21 @@ search_find_in_files(const gchar *utf8_search_text, const gchar *utf8_dir, const
 		}
 	}
 
+	stop_previous_search();
 	gtk_list_store_clear(msgwindow.store_msg);
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_MESSAGE);
 
-	/* we can pass 'enc' without strdup'ing it here because it's a global const string and
+	/* we can keep 'enc' without strdup'ing it here because it's a global const string and
 	 * always exits longer than the lifetime of this function */
+	grep = g_new0(FifGrep, 1);
+	grep->enc = enc;
 	if (spawn_with_callbacks(dir, command_line, argv, NULL, 0, NULL, NULL, search_read_io,
-		(gpointer) enc, 0, search_read_io_stderr, (gpointer) enc, 0, search_finished, NULL,
-		NULL, &error))
+		grep, 0, search_read_io_stderr, grep, 0, search_finished, grep,
+		&fif_grep_pid, &error))
  	{
 		gchar *utf8_str;
  
+		fif_grep = grep;
  		ui_progress_bar_start(_("Searching..."));
  		msgwin_set_messages_dir(dir);
 		utf8_str = g_strdup_printf(_("%s %s -- %s (in directory: %s)"),
@@ -1719,6 +1765,7 @@ search_find_in_files(const gchar *utf8_search_text, const gchar *utf8_dir, const
 		ui_set_statusbar(TRUE, _("Cannot execute grep tool \"%s\": %s. "
 			"Check the path setting in Preferences."), tool_prefs.grep_cmd, error->message);
 		g_error_free(error);
+		g_free(grep);
 	}
 
 	utils_free_pointers(2, dir, command_line, NULL);
@@ -1727,6 +1774,87 @@ search_find_in_files(const gchar *utf8_search_text, const gchar *utf8_dir, const
 }
 
 
+static gboolean
+search_find_in_files_builtin(const gchar *utf8_search_text, const gchar *utf8_dir, const gchar *enc)
+{
+	FifSearchFlags flags = 0;
+	const gchar *files = NULL;
+	GError *error = NULL;
+	gchar *dir, *utf8_str;
+
+	if (settings.fif_regexp)
+		flags |= FIF_SEARCH_REGEXP;
+	if (settings.fif_case_sensitive)
+		flags |= FIF_SEARCH_MATCHCASE;
+	if (settings.fif_match_whole_word)
+		flags |= FIF_SEARCH_WHOLEWORD;
+	if (settings.fif_invert_results)
+		flags |= FIF_SEARCH_INVERT;
+	if (settings.fif_recursive)
+		flags |= FIF_SEARCH_RECURSIVE;
+
+	g_strstrip(settings.fif_files);
+	if (settings.fif_files_mode != FILES_MODE_ALL && *settings.fif_files)
+		files = settings.fif_files;
+
+	stop_previous_search();
+	if (! fif_search_start(utf8_search_text, utf8_dir, files, enc, flags, &error))
+	{
+		ui_set_statusbar(TRUE, _("Search failed (%s)."), error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+
+	gtk_list_store_clear(msgwindow.store_msg);
+	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_MESSAGE);
+
+	ui_progress_bar_start(_("Searching..."));
+	dir = utils_get_locale_from_utf8(utf8_dir);
+	msgwin_set_messages_dir(dir);
+	g_free(dir);
+	utf8_str = g_strdup_printf(_("Searching for \"%s\" (in directory: %s)"),
+		utf8_search_text, utf8_dir);
+	msgwin_msg_add_string(COLOR_BLUE, -1, NULL, utf8_str);
+	g_free(utf8_str);
+	return TRUE;
+}
+
+
+/* Stops the running search without reporting it, the new search reuses the Messages tab */
+static void stop_previous_search(void)
+{
+	search_stop_find_in_files();
+	fif_grep_pid = 0;
+	fif_grep = NULL;
+	fif_grep_stopped = FALSE;
+}
+
+
+gboolean search_find_in_files_is_running(void)
+{
+	return fif_grep_pid != 0 || fif_search_is_running();
+}
+
+
+/* Stops the running Find in Files search, if any */
+void search_stop_find_in_files(void)
+{
+	if (fif_grep_pid != 0)
+	{
+		GError *error = NULL;
+
+		if (spawn_kill_process(fif_grep_pid, &error))
+			fif_grep_stopped = TRUE;
+		else
+		{
+			ui_set_statusbar(TRUE, _("Process could not be stopped (%s)."), error->message);
+			g_error_free(error);
+		}
+	}
+	fif_search_stop();
+}
+
+
 static gboolean pattern_list_match(GSList *patterns, const gchar *str)
 {
 	GSList *item;
@@ -1804,7 +1932,7 @@ static gchar **search_get_argv(const gchar **argv_prefix, const gchar *dir)
 }
 
 
-static void read_fif_io(gchar *msg, GIOCondition condition, gchar *enc, gint msg_color)
+static void read_fif_io(gchar *msg, GIOCondition condition, const gchar *enc, gint msg_color)
 {
 	if (condition & (G_IO_IN | G_IO_PRI))
 	{
@@ -1834,13 +1962,20 @@ static void read_fif_io(gchar *msg, GIOCondition condition, gchar *enc, gint msg
 
 static void search_read_io(GString *string, GIOCondition condition, gpointer data)
 {
-	read_fif_io(string->str, condition, data, COLOR_BLACK);
+	FifGrep *grep = data;
+
+	/* ignore what a stopped grep still had buffered */
+	if (grep == fif_grep && ! fif_grep_stopped)
+		read_fif_io(string->str, condition, grep->enc, COLOR_BLACK);
 }
 
 
 static void search_read_io_stderr(GString *string, GIOCondition condition, gpointer data)
 {
-	read_fif_io(string->str, condition, data, COLOR_DARK_RED);
+	FifGrep *grep = data;
+
+	if (grep == fif_grep && ! fif_grep_stopped)
+		read_fif_io(string->str, condition, grep->enc, COLOR_DARK_RED);
 }
 
 
@@ -1848,6 +1983,22 @@ static void search_finished(GPid child_pid, gint status, gpointer user_data)
 {
 	const gchar *msg = _("Search failed.");
 	gint exit_status;
+	/* a grep stopped to start another search */
+	gboolean stale = user_data != fif_grep;
+
+	g_free(user_data);
+	if (stale)
+		return;
+
+	fif_grep_pid = 0;
+	fif_grep = NULL;
+	if (fif_grep_stopped)
+	{
+		fif_grep_stopped = FALSE;
+		msgwin_msg_add_string(COLOR_BLUE, -1, NULL, _("Search stopped."));
+		ui_progress_bar_stop();
+		return;
+	}
 
 	if (SPAWN_WIFEXITED(status))
 	{
@@ -2058,47 +2209,60 @@ gint search_find_next(ScintillaObject *sci, const gchar *str, GeanyFindFlags fla
 }
 
 
-gint search_replace_match(ScintillaObject *sci, const GeanyMatchInfo *match, const gchar *replace_text)
+/* Appends the text to replace match with to str, expanding the \0 to \9 back references
+ * of regular expressions. */
+static void append_replace_text(GString *str, const GeanyMatchInfo *match, const gchar *replace_text)
 {
-	GString *str;
-	gint ret = 0;
-	gint i = 0;
-
-	sci_set_target_start(sci, match->start);
-	sci_set_target_end(sci, match->end);
+	const gchar *ptr;
 
 	if (! (match->flags & GEANY_FIND_REGEXP))
-		return sci_replace_target(sci, replace_text, FALSE);
+	{
+		g_string_append(str, replace_text);
+		return;
+	}
 
-	str = g_string_new(replace_text);
-	while (str->str[i])
+	for (ptr = replace_text; *ptr; ptr++)
 	{
-		gchar *ptr = &str->str[i];
-		gchar *grp;
 		gchar c;
 
 		if (ptr[0] != '\\')
 		{
-			i++;
+			g_string_append_c(str, ptr[0]);
 			continue;
 		}
 		c = ptr[1];
+		if (c == 0)
+			break;
+		ptr++;
 		/* backslash or unnecessary escape */
 		if (c == '\\' || !isdigit(c))
-		{
-			g_string_erase(str, i, 1);
-			i++;
-			continue;
+			g_string_append_c(str, c);
+		else
+		{	/* digit escape, the match offsets are relative to the document */
+			const gint nth = c - '0';
+			const gchar *text = match->match_text - match->matches[0].start;
+
+			g_string_append_len(str, &text[match->matches[nth].start],
+				match->matches[nth].end - match->matches[nth].start);
 		}
-		/* digit escape */
-		g_string_erase(str, i, 2);
-		/* fix match offsets by subtracting index of whole match start from the string */
-		grp = get_regex_match_string(match->match_text - match->matches[0].start, match, c - '0');
-		g_string_insert(str, i, grp);
-		i += strlen(grp);
-		g_free(grp);
-	}
-	ret = sci_replace_target(sci, str->str, FALSE);
+	}
+}
+
+
+gint search_replace_match(ScintillaObject *sci, const GeanyMatchInfo *match, const gchar *replace_text)
+{
+	GString *str;
+	gint ret;
+
+	sci_set_target_start(sci, match->start);
+	sci_set_target_end(sci, match->end);
+
+	if (! (match->flags & GEANY_FIND_REGEXP))
+		return sci_replace_target(sci, replace_text, FALSE);
+
+	str = g_string_new(NULL);
+	append_replace_text(str, match, replace_text);
+	ret = (gint) scintilla_send_message(sci, SCI_REPLACETARGET, str->len, (sptr_t) str->str);
 	g_string_free(str, TRUE);
 	return ret;
 }
@@ -2143,51 +2307,15 @@ gint search_find_text(ScintillaObject *sci, GeanyFindFlags flags, struct Sci_Tex
 }
 
 
-static gint find_document_usage(GeanyDocument *doc, const gchar *search_text, GeanyFindFlags flags)
-{
-	gchar *buffer, *short_file_name;
-	struct Sci_TextToFind ttf;
-	gint count = 0;
-	gint prev_line = -1;
-	GSList *match, *matches;
-
-	g_return_val_if_fail(DOC_VALID(doc), 0);
-
-	short_file_name = g_path_get_basename(DOC_FILENAME(doc));
-
-	ttf.chrg.cpMin = 0;
-	ttf.chrg.cpMax = sci_get_length(doc->editor->sci);
-	ttf.lpstrText = (gchar *)search_text;
-
-	matches = find_range(doc->editor->sci, flags, &ttf);
-	foreach_slist (match, matches)
-	{
-		GeanyMatchInfo *info = match->data;
-		gint line = sci_get_line_from_position(doc->editor->sci, info->start);
-
-		if (line != prev_line)
-		{
-			buffer = sci_get_line(doc->editor->sci, line);
-			msgwin_msg_add(COLOR_BLACK, line + 1, doc,
-				"%s:%d: %s", short_file_name, line + 1, g_strstrip(buffer));
-			g_free(buffer);
-			prev_line = line;
-		}
-		count++;
-
-		geany_match_info_free(info);
-	}
-	g_slist_free(matches);
-	g_free(short_file_name);
-	return count;
-}
-
-
+/* Lists the lines of the current document, or of all open documents if in_session is set,
+ * matching search_text in the Messages tab. The documents are searched by threads, so the
+ * results are added as they are found. */
 void search_find_usage(const gchar *search_text, const gchar *original_search_text,
 		GeanyFindFlags flags, gboolean in_session)
 {
 	GeanyDocument *doc;
-	gint count = 0;
+	GRegex *regex = NULL;
+	GError *error = NULL;
 
 	doc = document_get_current();
 	g_return_if_fail(doc != NULL);
@@ -2198,50 +2326,90 @@ void search_find_usage(const gchar *search_text, const gchar *original_search_te
 		return;
 	}
 
+	if (flags & GEANY_FIND_REGEXP)
+	{
+		regex = compile_regex(search_text, flags);
+		if (regex == NULL)
+			return;
+	}
+
+	stop_previous_search();
 	gtk_notebook_set_current_page(GTK_NOTEBOOK(msgwindow.notebook), MSG_MESSAGE);
 	gtk_list_store_clear(msgwindow.store_msg);
 
-	if (! in_session)
-	{	/* use current document */
-		count = find_document_usage(doc, search_text, flags);
+	if (fif_search_start_usage(search_text, original_search_text, flags, regex,
+		in_session ? NULL : doc, &error))
+	{
+		ui_progress_bar_start(_("Searching..."));
 	}
 	else
 	{
-		guint i;
-		for (i = 0; i < documents_array->len; i++)
-		{
-			if (documents[i]->is_valid)
-			{
-				count += find_document_usage(documents[i], search_text, flags);
-			}
-		}
+		ui_set_statusbar(TRUE, _("Search failed (%s)."), error->message);
+		g_error_free(error);
 	}
+	if (regex != NULL)
+		g_regex_unref(regex);
+}
 
-	if (count == 0) /* no matches were found */
-	{
-		ui_set_statusbar(FALSE, _("No matches found for \"%s\"."), original_search_text);
-		msgwin_msg_add(COLOR_BLUE, -1, NULL, _("No matches found for \"%s\"."), original_search_text);
-	}
-	else
+
+/* Whether a run of replacements from line_start to line_end may be done as a single change
+ * of the text without moving markers or unfolding lines. Lines after line_start up to
+ * line_end are removed and inserted again, losing their markers and fold state.
+ * *marker_line caches the next line with markers, -1 if there is none or -2 if unknown. */
+static gboolean run_keeps_lines(ScintillaObject *sci, gint line_start, gint line_end, gint *marker_line)
+{
+	gint folded_line;
+
+	if (line_end == line_start)
+		return TRUE;
+
+	if (*marker_line == -2 || (*marker_line != -1 && *marker_line <= line_start))
+		*marker_line = (gint) scintilla_send_message(sci, SCI_MARKERNEXT, line_start + 1, ~0);
+	if (*marker_line != -1 && *marker_line <= line_end)
+		return FALSE;
+
+	folded_line = (gint) scintilla_send_message(sci, SCI_CONTRACTEDFOLDNEXT, line_start, 0);
+	return folded_line == -1 || folded_line > line_end;
+}
+
+
+/* Replaces the text from start to end with the replaced text of a run of matches and moves
+ * *marker_line along with the lines after it.
+ * Returns the difference in length. */
+static gint replace_run(ScintillaObject *sci, gint start, gint end, const GString *str, gint *marker_line)
+{
+	const gint line_count = sci_get_line_count(sci);
+
+	sci_set_target_start(sci, start);
+	sci_set_target_end(sci, end);
+	scintilla_send_message(sci, SCI_REPLACETARGET, str->len, (sptr_t) str->str);
+
+	if (*marker_line >= 0)
 	{
-		ui_set_statusbar(FALSE, ngettext(
-			"Found %d match for \"%s\".", "Found %d matches for \"%s\".", count),
-			count, original_search_text);
-		msgwin_msg_add(COLOR_BLUE, -1, NULL, ngettext(
-			"Found %d match for \"%s\".", "Found %d matches for \"%s\".", count),
-			count, original_search_text);
+		if (*marker_line > sci_get_line_from_position(sci, start))
+			*marker_line += sci_get_line_count(sci) - line_count;
+		else
+			*marker_line = -2;
 	}
+	return (gint) str->len - (end - start);
 }
 
 
 /* ttf is updated to include the last match position (ttf->chrg.cpMin) and
  * the new search range end (ttf->chrg.cpMax).
+ * The new text of consecutive matches and the text between them is built in one pass and
+ * replaced at once, so there is a single change of the document for all of them rather
+ * than one per match. Runs of matches are only split to keep markers and folded lines.
  * Note: Normally you would call sci_start/end_undo_action() around this call. */
 guint search_replace_range(ScintillaObject *sci, struct Sci_TextToFind *ttf,
 		GeanyFindFlags flags, const gchar *replace_text)
 {
 	gint count = 0;
 	gint offset = 0; /* difference between search pos and replace pos */
+	gint run_start = -1, run_end = -1, run_line = -1;
+	gint marker_line = -2;
+	const gchar *text = NULL;
+	GString *str;
 	GSList *match, *matches;
 
 	g_return_val_if_fail(sci != NULL && ttf->lpstrText != NULL && replace_text != NULL, 0);
@@ -2249,27 +2417,47 @@ guint search_replace_range(ScintillaObject *sci, struct Sci_TextToFind *ttf,
 		return 0;
 
 	matches = find_range(sci, flags, ttf);
+	if (matches == NULL)
+		return 0;
+
+	str = g_string_sized_new(256);
 	foreach_slist (match, matches)
 	{
 		GeanyMatchInfo *info = match->data;
-		gint replace_len;
-
-		info->start += offset;
-		info->end += offset;
 
-		replace_len = search_replace_match(sci, info, replace_text);
-		offset += replace_len - (info->end - info->start);
-		count ++;
-
-		/* on last match, update the last match/new range end */
-		if (! match->next)
+		if (run_start != -1 && ! run_keeps_lines(sci, run_line,
+				sci_get_line_from_position(sci, info->end + offset), &marker_line))
 		{
-			ttf->chrg.cpMin = info->start;
-			ttf->chrg.cpMax += offset;
+			offset += replace_run(sci, run_start + offset, run_end + offset, str, &marker_line);
+			run_start = -1;
 		}
+		if (run_start == -1)
+		{
+			run_start = info->start;
+			run_line = sci_get_line_from_position(sci, run_start + offset);
+			g_string_truncate(str, 0);
+		}
+		else
+		{	/* the text between the previous match and this one stays */
+			text = (const gchar *) scintilla_send_message(sci, SCI_GETRANGEPOINTER,
+				run_end + offset, info->start - run_end);
+			g_string_append_len(str, text, info->start - run_end);
+		}
+
+		/* on last match, update the last match position */
+		if (! match->next)
+			ttf->chrg.cpMin = run_start + offset + str->len;
+
+		append_replace_text(str, info, replace_text);
+		run_end = info->end;
+		count ++;
 
 		geany_match_info_free(info);
 	}
+	offset += replace_run(sci, run_start + offset, run_end + offset, str, &marker_line);
+	ttf->chrg.cpMax += offset;
+
+	g_string_free(str, TRUE);
 	g_slist_free(matches);
 
 	return count;
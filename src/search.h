@@ -119,6 +119,10 @@ void search_show_replace_dialog(void);
 
 void search_show_find_in_files_dialog_full(const gchar *text, const gchar *dir);
 
+gboolean search_find_in_files_is_running(void);
+
+void search_stop_find_in_files(void);
+
 void geany_match_info_free(GeanyMatchInfo *info);
 
 gint search_find_prev(struct _ScintillaObject *sci, const gchar *str, GeanyFindFlags flags, GeanyMatchInfo **match_);
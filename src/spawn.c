@@ -750,6 +750,7 @@ typedef struct _SpawnChannelData
 	GString *buffer;       /* NULL if recursive */
 	GString *line_buffer;  /* NULL if char buffered */
 	gsize max_length;
+	gboolean line_batches;  /* pass all lines read at once */
 } SpawnChannelData;
 
 
@@ -805,30 +806,49 @@ static gboolean spawn_read_cb(GIOChannel *channel, GIOCondition condition, gpoin
 			while ((status = g_io_channel_read_chars(channel, line_buffer->str + n,
 				DEFAULT_IO_LENGTH, &chars_read, NULL)) == G_IO_STATUS_NORMAL)
 			{
+				gsize line_start = 0;  /* the lines before are complete */
+
 				g_string_set_size(line_buffer, n + chars_read);
 
+				/* split the lines in place and remove them all at once afterwards,
+				   erasing each line would move the rest of the buffer every time */
 				while (n < line_buffer->len)
 				{
-					gsize line_len = 0;
+					gsize line_end = 0;
 
-					if (n == sc->max_length)
-						line_len = n;
+					if (n - line_start == sc->max_length)
+						line_end = n;
 					else if (strchr("\n", line_buffer->str[n]))  /* '\n' or '\0' */
-						line_len = n + 1;
+						line_end = n + 1;
 					else if (n < line_buffer->len - 1 && line_buffer->str[n] == '\r')
-						line_len = n + 1 + (line_buffer->str[n + 1] == '\n');
+						line_end = n + 1 + (line_buffer->str[n + 1] == '\n');
 
-					if (!line_len)
+					if (!line_end)
 						n++;
 					else
 					{
-						g_string_append_len(buffer, line_buffer->str, line_len);
-						g_string_erase(line_buffer, 0, line_len);
-						/* input only, failures are reported separately below */
+						if (!sc->line_batches)
+						{
+							g_string_append_len(buffer, line_buffer->str + line_start,
+								line_end - line_start);
+							/* input only, failures are reported separately below */
+							sc->cb.read(buffer, input_cond, sc->cb_data);
+							g_string_truncate(buffer, 0);
+						}
+						n = line_start = line_end;
+					}
+				}
+
+				if (line_start)
+				{
+					if (sc->line_batches)
+					{
+						g_string_append_len(buffer, line_buffer->str, line_start);
 						sc->cb.read(buffer, input_cond, sc->cb_data);
 						g_string_truncate(buffer, 0);
-						n = 0;
 					}
+					g_string_erase(line_buffer, 0, line_start);
+					n -= line_start;
 				}
 
 				if (!failure_cond)
@@ -972,7 +992,8 @@ static void spawn_watch_cb(GPid pid, gint status, gpointer data)
  *  free them.
  *
  *  The default max lengths are 24K for line buffered stdout, 8K for line buffered stderr,
- *  4K for unbuffered input under Unix, and 2K for unbuffered input under Windows.
+ *  4K for unbuffered input under Unix, and 2K for unbuffered input under Windows. With
+ *  @c SPAWN_LINE_BATCHES, they limit the length of each line rather than of the whole batch.
  *
  *  @c exit_cb is always invoked last, after all I/O callbacks.
  *
@@ -1078,6 +1099,7 @@ gboolean spawn_with_callbacks(const gchar *working_directory, const gchar *comma
 				{
 					sc->line_buffer = g_string_sized_new(sc->max_length +
 						DEFAULT_IO_LENGTH);
+					sc->line_batches = (spawn_flags & SPAWN_LINE_BATCHES) != 0;
 				}
 			}
 
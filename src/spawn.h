@@ -59,7 +59,11 @@ typedef enum
 	SPAWN_STDIN_RECURSIVE      = 0x08,  /**< The stdin callback is recursive. */
 	SPAWN_STDOUT_RECURSIVE     = 0x10,  /**< The stdout callback is recursive. */
 	SPAWN_STDERR_RECURSIVE     = 0x20,  /**< The stderr callback is recursive. */
-	SPAWN_RECURSIVE            = 0x38   /**< All callbacks are recursive. */
+	SPAWN_RECURSIVE            = 0x38,  /**< All callbacks are recursive. */
+	/* line delivery */
+	/** Line buffered callbacks receive all complete lines read at once.
+	 *  @since 1.29 (API 231) */
+	SPAWN_LINE_BATCHES         = 0x40
 } SpawnFlags;
 
 /**
@@ -69,7 +73,8 @@ typedef enum
  *  In unbuffered mode, the @a string may contain nuls, while in line buffered mode, it may
  *  contain only a single nul as a line termination character at @a string->len - 1. In all
  *  cases, the @a string will be terminated with a nul character that is not part of the data
- *  at @a string->len.
+ *  at @a string->len. With @c SPAWN_LINE_BATCHES, a line buffered @a string contains one or
+ *  more lines, each with its line termination characters or nul.
  *
  *  If @c G_IO_IN or @c G_IO_PRI are set, the @a string will contain at least one character.
  *
@@ -1606,7 +1606,8 @@ static GeanyFiletype *detect_global_tags_filetype(const gchar *utf8_filename)
  * the relevant path.
  * Example:
  * CFLAGS=-I/home/user/libname-1.x geany -g libname.d.tags libname.h */
-int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess)
+int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess,
+	gboolean want_binary)
 {
 	/* -E pre-process, -dD output user macros, -p prof info (?) */
 	const char pre_process[] = "gcc -E -dD -p -I.";
@@ -1647,7 +1648,7 @@ int symbols_generate_global_tags(int argc, char **argv, gboolean want_preprocess
 		geany_debug("Generating %s tags file.", ft->name);
 		tm_get_workspace();
 		status = tm_workspace_create_global_tags(command, (const char **) (argv + 2),
-												 argc - 2, tags_file, ft->lang);
+												 argc - 2, tags_file, ft->lang, want_binary);
 		g_free(command);
 		symbols_finalize(); /* free c_tags_ignore data */
 		if (! status)
@@ -32,6 +32,14 @@ typedef struct {
 } CallbackUserData;
 
 
+#ifndef HAVE_THREAD_LOCAL
+/* Without thread-local storage the ctags core keeps the file being parsed in
+ * global state so only a single parse may run at a time; serializes parsing
+ * between the main thread and the background parsers of TMWorkspace. */
+static GMutex parse_mutex;
+#endif
+
+
 void tm_ctags_init(void)
 {
 	initializeParsing();
@@ -47,8 +55,12 @@ static gboolean parse_callback(const tagEntryInfo *tag, gpointer user_data)
 }
 
 
+/* Parses the file file_name, or buffer if it isn't NULL. If buffer2 isn't NULL,
+ * it is parsed as the continuation of buffer so the two parts of a gap buffer
+ * can be parsed without joining them. */
 void tm_ctags_parse(guchar *buffer, gsize buffer_size,
-	const gchar *file_name, TMParserType lang, TMCtagsNewTagCallback tag_callback,
+	guchar *buffer2, gsize buffer2_size, const gchar *file_name,
+	TMParserType lang, TMCtagsNewTagCallback tag_callback,
 	TMCtagsPassStartCallback pass_callback, gpointer user_data)
 {
 	CallbackUserData callback_data = {tag_callback, user_data};
@@ -65,6 +77,9 @@ void tm_ctags_parse(guchar *buffer, gsize buffer_size,
 		return;
 	}
 
+#ifndef HAVE_THREAD_LOCAL
+	g_mutex_lock(&parse_mutex);
+#endif
 	setTagEntryFunction(parse_callback, &callback_data);
 	while (retry && passCount < 3)
 	{
@@ -82,7 +97,8 @@ void tm_ctags_parse(guchar *buffer, gsize buffer_size,
 				retry = LanguageTable [lang]->parser2 (passCount);
 			fileClose ();
 		}
-		else if (buffer && bufferOpen (buffer, buffer_size, file_name, lang))
+		else if (buffer && bufferOpen (buffer, buffer_size, buffer2, buffer2_size,
+			file_name, lang))
 		{
 			if (LanguageTable [lang]->parser != NULL)
 			{
@@ -98,10 +114,24 @@ void tm_ctags_parse(guchar *buffer, gsize buffer_size,
 		else
 		{
 			g_warning("Unable to open %s", file_name);
-			return;
+			break;
 		}
 		++ passCount;
 	}
+#ifndef HAVE_THREAD_LOCAL
+	g_mutex_unlock(&parse_mutex);
+#endif
+}
+
+
+/* Whether tm_ctags_parse() may run in several threads at the same time. */
+gboolean tm_ctags_is_reentrant(void)
+{
+#ifdef HAVE_THREAD_LOCAL
+	return TRUE;
+#else
+	return FALSE;
+#endif
 }
 
 
@@ -43,9 +43,11 @@ typedef gboolean (*TMCtagsPassStartCallback) (void *user_data);
 void tm_ctags_init(void);
 
 void tm_ctags_parse(guchar *buffer, gsize buffer_size,
-	const gchar *file_name, TMParserType lang, TMCtagsNewTagCallback tag_callback,
+	guchar *buffer2, gsize buffer2_size, const gchar *file_name, TMParserType lang, TMCtagsNewTagCallback tag_callback,
 	TMCtagsPassStartCallback pass_callback, gpointer user_data);
 
+gboolean tm_ctags_is_reentrant(void);
+
 const gchar *tm_ctags_get_lang_name(TMParserType lang);
 
 TMParserType tm_ctags_get_named_lang(const gchar *name);
@@ -0,0 +1,383 @@
+/*
+ *      tm_name_index.c - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* The name index keeps one entry per unique tag name and language, sorted by
+ * name, so that the names starting with a prefix can be looked up with a binary
+ * search followed by a walk over exactly the entries which are returned. It is
+ * updated with the tags of a file whenever the file is reparsed instead of being
+ * rebuilt from the tag arrays. */
+
+#include "tm_name_index.h"
+
+#include <string.h>
+
+
+typedef struct
+{
+	const gchar *name;		/* the name of tag */
+	TMTag *tag;				/* a tag with the name; returned by the lookups */
+	GPtrArray *more_tags;	/* the other tags with the name, or NULL */
+} NameEntry;
+
+struct TMNameIndex
+{
+	/* maps TMParserType to a GArray of NameEntry sorted by name */
+	GHashTable *languages;
+};
+
+
+TMNameIndex *tm_name_index_new(void)
+{
+	TMNameIndex *index = g_new(TMNameIndex, 1);
+
+	index->languages = g_hash_table_new(g_direct_hash, g_direct_equal);
+	return index;
+}
+
+
+static void free_entries(GArray *entries)
+{
+	guint i;
+
+	for (i = 0; i < entries->len; i++)
+	{
+		NameEntry *entry = &g_array_index(entries, NameEntry, i);
+
+		if (entry->more_tags)
+			g_ptr_array_free(entry->more_tags, TRUE);
+	}
+	g_array_free(entries, TRUE);
+}
+
+
+/* Removes all tags from the index */
+void tm_name_index_clear(TMNameIndex *index)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init(&iter, index->languages);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		free_entries(value);
+	g_hash_table_remove_all(index->languages);
+}
+
+
+void tm_name_index_free(TMNameIndex *index)
+{
+	if (!index)
+		return;
+
+	tm_name_index_clear(index);
+	g_hash_table_destroy(index->languages);
+	g_free(index);
+}
+
+
+static gboolean is_indexed(const TMTag *tag)
+{
+	return tag->lang != TM_PARSER_NONE && !tm_tag_is_anon(tag);
+}
+
+
+/* Sets pos to the first entry whose name isn't smaller than name and returns
+ * whether the entry has exactly this name */
+static gboolean find_entry(GArray *entries, const gchar *name, guint *pos)
+{
+	guint l = 0, u = entries->len;
+
+	while (l < u)
+	{
+		guint idx = (l + u) / 2;
+
+		if (strcmp(g_array_index(entries, NameEntry, idx).name, name) < 0)
+			l = idx + 1;
+		else
+			u = idx;
+	}
+	*pos = l;
+	return l < entries->len && strcmp(g_array_index(entries, NameEntry, l).name, name) == 0;
+}
+
+
+static void entry_add_tag(NameEntry *entry, TMTag *tag)
+{
+	if (!entry->tag)
+	{
+		entry->tag = tag;
+		entry->name = tag->name;
+	}
+	else
+	{
+		if (!entry->more_tags)
+			entry->more_tags = g_ptr_array_sized_new(1);
+		g_ptr_array_add(entry->more_tags, tag);
+	}
+}
+
+
+/* Returns TRUE if the entry doesn't contain any tag after the removal */
+static gboolean entry_remove_tag(NameEntry *entry, TMTag *tag)
+{
+	if (entry->tag == tag)
+	{
+		if (entry->more_tags && entry->more_tags->len > 0)
+		{
+			/* the name has to stay valid after tag is freed */
+			entry->tag = g_ptr_array_remove_index_fast(entry->more_tags,
+				entry->more_tags->len - 1);
+			entry->name = entry->tag->name;
+		}
+		else
+			entry->tag = NULL;
+	}
+	else if (entry->more_tags)
+		g_ptr_array_remove_fast(entry->more_tags, tag);
+
+	if (entry->more_tags && entry->more_tags->len == 0)
+	{
+		g_ptr_array_free(entry->more_tags, TRUE);
+		entry->more_tags = NULL;
+	}
+	return entry->tag == NULL;
+}
+
+
+static gint compare_tag_names(gconstpointer a, gconstpointer b)
+{
+	const TMTag *t1 = *((const TMTag **) a);
+	const TMTag *t2 = *((const TMTag **) b);
+
+	return strcmp(t1->name, t2->name);
+}
+
+
+/* Creates the entries for new_tags, none of which has an entry yet, and merges
+ * them with the entries of lang in a single pass */
+static void insert_new_tags(TMNameIndex *index, TMParserType lang, GPtrArray *new_tags)
+{
+	GArray *entries = g_hash_table_lookup(index->languages, GINT_TO_POINTER(lang));
+	GArray *merged;
+	guint old_len = entries ? entries->len : 0;
+	guint i = 0, j;
+
+	g_ptr_array_sort(new_tags, compare_tag_names);
+
+	merged = g_array_sized_new(FALSE, FALSE, sizeof(NameEntry), old_len + new_tags->len);
+	for (j = 0; j < new_tags->len; j++)
+	{
+		TMTag *tag = new_tags->pdata[j];
+		NameEntry *last;
+
+		while (i < old_len && strcmp(g_array_index(entries, NameEntry, i).name, tag->name) < 0)
+		{
+			g_array_append_val(merged, g_array_index(entries, NameEntry, i));
+			i++;
+		}
+
+		/* the old entries have different names so only a new entry can match */
+		last = merged->len > 0 ? &g_array_index(merged, NameEntry, merged->len - 1) : NULL;
+		if (last && strcmp(last->name, tag->name) == 0)
+			entry_add_tag(last, tag);
+		else
+		{
+			NameEntry entry = {NULL, NULL, NULL};
+
+			entry_add_tag(&entry, tag);
+			g_array_append_val(merged, entry);
+		}
+	}
+	if (i < old_len)
+		g_array_append_vals(merged, &g_array_index(entries, NameEntry, i), old_len - i);
+
+	/* the entries were moved to merged including their more_tags */
+	if (entries)
+		g_array_free(entries, TRUE);
+	g_hash_table_insert(index->languages, GINT_TO_POINTER(lang), merged);
+}
+
+
+/* Adds tags to the index. Names which are already present only get the tag added
+ * to their entry; the entries of new names are merged in once per language. */
+void tm_name_index_add_tags(TMNameIndex *index, const GPtrArray *tags)
+{
+	GHashTable *new_tags = NULL;
+	GHashTableIter iter;
+	gpointer key, value;
+	guint i;
+
+	g_return_if_fail(index != NULL);
+
+	if (!tags)
+		return;
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+		GArray *entries;
+		GPtrArray *lang_tags;
+		guint pos;
+
+		if (!is_indexed(tag))
+			continue;
+
+		entries = g_hash_table_lookup(index->languages, GINT_TO_POINTER(tag->lang));
+		if (entries && find_entry(entries, tag->name, &pos))
+		{
+			entry_add_tag(&g_array_index(entries, NameEntry, pos), tag);
+			continue;
+		}
+
+		if (!new_tags)
+			new_tags = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+				(GDestroyNotify) g_ptr_array_unref);
+		lang_tags = g_hash_table_lookup(new_tags, GINT_TO_POINTER(tag->lang));
+		if (!lang_tags)
+		{
+			lang_tags = g_ptr_array_new();
+			g_hash_table_insert(new_tags, GINT_TO_POINTER(tag->lang), lang_tags);
+		}
+		g_ptr_array_add(lang_tags, tag);
+	}
+
+	if (!new_tags)
+		return;
+
+	g_hash_table_iter_init(&iter, new_tags);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		insert_new_tags(index, GPOINTER_TO_INT(key), value);
+	g_hash_table_destroy(new_tags);
+}
+
+
+/* Drops the entries without any tag, keeping the order of the others */
+static void remove_empty_entries(TMNameIndex *index, TMParserType lang)
+{
+	GArray *entries = g_hash_table_lookup(index->languages, GINT_TO_POINTER(lang));
+	guint i, len = 0;
+
+	for (i = 0; i < entries->len; i++)
+	{
+		NameEntry *entry = &g_array_index(entries, NameEntry, i);
+
+		if (entry->tag)
+			g_array_index(entries, NameEntry, len++) = *entry;
+	}
+
+	if (len > 0)
+		g_array_set_size(entries, len);
+	else
+	{
+		g_hash_table_remove(index->languages, GINT_TO_POINTER(lang));
+		g_array_free(entries, TRUE);
+	}
+}
+
+
+/* Removes tags from the index; tags which aren't in the index are ignored */
+void tm_name_index_remove_tags(TMNameIndex *index, const GPtrArray *tags)
+{
+	GHashTable *emptied_langs = NULL;
+	GHashTableIter iter;
+	gpointer key;
+	guint i;
+
+	g_return_if_fail(index != NULL);
+
+	if (!tags)
+		return;
+
+	for (i = 0; i < tags->len; i++)
+	{
+		TMTag *tag = tags->pdata[i];
+		GArray *entries;
+		guint pos;
+
+		if (!is_indexed(tag))
+			continue;
+
+		entries = g_hash_table_lookup(index->languages, GINT_TO_POINTER(tag->lang));
+		if (!entries || !find_entry(entries, tag->name, &pos))
+			continue;
+
+		/* the emptied entry keeps its name (the tags are still alive) so the array
+		 * stays sorted for the following lookups until it is dropped below */
+		if (entry_remove_tag(&g_array_index(entries, NameEntry, pos), tag))
+		{
+			if (!emptied_langs)
+				emptied_langs = g_hash_table_new(g_direct_hash, g_direct_equal);
+			g_hash_table_add(emptied_langs, GINT_TO_POINTER(tag->lang));
+		}
+	}
+
+	if (!emptied_langs)
+		return;
+
+	g_hash_table_iter_init(&iter, emptied_langs);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		remove_empty_entries(index, GPOINTER_TO_INT(key));
+	g_hash_table_destroy(emptied_langs);
+}
+
+
+/* Adds to dst up to max_num tags with unique names starting with prefix, sorted by
+ * name. Only the names of the languages compatible with lang are considered. */
+void tm_name_index_find_prefix(TMNameIndex *index, GPtrArray *dst, const gchar *prefix,
+	TMParserType lang, guint max_num)
+{
+	TMTagAttrType attrs[] = { tm_tag_attr_name_t, 0 };
+	GHashTableIter iter;
+	gpointer key, value;
+	gsize prefix_len;
+	guint n_langs = 0;
+
+	g_return_if_fail(index != NULL);
+
+	if (!dst || !prefix || !*prefix)
+		return;
+
+	prefix_len = strlen(prefix);
+	g_hash_table_iter_init(&iter, index->languages);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		GArray *entries = value;
+		guint pos, num;
+
+		if (!tm_tag_langs_compatible(lang, GPOINTER_TO_INT(key)))
+			continue;
+
+		find_entry(entries, prefix, &pos);
+		for (num = 0; pos < entries->len && num < max_num; pos++, num++)
+		{
+			NameEntry *entry = &g_array_index(entries, NameEntry, pos);
+
+			if (strncmp(entry->name, prefix, prefix_len) != 0)
+				break;
+			g_ptr_array_add(dst, entry->tag);
+		}
+		n_langs++;
+	}
+
+	/* names of compatible languages (C and C++) may repeat */
+	if (n_langs > 1)
+	{
+		tm_tags_sort(dst, attrs, TRUE, FALSE);
+		if (dst->len > max_num)
+			g_ptr_array_set_size(dst, max_num);
+	}
+}
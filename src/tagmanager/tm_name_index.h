@@ -0,0 +1,50 @@
+/*
+ *      tm_name_index.h - this file is part of Geany, a fast and lightweight IDE
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License along
+ *      with this program; if not, write to the Free Software Foundation, Inc.,
+ *      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef TM_NAME_INDEX_H
+#define TM_NAME_INDEX_H
+
+#include <glib.h>
+
+#include "tm_tag.h"
+#include "tm_parser.h"
+
+
+G_BEGIN_DECLS
+
+/* Index of the unique tag names of each language for prefix lookups. The tags
+ * are not referenced and have to be removed before they are freed. */
+typedef struct TMNameIndex TMNameIndex;
+
+
+TMNameIndex *tm_name_index_new(void);
+
+void tm_name_index_free(TMNameIndex *index);
+
+void tm_name_index_add_tags(TMNameIndex *index, const GPtrArray *tags);
+
+void tm_name_index_remove_tags(TMNameIndex *index, const GPtrArray *tags);
+
+void tm_name_index_clear(TMNameIndex *index);
+
+void tm_name_index_find_prefix(TMNameIndex *index, GPtrArray *dst, const gchar *prefix,
+	TMParserType lang, guint max_num);
+
+G_END_DECLS
+
+#endif /* TM_NAME_INDEX_H */
@@ -38,6 +38,14 @@ typedef struct
 	guint refcount;
 } TMSourceFilePriv;
 
+/* Where the ctags callbacks store the tags of the file being parsed */
+typedef struct
+{
+	TMSourceFile *source_file;
+	GPtrArray *tags_array;
+	TMTagArena *arena;
+} ParseData;
+
 
 typedef enum {
 	TM_FILE_FORMAT_TAGMANAGER,
@@ -66,6 +74,44 @@ enum
 	TA_POINTER
 };
 
+/* The binary tags file format: a header, the tag records sorted by
+ * global_tags_sort_attrs and a table of NUL-terminated strings the records
+ * point to by offset. The file is mapped into memory and the strings of the
+ * tags point into it directly. */
+#define BINARY_TAGS_MAGIC "GEANYTAG"
+#define BINARY_TAGS_MAGIC_LEN 8
+/* Increment when changing the layout of BinaryTagsHeader or BinaryTag */
+#define BINARY_TAGS_VERSION 1
+/* Written in the native byte order to detect files created on other machines */
+#define BINARY_TAGS_BYTE_ORDER 0x01020304
+#define BINARY_TAGS_NO_STRING G_MAXUINT32
+
+typedef struct
+{
+	gchar magic[BINARY_TAGS_MAGIC_LEN];
+	guint32 version;
+	guint32 byte_order;
+	guint32 tag_count;
+	guint32 tags_offset;
+	guint32 strings_offset;
+	guint32 strings_size;
+} BinaryTagsHeader;
+
+typedef struct
+{
+	guint32 name;
+	guint32 arglist;
+	guint32 scope;
+	guint32 inheritance;
+	guint32 var_type;
+	guint32 type;
+	guint32 pointer_order;
+	gchar access;
+	gchar impl;
+	gchar local;
+	gchar padding;
+} BinaryTag;
+
 
 #define SOURCE_FILE_NEW(S) ((S) = g_slice_new(TMSourceFilePriv))
 #define SOURCE_FILE_FREE(S) g_slice_free(TMSourceFilePriv, (TMSourceFilePriv *) S)
@@ -183,20 +229,20 @@ static gboolean init_tag(TMTag *tag, TMSourceFile *file, const tagEntryInfo *tag
 	if (!tag_entry->name || type == tm_tag_undef_t)
 		return FALSE;
 
-	tag->name = g_strdup(tag_entry->name);
+	tag->name = tm_tag_intern_string(tag, tag_entry->name);
 	tag->type = type;
 	tag->local = tag_entry->isFileScope;
 	tag->pointerOrder = 0;	/* backward compatibility (use var_type instead) */
 	tag->line = tag_entry->lineNumber;
 	if (NULL != tag_entry->extensionFields.arglist)
-		tag->arglist = g_strdup(tag_entry->extensionFields.arglist);
+		tag->arglist = tm_tag_intern_string(tag, tag_entry->extensionFields.arglist);
 	if ((NULL != tag_entry->extensionFields.scope[1]) &&
 		(0 != tag_entry->extensionFields.scope[1][0]))
-		tag->scope = g_strdup(tag_entry->extensionFields.scope[1]);
+		tag->scope = tm_tag_intern_string(tag, tag_entry->extensionFields.scope[1]);
 	if (tag_entry->extensionFields.inheritance != NULL)
-		tag->inheritance = g_strdup(tag_entry->extensionFields.inheritance);
+		tag->inheritance = tm_tag_intern_string(tag, tag_entry->extensionFields.inheritance);
 	if (tag_entry->extensionFields.varType != NULL)
-		tag->var_type = g_strdup(tag_entry->extensionFields.varType);
+		tag->var_type = tm_tag_intern_string(tag, tag_entry->extensionFields.varType);
 	if (tag_entry->extensionFields.access != NULL)
 		tag->access = get_tag_access(tag_entry->extensionFields.access);
 	if (tag_entry->extensionFields.implementation != NULL)
@@ -239,7 +285,7 @@ static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp)
 			if (!isprint(*start))
 				return FALSE;
 			else
-				tag->name = g_strdup((gchar*)start);
+				tag->name = tm_tag_intern_string(tag, (gchar*)start);
 		}
 		else
 		{
@@ -255,19 +301,19 @@ static gboolean init_tag_from_file(TMTag *tag, TMSourceFile *file, FILE *fp)
 					tag->type = (TMTagType) atoi((gchar*)start + 1);
 					break;
 				case TA_ARGLIST:
-					tag->arglist = g_strdup((gchar*)start + 1);
+					tag->arglist = tm_tag_intern_string(tag, (gchar*)start + 1);
 					break;
 				case TA_SCOPE:
-					tag->scope = g_strdup((gchar*)start + 1);
+					tag->scope = tm_tag_intern_string(tag, (gchar*)start + 1);
 					break;
 				case TA_POINTER:
 					tag->pointerOrder = atoi((gchar*)start + 1);
 					break;
 				case TA_VARTYPE:
-					tag->var_type = g_strdup((gchar*)start + 1);
+					tag->var_type = tm_tag_intern_string(tag, (gchar*)start + 1);
 					break;
 				case TA_INHERITS:
-					tag->inheritance = g_strdup((gchar*)start + 1);
+					tag->inheritance = tm_tag_intern_string(tag, (gchar*)start + 1);
 					break;
 				case TA_TIME:  /* Obsolete */
 					break;
@@ -325,10 +371,10 @@ static gboolean init_tag_from_file_alt(TMTag *tag, TMSourceFile *file, FILE *fp)
 			fields = g_strsplit((gchar*)start, "|", -1);
 			field_len = g_strv_length(fields);
 
-			if (field_len >= 1) tag->name = g_strdup(fields[0]);
+			if (field_len >= 1) tag->name = tm_tag_intern_string(tag, fields[0]);
 			else tag->name = NULL;
-			if (field_len >= 2 && fields[1] != NULL) tag->var_type = g_strdup(fields[1]);
-			if (field_len >= 3 && fields[2] != NULL) tag->arglist = g_strdup(fields[2]);
+			if (field_len >= 2 && fields[1] != NULL) tag->var_type = tm_tag_intern_string(tag, fields[1]);
+			if (field_len >= 3 && fields[2] != NULL) tag->arglist = tm_tag_intern_string(tag, fields[2]);
 			tag->type = tm_tag_prototype_t;
 			g_strfreev(fields);
 		}
@@ -362,13 +408,13 @@ static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE *f
 	/* tag name */
 	if (! (tab = strchr(p, '\t')) || p == tab)
 		return FALSE;
-	tag->name = g_strndup(p, (gsize)(tab - p));
+	*tab = '\0';
+	tag->name = tm_tag_intern_string(tag, p);
 	p = tab + 1;
 
 	/* tagfile, unused */
 	if (! (tab = strchr(p, '\t')))
 	{
-		g_free(tag->name);
 		tag->name = NULL;
 		return FALSE;
 	}
@@ -423,8 +469,7 @@ static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE *f
 			}
 			else if (0 == strcmp(key, "inherits")) /* comma-separated list of classes this class inherits from */
 			{
-				g_free(tag->inheritance);
-				tag->inheritance = g_strdup(value);
+				tag->inheritance = tm_tag_intern_string(tag, value);
 			}
 			else if (0 == strcmp(key, "implementation")) /* implementation limit */
 				tag->impl = get_tag_impl(value);
@@ -438,15 +483,13 @@ static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE *f
 					 0 == strcmp(key, "struct") ||
 					 0 == strcmp(key, "union")) /* Name of the class/enum/function/struct/union in which this tag is a member */
 			{
-				g_free(tag->scope);
-				tag->scope = g_strdup(value);
+				tag->scope = tm_tag_intern_string(tag, value);
 			}
 			else if (0 == strcmp(key, "file")) /* static (local) tag */
 				tag->local = TRUE;
 			else if (0 == strcmp(key, "signature")) /* arglist */
 			{
-				g_free(tag->arglist);
-				tag->arglist = g_strdup(value);
+				tag->arglist = tm_tag_intern_string(tag, value);
 			}
 		}
 	}
@@ -455,9 +498,10 @@ static gboolean init_tag_from_file_ctags(TMTag *tag, TMSourceFile *file, FILE *f
 	return TRUE;
 }
 
-static TMTag *new_tag_from_tags_file(TMSourceFile *file, FILE *fp, TMParserType mode, TMFileFormat format)
+static TMTag *new_tag_from_tags_file(TMTagArena *arena, TMSourceFile *file, FILE *fp,
+	TMParserType mode, TMFileFormat format)
 {
-	TMTag *tag = tm_tag_new();
+	TMTag *tag = tm_tag_new(arena);
 	gboolean result = FALSE;
 
 	switch (format)
@@ -525,6 +569,7 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 	FILE *fp;
 	GPtrArray *file_tags;
 	TMTag *tag;
+	TMTagArena *arena;
 	TMFileFormat format = TM_FILE_FORMAT_TAGMANAGER;
 
 	if (NULL == (fp = g_fopen(tags_file, "r")))
@@ -534,6 +579,11 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 		fclose(fp);
 		return NULL; /* early out on error */
 	}
+	else if (strncmp((gchar*) buf, BINARY_TAGS_MAGIC, BINARY_TAGS_MAGIC_LEN) == 0)
+	{	/* binary files are read by tm_source_file_read_binary_tags_file() */
+		fclose(fp);
+		return NULL;
+	}
 	else
 	{	/* We read the first line for the format specification. */
 		if (buf[0] == '#' && strstr((gchar*) buf, "format=pipe") != NULL)
@@ -565,8 +615,10 @@ GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mo
 	}
 
 	file_tags = g_ptr_array_new();
-	while (NULL != (tag = new_tag_from_tags_file(NULL, fp, mode, format)))
+	arena = tm_tag_arena_new();
+	while (NULL != (tag = new_tag_from_tags_file(arena, NULL, fp, mode, format)))
 		g_ptr_array_add(file_tags, tag);
+	tm_tag_arena_unref(arena);
 	fclose(fp);
 
 	return file_tags;
@@ -601,8 +653,184 @@ gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_
 	return ret;
 }
 
+/* Returns the offset of str in the string table, adding it when needed */
+static guint32 add_binary_string(GHashTable *offsets, GString *strings, const gchar *str)
+{
+	gpointer offset;
+
+	if (!str)
+		return BINARY_TAGS_NO_STRING;
+	if (g_hash_table_lookup_extended(offsets, str, NULL, &offset))
+		return GPOINTER_TO_UINT(offset);
+
+	offset = GUINT_TO_POINTER(strings->len);
+	g_hash_table_insert(offsets, (gpointer) str, offset);
+	g_string_append_len(strings, str, strlen(str) + 1);
+	return GPOINTER_TO_UINT(offset);
+}
+
+
+/* Writes the tags in the binary format read by tm_source_file_read_binary_tags_file().
+ * tags_array has to be sorted and deduplicated on global_tags_sort_attrs
+ * because the tags are loaded as they are stored. */
+gboolean tm_source_file_write_binary_tags_file(const gchar *tags_file, GPtrArray *tags_array)
+{
+	BinaryTagsHeader header;
+	BinaryTag *records;
+	GHashTable *offsets;
+	GString *strings;
+	FILE *fp;
+	guint i;
+	gboolean ret;
+
+	g_return_val_if_fail(tags_array && tags_file, FALSE);
+
+	records = g_new0(BinaryTag, tags_array->len);
+	offsets = g_hash_table_new(g_str_hash, g_str_equal);
+	strings = g_string_new(NULL);
+	for (i = 0; i < tags_array->len; i++)
+	{
+		TMTag *tag = TM_TAG(tags_array->pdata[i]);
+		BinaryTag *record = &records[i];
+
+		record->name = add_binary_string(offsets, strings, tag->name);
+		record->arglist = add_binary_string(offsets, strings, tag->arglist);
+		record->scope = add_binary_string(offsets, strings, tag->scope);
+		record->inheritance = add_binary_string(offsets, strings, tag->inheritance);
+		record->var_type = add_binary_string(offsets, strings, tag->var_type);
+		record->type = tag->type;
+		record->pointer_order = tag->pointerOrder;
+		record->access = tag->access;
+		record->impl = tag->impl;
+		record->local = tag->local ? 1 : 0;
+	}
+	g_hash_table_destroy(offsets);
+
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, BINARY_TAGS_MAGIC, BINARY_TAGS_MAGIC_LEN);
+	header.version = BINARY_TAGS_VERSION;
+	header.byte_order = BINARY_TAGS_BYTE_ORDER;
+	header.tag_count = tags_array->len;
+	header.tags_offset = sizeof header;
+	header.strings_offset = header.tags_offset + tags_array->len * sizeof(BinaryTag);
+	header.strings_size = strings->len;
+
+	fp = g_fopen(tags_file, "wb");
+	ret = fp != NULL &&
+		fwrite(&header, sizeof header, 1, fp) == 1 &&
+		fwrite(records, sizeof(BinaryTag), tags_array->len, fp) == tags_array->len &&
+		fwrite(strings->str, 1, strings->len, fp) == strings->len;
+	if (fp && fclose(fp) != 0)
+		ret = FALSE;
+
+	g_string_free(strings, TRUE);
+	g_free(records);
+
+	return ret;
+}
+
+
+/* Returns the string at offset in the string table, NULL when there is none or
+ * FALSE when the offset is invalid */
+static gboolean get_binary_string(const gchar *strings, guint32 strings_size,
+	guint32 offset, gchar **str)
+{
+	if (offset == BINARY_TAGS_NO_STRING)
+		*str = NULL;
+	else if (offset < strings_size)
+		*str = (gchar *) strings + offset;
+	else
+		return FALSE;
+	return TRUE;
+}
+
+
+/* Loads a tags file written by tm_source_file_write_binary_tags_file(). The file
+ * stays mapped while its tags exist and the returned array is already sorted and
+ * deduplicated on global_tags_sort_attrs.
+ * Returns NULL if tags_file isn't a valid binary tags file. */
+GPtrArray *tm_source_file_read_binary_tags_file(const gchar *tags_file, TMParserType mode)
+{
+	GMappedFile *mapped;
+	const BinaryTagsHeader *header;
+	const BinaryTag *records;
+	const gchar *contents, *strings;
+	GPtrArray *file_tags;
+	TMTagArena *arena;
+	gsize length;
+	guint i;
+
+	mapped = g_mapped_file_new(tags_file, FALSE, NULL);
+	if (!mapped)
+		return NULL;
+
+	contents = g_mapped_file_get_contents(mapped);
+	length = g_mapped_file_get_length(mapped);
+	header = (const BinaryTagsHeader *) contents;
+	if (length < sizeof *header ||
+		memcmp(header->magic, BINARY_TAGS_MAGIC, BINARY_TAGS_MAGIC_LEN) != 0)
+	{
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+	if (header->version != BINARY_TAGS_VERSION || header->byte_order != BINARY_TAGS_BYTE_ORDER)
+	{
+		g_warning("Tags file %s was created by an incompatible version of Geany or "
+			"on a different architecture, please regenerate it", tags_file);
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+	if (header->tags_offset % sizeof(guint32) != 0 ||
+		(guint64) header->tags_offset + (guint64) header->tag_count * sizeof(BinaryTag) > length ||
+		(guint64) header->strings_offset + header->strings_size > length ||
+		header->strings_size == 0 ||
+		contents[header->strings_offset + header->strings_size - 1] != '\0')
+	{
+		g_warning("Tags file %s is corrupted", tags_file);
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+
+	records = (const BinaryTag *) (contents + header->tags_offset);
+	strings = contents + header->strings_offset;
+	file_tags = g_ptr_array_sized_new(header->tag_count);
+	arena = tm_tag_arena_new();
+	tm_tag_arena_set_mapped_file(arena, mapped);
+	for (i = 0; i < header->tag_count; i++)
+	{
+		const BinaryTag *record = &records[i];
+		TMTag *tag = tm_tag_new(arena);
+
+		if (!get_binary_string(strings, header->strings_size, record->name, &tag->name) ||
+			!get_binary_string(strings, header->strings_size, record->arglist, &tag->arglist) ||
+			!get_binary_string(strings, header->strings_size, record->scope, &tag->scope) ||
+			!get_binary_string(strings, header->strings_size, record->inheritance, &tag->inheritance) ||
+			!get_binary_string(strings, header->strings_size, record->var_type, &tag->var_type) ||
+			!tag->name)
+		{
+			g_warning("Tags file %s is corrupted", tags_file);
+			tm_tag_unref(tag);
+			tm_tags_array_free(file_tags, TRUE);
+			file_tags = NULL;
+			break;
+		}
+		tag->type = record->type;
+		tag->pointerOrder = record->pointer_order;
+		tag->access = record->access;
+		tag->impl = record->impl;
+		tag->local = record->local;
+		tag->file = NULL;
+		tag->lang = mode;
+		g_ptr_array_add(file_tags, tag);
+	}
+	tm_tag_arena_unref(arena);
+	g_mapped_file_unref(mapped);
+
+	return file_tags;
+}
+
 /* add argument list of __init__() Python methods to the class tag */
-static void update_python_arglist(const TMTag *tag, TMSourceFile *current_source_file)
+static void update_python_arglist(const TMTag *tag, GPtrArray *tags_array)
 {
 	guint i;
 	const char *parent_tag_name;
@@ -618,13 +846,12 @@ static void update_python_arglist(const TMTag *tag, TMSourceFile *current_source
 		parent_tag_name = tag->scope;
 
 	/* going in reverse order because the tag was added recently */
-	for (i = current_source_file->tags_array->len; i > 0; i--)
+	for (i = tags_array->len; i > 0; i--)
 	{
-		TMTag *prev_tag = (TMTag *) current_source_file->tags_array->pdata[i - 1];
+		TMTag *prev_tag = (TMTag *) tags_array->pdata[i - 1];
 		if (g_strcmp0(prev_tag->name, parent_tag_name) == 0)
 		{
-			g_free(prev_tag->arglist);
-			prev_tag->arglist = g_strdup(tag->arglist);
+			prev_tag->arglist = tm_tag_intern_string(prev_tag, tag->arglist);
 			break;
 		}
 	}
@@ -633,9 +860,9 @@ static void update_python_arglist(const TMTag *tag, TMSourceFile *current_source
 /* new parsing pass ctags callback function */
 static gboolean ctags_pass_start(void *user_data)
 {
-	TMSourceFile *current_source_file = user_data;
+	ParseData *data = user_data;
 
-	tm_tags_array_free(current_source_file->tags_array, FALSE);
+	tm_tags_array_free(data->tags_array, FALSE);
 	return TRUE;
 }
 
@@ -643,19 +870,19 @@ static gboolean ctags_pass_start(void *user_data)
 static gboolean ctags_new_tag(const tagEntryInfo *const tag,
 	void *user_data)
 {
-	TMSourceFile *current_source_file = user_data;
-	TMTag *tm_tag = tm_tag_new();
+	ParseData *data = user_data;
+	TMTag *tm_tag = tm_tag_new(data->arena);
 
-	if (!init_tag(tm_tag, current_source_file, tag))
+	if (!init_tag(tm_tag, data->source_file, tag))
 	{
 		tm_tag_unref(tm_tag);
 		return TRUE;
 	}
 
 	if (tm_tag->lang == TM_PARSER_PYTHON)
-		update_python_arglist(tm_tag, current_source_file);
+		update_python_arglist(tm_tag, data->tags_array);
 
-	g_ptr_array_add(current_source_file->tags_array, tm_tag);
+	g_ptr_array_add(data->tags_array, tm_tag);
 
 	return TRUE;
 }
@@ -724,7 +951,9 @@ TMSourceFile *tm_source_file_new(const char *file_name, const char *name)
 }
 
 
-static TMSourceFile *tm_source_file_dup(TMSourceFile *source_file)
+/* Increments the reference count of source_file - used to keep the source file
+ alive while it is being parsed in the background. */
+TMSourceFile *tm_source_file_dup(TMSourceFile *source_file)
 {
 	TMSourceFilePriv *priv = (TMSourceFilePriv *) source_file;
 
@@ -781,17 +1010,21 @@ G_DEFINE_BOXED_TYPE(TMSourceFile, tm_source_file, tm_source_file_dup, tm_source_
  @param source_file The source file to parse
  @param text_buf The text buffer to parse
  @param buf_size The size of text_buf.
+ @param text_buf2 The text following text_buf, or NULL. Allows parsing both parts
+ of a gap buffer without joining them.
+ @param buf2_size The size of text_buf2.
  @param use_buffer Set FALSE to ignore the buffer and parse the file directly or
  TRUE to parse the buffer and ignore the file content.
  @return TRUE on success, FALSE on failure
 */
 gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
-	gboolean use_buffer)
+	guchar *text_buf2, gsize buf2_size, gboolean use_buffer)
 {
 	const char *file_name;
 	gboolean retry = TRUE;
 	gboolean parse_file = FALSE;
 	gboolean free_buf = FALSE;
+	ParseData data;
 
 	if ((NULL == source_file) || (NULL == source_file->file_name))
 	{
@@ -823,9 +1056,12 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 			}
 			free_buf = TRUE;
 		}
+		text_buf2 = NULL;
 	}
 
-	if (!parse_file && (NULL == text_buf || 0 == buf_size))
+	if (NULL == text_buf2)
+		buf2_size = 0;
+	if (!parse_file && (NULL == text_buf || 0 == buf_size) && 0 == buf2_size)
 	{
 		/* Empty buffer, "parse" by setting empty tag array */
 		tm_tags_array_free(source_file->tags_array, FALSE);
@@ -836,14 +1072,56 @@ gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize
 
 	tm_tags_array_free(source_file->tags_array, FALSE);
 
-	tm_ctags_parse(parse_file ? NULL : text_buf, buf_size, file_name,
-		source_file->lang, ctags_new_tag, ctags_pass_start, source_file);
+	data.source_file = source_file;
+	data.tags_array = source_file->tags_array;
+	data.arena = tm_tag_arena_new();
+	if (!parse_file && (NULL == text_buf || 0 == buf_size))
+	{
+		/* only the part after the gap contains text */
+		text_buf = text_buf2;
+		buf_size = buf2_size;
+		text_buf2 = NULL;
+		buf2_size = 0;
+	}
+	tm_ctags_parse(parse_file ? NULL : text_buf, buf_size, text_buf2, buf2_size,
+		file_name, source_file->lang, ctags_new_tag, ctags_pass_start, &data);
+	tm_tag_arena_unref(data.arena);
 
 	if (free_buf)
 		g_free(text_buf);
 	return !retry;
 }
 
+/* Parses the text-buffer into a new tag array and leaves the tags of the source
+ file untouched. Because neither source_file nor its current tags are modified,
+ this can be called from a worker thread while the main thread still uses the
+ old tags; the caller is responsible for swapping the arrays afterwards.
+ @param source_file The source file the buffer belongs to
+ @param text_buf The text buffer to parse
+ @param buf_size The size of text_buf.
+ @return A new (unsorted) array of tags owned by the caller.
+*/
+GPtrArray *tm_source_file_parse_to_array(TMSourceFile *source_file, guchar* text_buf,
+	gsize buf_size)
+{
+	ParseData data;
+
+	g_return_val_if_fail(source_file != NULL && source_file->file_name != NULL, NULL);
+
+	data.source_file = source_file;
+	data.tags_array = g_ptr_array_new();
+
+	if (source_file->lang != TM_PARSER_NONE && text_buf != NULL && buf_size != 0)
+	{
+		data.arena = tm_tag_arena_new();
+		tm_ctags_parse(text_buf, buf_size, NULL, 0, source_file->file_name,
+			source_file->lang, ctags_new_tag, ctags_pass_start, &data);
+		tm_tag_arena_unref(data.arena);
+	}
+
+	return data.tags_array;
+}
+
 /* Gets the name associated with the language index.
  @param lang The language index.
  @return The language name, or NULL.
@@ -51,12 +51,21 @@ const gchar *tm_source_file_get_lang_name(TMParserType lang);
 TMParserType tm_source_file_get_named_lang(const gchar *name);
 
 gboolean tm_source_file_parse(TMSourceFile *source_file, guchar* text_buf, gsize buf_size,
-	gboolean use_buffer);
+	guchar *text_buf2, gsize buf2_size, gboolean use_buffer);
+
+GPtrArray *tm_source_file_parse_to_array(TMSourceFile *source_file, guchar* text_buf,
+	gsize buf_size);
+
+TMSourceFile *tm_source_file_dup(TMSourceFile *source_file);
 
 GPtrArray *tm_source_file_read_tags_file(const gchar *tags_file, TMParserType mode);
 
 gboolean tm_source_file_write_tags_file(const gchar *tags_file, GPtrArray *tags_array);
 
+GPtrArray *tm_source_file_read_binary_tags_file(const gchar *tags_file, TMParserType mode);
+
+gboolean tm_source_file_write_binary_tags_file(const gchar *tags_file, GPtrArray *tags_array);
+
 #endif /* GEANY_PRIVATE */
 
 G_END_DECLS
@@ -15,8 +15,160 @@
 #include "tm_ctags_wrappers.h"
 
 
-#define TAG_NEW(T)	((T) = g_slice_new0(TMTag))
-#define TAG_FREE(T)	g_slice_free(TMTag, (T))
+/* Number of tags allocated at once by an arena */
+#define ARENA_BLOCK_SIZE 256
+
+/* The tags created by a single parse (or read from a single tags file) together
+ * with their strings. The memory is released at once when the last tag allocated
+ * from the arena is unreferenced. */
+struct TMTagArena
+{
+	gint refcount;		/* one for every alive tag, one for the creator */
+	GSList *blocks;		/* arrays of ARENA_BLOCK_SIZE tags */
+	guint block_used;	/* number of tags used in the first block */
+	GHashTable *strings;	/* interned strings referenced by the arena */
+	GMappedFile *mapped_file;	/* file the strings of the tags point into, or NULL */
+};
+
+/* Strings shared by the tags of all arenas; maps a string to the number of arenas
+ * referencing it. Parsing happens in several threads so all access is locked. */
+static GHashTable *interned_strings = NULL;
+static GMutex interned_strings_mutex;
+
+
+/*
+ Creates a new arena for allocating tags with tm_tag_new().
+ @return the new arena. Drop the reference with tm_tag_arena_unref() when no more
+ tags are allocated from it; the arena is freed once all its tags are freed.
+*/
+TMTagArena *tm_tag_arena_new(void)
+{
+	TMTagArena *arena = g_new0(TMTagArena, 1);
+
+	arena->refcount = 1;
+	arena->block_used = ARENA_BLOCK_SIZE;
+	arena->strings = g_hash_table_new(g_str_hash, g_str_equal);
+	return arena;
+}
+
+
+static void release_interned_strings(GHashTable *strings)
+{
+	GHashTableIter iter;
+	gpointer key;
+
+	g_mutex_lock(&interned_strings_mutex);
+	g_hash_table_iter_init(&iter, strings);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		guint count = GPOINTER_TO_UINT(g_hash_table_lookup(interned_strings, key));
+
+		if (count > 1)
+			g_hash_table_insert(interned_strings, key, GUINT_TO_POINTER(count - 1));
+		else
+		{
+			g_hash_table_remove(interned_strings, key);
+			g_free(key);
+		}
+	}
+	g_mutex_unlock(&interned_strings_mutex);
+}
+
+
+/*
+ Drops a reference from an arena. The memory of the arena is freed when the
+ references of the creator and of all the tags allocated from it are dropped.
+ @param arena The arena
+*/
+void tm_tag_arena_unref(TMTagArena *arena)
+{
+	if (NULL != arena && g_atomic_int_dec_and_test(&arena->refcount))
+	{
+		release_interned_strings(arena->strings);
+		g_hash_table_destroy(arena->strings);
+		g_slist_free_full(arena->blocks, g_free);
+		if (arena->mapped_file)
+			g_mapped_file_unref(arena->mapped_file);
+		g_free(arena);
+	}
+}
+
+
+/*
+ Makes the arena keep the file mapped as long as its tags exist so their strings
+ can point into the file instead of being copied.
+ @param arena The arena
+ @param mapped_file The mapped file, a reference is added
+*/
+void tm_tag_arena_set_mapped_file(TMTagArena *arena, GMappedFile *mapped_file)
+{
+	g_return_if_fail(arena->mapped_file == NULL);
+
+	arena->mapped_file = g_mapped_file_ref(mapped_file);
+}
+
+
+/*
+ Returns the shared copy of str and makes the arena of tag reference it. Use it for
+ the string members of the tag; the returned string must not be modified or freed.
+ @param tag The tag the string belongs to
+ @param str The string to intern, or NULL
+ @return the interned string or NULL if str is NULL
+*/
+gchar *tm_tag_intern_string(TMTag *tag, const gchar *str)
+{
+	TMTagArena *arena = tag->arena;
+	gpointer interned;
+
+	if (NULL == str)
+		return NULL;
+
+	/* the arena is used by a single thread, avoid the global lock for strings
+	 * it already references */
+	interned = g_hash_table_lookup(arena->strings, str);
+	if (interned)
+		return interned;
+
+	g_mutex_lock(&interned_strings_mutex);
+	if (G_UNLIKELY(NULL == interned_strings))
+		interned_strings = g_hash_table_new(g_str_hash, g_str_equal);
+	if (g_hash_table_lookup_extended(interned_strings, str, &interned, NULL))
+	{
+		guint count = GPOINTER_TO_UINT(g_hash_table_lookup(interned_strings, interned));
+
+		g_hash_table_insert(interned_strings, interned, GUINT_TO_POINTER(count + 1));
+	}
+	else
+	{
+		interned = g_strdup(str);
+		g_hash_table_insert(interned_strings, interned, GUINT_TO_POINTER(1));
+	}
+	g_mutex_unlock(&interned_strings_mutex);
+
+	g_hash_table_insert(arena->strings, interned, interned);
+	return interned;
+}
+
+
+static TMTag *arena_alloc_tag(TMTagArena *arena)
+{
+	TMTag *tag;
+
+	if (arena->block_used == ARENA_BLOCK_SIZE)
+	{
+		arena->blocks = g_slist_prepend(arena->blocks, g_new0(TMTag, ARENA_BLOCK_SIZE));
+		arena->block_used = 0;
+	}
+	tag = (TMTag *) arena->blocks->data + arena->block_used++;
+	tag->arena = arena;
+	g_atomic_int_inc(&arena->refcount);
+
+	return tag;
+}
+
+
+#define TAG_NEW(T, A)	((T) = arena_alloc_tag(A))
+#define TAG_FREE(T)	tm_tag_arena_unref((T)->arena)
 
 
 #ifdef DEBUG_TAG_REFS
@@ -40,7 +192,7 @@ static void log_refs_at_exit(void)
 	g_debug("TMTag references left at exit: %lu", ref_count);
 }
 
-static TMTag *log_tag_new(void)
+static TMTag *log_tag_new(TMTagArena *arena)
 {
 	TMTag *tag;
 
@@ -49,7 +201,7 @@ static TMTag *log_tag_new(void)
 		alive_tags = g_hash_table_new(g_direct_hash, g_direct_equal);
 		atexit(log_refs_at_exit);
 	}
-	TAG_NEW(tag);
+	TAG_NEW(tag, arena);
 	g_hash_table_insert(alive_tags, tag, tag);
 
 	return tag;
@@ -68,7 +220,7 @@ static void log_tag_free(TMTag *tag)
 
 #undef TAG_NEW
 #undef TAG_FREE
-#define TAG_NEW(T)	((T) = log_tag_new())
+#define TAG_NEW(T, A)	((T) = log_tag_new(A))
 #define TAG_FREE(T)	log_tag_free(T)
 
 #endif /* DEBUG_TAG_REFS */
@@ -96,36 +248,24 @@ GType tm_tag_get_type(void)
 
 /*
  Creates a new tag structure and returns a pointer to it.
- @return the new TMTag structure. This should be free()-ed using tm_tag_free()
+ @param arena The arena the tag and its strings are allocated from
+ @return the new TMTag structure. Drop the reference with tm_tag_unref()
 */
-TMTag *tm_tag_new(void)
+TMTag *tm_tag_new(TMTagArena *arena)
 {
 	TMTag *tag;
 
-	TAG_NEW(tag);
+	TAG_NEW(tag, arena);
 	tag->refcount = 1;
 
 	return tag;
 }
 
-/*
- Destroys a TMTag structure, i.e. frees all elements except the tag itself.
- @param tag The TMTag structure to destroy
- @see tm_tag_free()
-*/
-static void tm_tag_destroy(TMTag *tag)
-{
-	g_free(tag->name);
-	g_free(tag->arglist);
-	g_free(tag->scope);
-	g_free(tag->inheritance);
-	g_free(tag->var_type);
-}
-
 
 /*
- Drops a reference from a TMTag. If the reference count reaches 0, this function
- destroys all data in the tag and frees the tag structure as well.
+ Drops a reference from a TMTag. If the reference count reaches 0, the tag is
+ released to its arena which frees the memory of all its tags and strings once
+ none of them is used.
  @param tag Pointer to a TMTag structure
 */
 void tm_tag_unref(TMTag *tag)
@@ -133,10 +273,7 @@ void tm_tag_unref(TMTag *tag)
 	/* be NULL-proof because tm_tag_free() was NULL-proof and we indent to be a
 	 * drop-in replacment of it */
 	if (NULL != tag && g_atomic_int_dec_and_test(&tag->refcount))
-	{
-		tm_tag_destroy(tag);
 		TAG_FREE(tag);
-	}
 }
 
 /*
@@ -150,6 +287,15 @@ TMTag *tm_tag_ref(TMTag *tag)
 	return tag;
 }
 
+/* Equal interned strings are identical so most equality checks don't need to
+ * look at the strings */
+static gint compare_strings(const gchar *a, const gchar *b)
+{
+	if (a == b)
+		return 0;
+	return strcmp(FALLBACK(a, ""), FALLBACK(b, ""));
+}
+
 /*
  Inbuilt tag comparison function.
 */
@@ -171,7 +317,7 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 		if (sort_options->partial)
 			return strncmp(FALLBACK(t1->name, ""), FALLBACK(t2->name, ""), strlen(FALLBACK(t1->name, "")));
 		else
-			return strcmp(FALLBACK(t1->name, ""), FALLBACK(t2->name, ""));
+			return compare_strings(t1->name, t2->name);
 	}
 
 	for (sort_attr = sort_options->sort_attrs; returnval == 0 && *sort_attr != tm_tag_attr_none_t; ++ sort_attr)
@@ -182,7 +328,7 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 				if (sort_options->partial)
 					returnval = strncmp(FALLBACK(t1->name, ""), FALLBACK(t2->name, ""), strlen(FALLBACK(t1->name, "")));
 				else
-					returnval = strcmp(FALLBACK(t1->name, ""), FALLBACK(t2->name, ""));
+					returnval = compare_strings(t1->name, t2->name);
 				break;
 			case tm_tag_attr_file_t:
 				returnval = t1->file - t2->file;
@@ -194,10 +340,10 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 				returnval = t1->type - t2->type;
 				break;
 			case tm_tag_attr_scope_t:
-				returnval = strcmp(FALLBACK(t1->scope, ""), FALLBACK(t2->scope, ""));
+				returnval = compare_strings(t1->scope, t2->scope);
 				break;
 			case tm_tag_attr_arglist_t:
-				returnval = strcmp(FALLBACK(t1->arglist, ""), FALLBACK(t2->arglist, ""));
+				returnval = compare_strings(t1->arglist, t2->arglist);
 				if (returnval != 0)
 				{
 					int line_diff = (t1->line - t2->line);
@@ -206,7 +352,7 @@ static gint tm_tag_compare(gconstpointer ptr1, gconstpointer ptr2, gpointer user
 				}
 				break;
 			case tm_tag_attr_vartype_t:
-				returnval = strcmp(FALLBACK(t1->var_type, ""), FALLBACK(t2->var_type, ""));
+				returnval = compare_strings(t1->var_type, t2->var_type);
 				break;
 		}
 	}
@@ -220,17 +366,17 @@ gboolean tm_tags_equal(const TMTag *a, const TMTag *b)
 
 	return (a->line == b->line &&
 			a->file == b->file /* ptr comparison */ &&
-			strcmp(FALLBACK(a->name, ""), FALLBACK(b->name, "")) == 0 &&
+			compare_strings(a->name, b->name) == 0 &&
 			a->type == b->type &&
 			a->local == b->local &&
 			a->pointerOrder == b->pointerOrder &&
 			a->access == b->access &&
 			a->impl == b->impl &&
 			a->lang == b->lang &&
-			strcmp(FALLBACK(a->scope, ""), FALLBACK(b->scope, "")) == 0 &&
-			strcmp(FALLBACK(a->arglist, ""), FALLBACK(b->arglist, "")) == 0 &&
-			strcmp(FALLBACK(a->inheritance, ""), FALLBACK(b->inheritance, "")) == 0 &&
-			strcmp(FALLBACK(a->var_type, ""), FALLBACK(b->var_type, "")) == 0);
+			compare_strings(a->scope, b->scope) == 0 &&
+			compare_strings(a->arglist, b->arglist) == 0 &&
+			compare_strings(a->inheritance, b->inheritance) == 0 &&
+			compare_strings(a->var_type, b->var_type) == 0);
 }
 
 /*
@@ -486,6 +632,203 @@ GPtrArray *tm_tags_merge(GPtrArray *big_array, GPtrArray *small_array,
 	return res_array;
 }
 
+/* Restores the heap property of the k-way merge heap below index i. The heap
+ * contains indices of the arrays and is ordered by the tags at their positions. */
+static void merge_heap_sift_down(guint *heap, guint heap_len, guint i,
+	GPtrArray **arrays, guint *positions, TMSortOptions *sort_options)
+{
+	while (TRUE)
+	{
+		guint left = 2 * i + 1;
+		guint right = left + 1;
+		guint smallest = i;
+		guint tmp;
+
+		if (left < heap_len &&
+			tm_tag_compare(&arrays[heap[left]]->pdata[positions[heap[left]]],
+				&arrays[heap[smallest]]->pdata[positions[heap[smallest]]], sort_options) < 0)
+			smallest = left;
+		if (right < heap_len &&
+			tm_tag_compare(&arrays[heap[right]]->pdata[positions[heap[right]]],
+				&arrays[heap[smallest]]->pdata[positions[heap[smallest]]], sort_options) < 0)
+			smallest = right;
+		if (smallest == i)
+			break;
+
+		tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+/*
+ Merges several arrays sorted on the given attributes into a new sorted array
+ in a single pass. Tags comparing equal are added to the result only once. The
+ tags aren't referenced, free the result with g_ptr_array_free().
+ @param arrays The sorted tag arrays to merge
+ @param count The number of arrays
+ @param sort_attributes Attributes the arrays are sorted on
+ @return The merged array
+*/
+GPtrArray *tm_tags_merge_sorted(GPtrArray **arrays, guint count,
+	TMTagAttrType *sort_attributes)
+{
+	TMSortOptions sort_options;
+	GPtrArray *res_array;
+	guint *heap = g_new(guint, count);
+	guint *positions = g_new0(guint, count);
+	guint heap_len = 0;
+	guint total = 0;
+	guint i;
+
+	sort_options.sort_attrs = sort_attributes;
+	sort_options.partial = FALSE;
+
+	for (i = 0; i < count; i++)
+	{
+		total += arrays[i]->len;
+		if (arrays[i]->len > 0)
+			heap[heap_len++] = i;
+	}
+	res_array = g_ptr_array_sized_new(total);
+
+	for (i = heap_len / 2; i > 0; i--)
+		merge_heap_sift_down(heap, heap_len, i - 1, arrays, positions, &sort_options);
+
+	while (heap_len > 0)
+	{
+		guint top = heap[0];
+		gpointer tag = arrays[top]->pdata[positions[top]];
+
+		if (res_array->len == 0 ||
+			tm_tag_compare(&res_array->pdata[res_array->len - 1], &tag, &sort_options) != 0)
+			g_ptr_array_add(res_array, tag);
+
+		positions[top]++;
+		if (positions[top] == arrays[top]->len)
+			heap[0] = heap[--heap_len];
+		merge_heap_sift_down(heap, heap_len, 0, arrays, positions, &sort_options);
+	}
+
+	g_free(positions);
+	g_free(heap);
+	return res_array;
+}
+
+/* Returns the index of the first tag in tags_array not sorting before tag */
+static guint tags_lower_bound(GPtrArray *tags_array, TMTag *tag, TMSortOptions *sort_options)
+{
+	guint lower = 0;
+	guint upper = tags_array->len;
+
+	while (lower < upper)
+	{
+		guint middle = lower + (upper - lower) / 2;
+
+		if (tm_tag_compare(&tags_array->pdata[middle], &tag, sort_options) < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return lower;
+}
+
+static gint compare_indices(gconstpointer a, gconstpointer b)
+{
+	guint i1 = *(const guint *) a;
+	guint i2 = *(const guint *) b;
+
+	return i1 < i2 ? -1 : (i1 > i2 ? 1 : 0);
+}
+
+/* Appends the tags of src from start up to end (excluded) to dst */
+static void append_tags(GPtrArray *dst, GPtrArray *src, guint start, guint end)
+{
+	guint len = dst->len;
+
+	if (end <= start)
+		return;
+	g_ptr_array_set_size(dst, len + end - start);
+	memcpy(dst->pdata + len, src->pdata + start, (end - start) * sizeof(gpointer));
+}
+
+/*
+ Replaces the old tags of a file in an array sorted on the given attributes by
+ its new tags. The positions of the old and new tags are found by binary search
+ and the rest of the array is copied in a single pass, so only
+ O((old_tags->len + new_tags->len) * log(tags_array->len)) tags are compared.
+ The old tags must still exist. The tags aren't referenced, free the result
+ with g_ptr_array_free().
+ @param tags_array The sorted array containing old_tags
+ @param old_tags The tags to remove, all of them from the same file
+ @param new_tags The sorted tags to add, all of them from the same file
+ @param sort_attributes Attributes the arrays are sorted on, including the file
+ @return The new sorted array
+*/
+GPtrArray *tm_tags_replace_file_tags(GPtrArray *tags_array, GPtrArray *old_tags,
+	GPtrArray *new_tags, TMTagAttrType *sort_attributes)
+{
+	TMSortOptions sort_options;
+	GPtrArray *res_array;
+	guint *removed = g_new(guint, old_tags->len);
+	guint *inserted = g_new(guint, new_tags->len);
+	guint removed_num = 0;
+	guint start = 0;
+	guint i, j = 0;
+
+	sort_options.sort_attrs = sort_attributes;
+	sort_options.partial = FALSE;
+
+	for (i = 0; i < old_tags->len; i++)
+	{
+		TMTag *tag = old_tags->pdata[i];
+		guint k;
+
+		/* there may be several equal tags, find the identical one */
+		for (k = tags_lower_bound(tags_array, tag, &sort_options); k < tags_array->len; k++)
+		{
+			if (tags_array->pdata[k] == tag)
+			{
+				removed[removed_num++] = k;
+				break;
+			}
+			if (tm_tag_compare(&tags_array->pdata[k], &tag, &sort_options) != 0)
+				break;
+		}
+	}
+	qsort(removed, removed_num, sizeof(guint), compare_indices);
+
+	for (i = 0; i < new_tags->len; i++)
+		inserted[i] = tags_lower_bound(tags_array, new_tags->pdata[i], &sort_options);
+
+	res_array = g_ptr_array_sized_new(tags_array->len - removed_num + new_tags->len);
+	for (i = 0; i <= new_tags->len; i++)
+	{
+		guint end = i < new_tags->len ? inserted[i] : tags_array->len;
+
+		/* copy the tags before the new tag, leaving out the removed ones */
+		while (start < end)
+		{
+			guint next = (j < removed_num && removed[j] < end) ? removed[j] : end;
+
+			append_tags(res_array, tags_array, start, next);
+			start = next;
+			if (j < removed_num && removed[j] == start)
+			{
+				start++;
+				j++;
+			}
+		}
+		if (i < new_tags->len)
+			g_ptr_array_add(res_array, new_tags->pdata[i]);
+	}
+
+	g_free(inserted);
+	g_free(removed);
+	return res_array;
+}
+
 /*
  This function will extract the tags of the specified types from an array of tags.
  The returned value is a GPtrArray which should be free-d with a call to
@@ -82,6 +82,7 @@ typedef enum
 
 /**
  * The TMTag structure represents a single tag in the tag manager.
+ * The strings of the tag are shared with other tags and must not be modified.
  **/
 typedef struct TMTag
 {
@@ -101,6 +102,7 @@ typedef struct TMTag
 	char access; /**< Access type (public/protected/private/etc.) */
 	char impl; /**< Implementation (e.g. virtual) */
 	TMParserType lang; /* Programming language of the file */
+	struct TMTagArena *arena; /* the arena the tag and its strings are allocated from */
 } TMTag;
 
 
@@ -111,13 +113,29 @@ typedef struct TMTag
 
 GType tm_tag_get_type(void) G_GNUC_CONST;
 
-TMTag *tm_tag_new(void);
+typedef struct TMTagArena TMTagArena;
+
+TMTagArena *tm_tag_arena_new(void);
+
+void tm_tag_arena_unref(TMTagArena *arena);
+
+void tm_tag_arena_set_mapped_file(TMTagArena *arena, GMappedFile *mapped_file);
+
+TMTag *tm_tag_new(TMTagArena *arena);
+
+gchar *tm_tag_intern_string(TMTag *tag, const gchar *str);
 
 void tm_tags_remove_file_tags(TMSourceFile *source_file, GPtrArray *tags_array);
 
 GPtrArray *tm_tags_merge(GPtrArray *big_array, GPtrArray *small_array, 
 	TMTagAttrType *sort_attributes, gboolean unref_duplicates);
 
+GPtrArray *tm_tags_merge_sorted(GPtrArray **arrays, guint count,
+	TMTagAttrType *sort_attributes);
+
+GPtrArray *tm_tags_replace_file_tags(GPtrArray *tags_array, GPtrArray *old_tags,
+	GPtrArray *new_tags, TMTagAttrType *sort_attributes);
+
 void tm_tags_sort(GPtrArray *tags_array, TMTagAttrType *sort_attributes,
 	gboolean dedup, gboolean unref_duplicates);
 
@@ -34,6 +34,7 @@
 #include "tm_ctags_wrappers.h"
 #include "tm_tag.h"
 #include "tm_parser.h"
+#include "tm_name_index.h"
 
 
 /* when changing, always keep the three sort criteria below in sync */
@@ -68,6 +69,84 @@ static TMTagType TM_GLOBAL_TYPE_MASK =
 static TMWorkspace *theWorkspace = NULL;
 
 
+/* A snapshot of a source file's buffer waiting to be parsed (or being parsed)
+ * by the background parser */
+typedef struct
+{
+	TMSourceFile *source_file;	/* reference held until the job is finished */
+	guchar *text_buf;			/* private copy of the buffer */
+	gsize buf_size;
+	GPtrArray *tags_array;		/* sorted result of the parse, NULL until parsed */
+	gint cancelled;				/* set when a newer update of the file arrives */
+	TMWorkspaceUpdateCallback callback;
+	gpointer user_data;
+} ParseJob;
+
+/* Worker threads running the background parses */
+static GThreadPool *parse_pool = NULL;
+/* Jobs the workers are done with, handed to parse_job_finished() in the main thread */
+static GAsyncQueue *finished_parse_jobs = NULL;
+/* Maps TMSourceFile to its most recent ParseJob; only accessed from the main thread */
+static GHashTable *pending_parse_jobs = NULL;
+
+static void parse_job_free(ParseJob *job);
+
+/* Upper bound of the threads parsing in tm_workspace_add_source_files_full() */
+#define MAX_BULK_PARSE_THREADS 8
+
+/* State shared by the threads of a bulk parse */
+typedef struct
+{
+	GPtrArray *source_files;
+	gint next_file;				/* index of the next file to parse, accessed atomically */
+	GAsyncQueue *parsed_queue;	/* files whose parsing is finished */
+} BulkParse;
+
+typedef struct
+{
+	BulkParse *bulk;
+	GThread *thread;
+	GPtrArray *tags_array;		/* tags of the files parsed by this thread */
+} BulkParseWorker;
+
+/* Unique names of the current tags of all source files and the global tags, used
+ * for autocompletion; updated together with the tags of the source files */
+static TMNameIndex *name_index = NULL;
+
+/* The names of the typename tags of the source files of a language, highlighted
+ * as keywords by the editor */
+typedef struct
+{
+	GHashTable *names;	/* maps an allocated name to the number of tags with it */
+	guint generation;	/* value of typenames_generation when the names last changed */
+} TypenameSet;
+
+/* Maps TMParserType to its TypenameSet */
+static GHashTable *typename_sets = NULL;
+/* Incremented whenever a name is added to or removed from a TypenameSet */
+static guint typenames_generation = 0;
+
+
+static void free_typename_names(TypenameSet *set)
+{
+	GHashTableIter iter;
+	gpointer key;
+
+	g_hash_table_iter_init(&iter, set->names);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		g_free(key);
+	g_hash_table_remove_all(set->names);
+}
+
+
+static void free_typename_set(TypenameSet *set)
+{
+	free_typename_names(set);
+	g_hash_table_destroy(set->names);
+	g_slice_free(TypenameSet, set);
+}
+
+
 static gboolean tm_create_workspace(void)
 {
 	theWorkspace = g_new(TMWorkspace, 1);
@@ -78,6 +157,11 @@ static gboolean tm_create_workspace(void)
 	theWorkspace->typename_array = g_ptr_array_new();
 	theWorkspace->global_typename_array = g_ptr_array_new();
 
+	pending_parse_jobs = g_hash_table_new(g_direct_hash, g_direct_equal);
+	name_index = tm_name_index_new();
+	typename_sets = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+		(GDestroyNotify) free_typename_set);
+
 	tm_ctags_init();
 	tm_parser_verify_type_mappings();
 
@@ -91,11 +175,35 @@ static gboolean tm_create_workspace(void)
 void tm_workspace_free(void)
 {
 	guint i;
+	ParseJob *job;
+	GHashTableIter iter;
 
 #ifdef TM_DEBUG
 	g_message("Workspace destroyed");
 #endif
 
+	if (parse_pool)
+	{
+		/* let the queued jobs finish without parsing, then free all finished jobs as
+		 * the main loop doesn't run parse_job_finished() any more */
+		g_hash_table_iter_init(&iter, pending_parse_jobs);
+		while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &job))
+			g_atomic_int_set(&job->cancelled, TRUE);
+		g_thread_pool_free(parse_pool, FALSE, TRUE);
+		parse_pool = NULL;
+
+		while ((job = g_async_queue_try_pop(finished_parse_jobs)) != NULL)
+			parse_job_free(job);
+		g_async_queue_unref(finished_parse_jobs);
+		finished_parse_jobs = NULL;
+	}
+	g_hash_table_destroy(pending_parse_jobs);
+	pending_parse_jobs = NULL;
+	tm_name_index_free(name_index);
+	name_index = NULL;
+	g_hash_table_destroy(typename_sets);
+	typename_sets = NULL;
+
 	for (i=0; i < theWorkspace->source_files->len; ++i)
 		tm_source_file_free(theWorkspace->source_files->pdata[i]);
 	g_ptr_array_free(theWorkspace->source_files, TRUE);
@@ -141,30 +249,139 @@ static void merge_extracted_tags(GPtrArray **dest, GPtrArray *src, TMTagType tag
 }
 
 
+/* Replaces the old tags of a file in the workspace tags_array by its new tags;
+ * the old tags must still exist */
+static void replace_file_tags(GPtrArray *old_tags, GPtrArray *new_tags)
+{
+	GPtrArray *tags = tm_tags_replace_file_tags(theWorkspace->tags_array, old_tags,
+		new_tags, workspace_tags_sort_attrs);
+
+	/* tags owned by TMSourceFile - free just the pointer array */
+	g_ptr_array_free(theWorkspace->tags_array, TRUE);
+	theWorkspace->tags_array = tags;
+}
+
+
+/* Adds delta to the number of typename tags with the name of tag */
+static void count_typename(const TMTag *tag, gint delta)
+{
+	TypenameSet *set;
+	gpointer key, value;
+	gint count = 0;
+
+	if (!(tag->type & TM_GLOBAL_TYPE_MASK) || !tag->name)
+		return;
+
+	set = g_hash_table_lookup(typename_sets, GINT_TO_POINTER(tag->lang));
+	if (!set)
+	{
+		set = g_slice_new(TypenameSet);
+		set->names = g_hash_table_new(g_str_hash, g_str_equal);
+		set->generation = 0;
+		g_hash_table_insert(typename_sets, GINT_TO_POINTER(tag->lang), set);
+	}
+
+	if (g_hash_table_lookup_extended(set->names, tag->name, &key, &value))
+		count = GPOINTER_TO_INT(value);
+	else
+		key = NULL;
+	count += delta;
+
+	if (count > 0)
+	{
+		if (!key)
+		{
+			key = g_strdup(tag->name);
+			set->generation = ++typenames_generation;
+		}
+		/* the stored key is kept as the table has no key destroy function */
+		g_hash_table_insert(set->names, key, GINT_TO_POINTER(count));
+	}
+	else if (key)
+	{
+		g_hash_table_remove(set->names, key);
+		g_free(key);
+		set->generation = ++typenames_generation;
+	}
+}
+
+
+/* Updates the typename sets when the tags of a source file change from old_tags
+ * to new_tags (either may be NULL). The new tags are counted first so the names
+ * present in both don't disappear for a moment and a reparse which doesn't change
+ * any typename doesn't change the generation. */
+static void update_typenames(const GPtrArray *old_tags, const GPtrArray *new_tags)
+{
+	guint i;
+
+	for (i = 0; new_tags && i < new_tags->len; i++)
+		count_typename(new_tags->pdata[i], 1);
+	for (i = 0; old_tags && i < old_tags->len; i++)
+		count_typename(old_tags->pdata[i], -1);
+}
+
+
+/* Marks the background parse of source_file (if any) as obsolete so its result
+ * is thrown away; the job itself is freed once the worker is done with it. */
+static void cancel_pending_parse(TMSourceFile *source_file)
+{
+	ParseJob *job;
+
+	if (!pending_parse_jobs)
+		return;
+
+	job = g_hash_table_lookup(pending_parse_jobs, source_file);
+	if (job)
+	{
+		g_atomic_int_set(&job->cancelled, TRUE);
+		g_hash_table_remove(pending_parse_jobs, source_file);
+	}
+}
+
+
 static void update_source_file(TMSourceFile *source_file, guchar* text_buf,
-	gsize buf_size, gboolean use_buffer, gboolean update_workspace)
+	gsize buf_size, guchar *text_buf2, gsize buf2_size, gboolean use_buffer,
+	gboolean update_workspace)
 {
+	GPtrArray *old_tags = NULL;
+	GPtrArray *old_typenames = NULL;
+	guint i;
+
 #ifdef TM_DEBUG
 	g_message("Source file updating based on source file %s", source_file->file_name);
 #endif
 
+	/* the tags parsed now are newer than whatever the background parser produces */
+	cancel_pending_parse(source_file);
+
 	if (update_workspace)
 	{
-		/* tm_source_file_parse() deletes the tag objects - remove the tags from
-		 * workspace while they exist and can be scanned */
-		tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
+		/* tm_source_file_parse() deletes the tag objects - keep them alive until
+		 * they are replaced in the workspace and remove them from the other arrays
+		 * while they exist and can be scanned */
+		old_tags = g_ptr_array_sized_new(source_file->tags_array->len);
+		for (i = 0; i < source_file->tags_array->len; i++)
+			g_ptr_array_add(old_tags, tm_tag_ref(source_file->tags_array->pdata[i]));
 		tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+		tm_name_index_remove_tags(name_index, source_file->tags_array);
+		/* keep the old typenames alive until they are compared with the new ones */
+		old_typenames = tm_tags_extract(source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+		for (i = 0; i < old_typenames->len; i++)
+			tm_tag_ref(old_typenames->pdata[i]);
 	}
-	tm_source_file_parse(source_file, text_buf, buf_size, use_buffer);
+	tm_source_file_parse(source_file, text_buf, buf_size, text_buf2, buf2_size, use_buffer);
 	tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, FALSE, TRUE);
 	if (update_workspace)
 	{
 #ifdef TM_DEBUG
 		g_message("Updating workspace from source file");
 #endif
-		tm_workspace_merge_tags(&theWorkspace->tags_array, source_file->tags_array);
-
+		replace_file_tags(old_tags, source_file->tags_array);
+		tm_tags_array_free(old_tags, TRUE);
+		tm_name_index_add_tags(name_index, source_file->tags_array);
 		merge_extracted_tags(&(theWorkspace->typename_array), source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+		update_typenames(old_typenames, source_file->tags_array);
+		tm_tags_array_free(old_typenames, TRUE);
 	}
 #ifdef TM_DEBUG
 	else
@@ -175,6 +392,79 @@ static void update_source_file(TMSourceFile *source_file, guchar* text_buf,
 }
 
 
+static void parse_job_free(ParseJob *job)
+{
+	g_free(job->text_buf);
+	tm_tags_array_free(job->tags_array, TRUE);
+	tm_source_file_free(job->source_file);
+	g_slice_free(ParseJob, job);
+}
+
+
+/* Runs in the main thread once the worker is done with the job - publishes the
+ * new tags unless a newer update (or removal) of the file happened meanwhile */
+static gboolean parse_job_finished(gpointer data)
+{
+	ParseJob *job;
+	TMSourceFile *source_file;
+
+	if (!finished_parse_jobs)
+		return FALSE;
+	job = g_async_queue_try_pop(finished_parse_jobs);
+	if (!job)
+		return FALSE;
+	source_file = job->source_file;
+
+	if (!theWorkspace || g_atomic_int_get(&job->cancelled) ||
+		g_hash_table_lookup(pending_parse_jobs, source_file) != job)
+	{
+		parse_job_free(job);
+		return FALSE;
+	}
+	g_hash_table_remove(pending_parse_jobs, source_file);
+
+	/* the old tags must still exist when they are removed from the workspace */
+	replace_file_tags(source_file->tags_array, job->tags_array);
+	tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+	tm_name_index_remove_tags(name_index, source_file->tags_array);
+	update_typenames(source_file->tags_array, job->tags_array);
+
+	tm_tags_array_free(source_file->tags_array, TRUE);
+	source_file->tags_array = job->tags_array;
+	job->tags_array = NULL;
+
+	tm_name_index_add_tags(name_index, source_file->tags_array);
+
+	merge_extracted_tags(&(theWorkspace->typename_array), source_file->tags_array, TM_GLOBAL_TYPE_MASK);
+
+	if (job->callback)
+		job->callback(source_file, job->user_data);
+
+	parse_job_free(job);
+	return FALSE;
+}
+
+
+/* Worker thread function - parses the snapshot into a private tag array */
+static void parse_job_run(gpointer data, gpointer user_data)
+{
+	ParseJob *job = data;
+
+	if (!g_atomic_int_get(&job->cancelled))
+	{
+		job->tags_array = tm_source_file_parse_to_array(job->source_file,
+			job->text_buf, job->buf_size);
+		tm_tags_sort(job->tags_array, file_tags_sort_attrs, FALSE, TRUE);
+	}
+	/* the snapshot isn't needed any more, don't keep it until the main loop runs */
+	g_free(job->text_buf);
+	job->text_buf = NULL;
+
+	g_async_queue_push(finished_parse_jobs, job);
+	g_idle_add(parse_job_finished, NULL);
+}
+
+
 /** Adds a source file to the workspace, parses it and updates the workspace tags.
  @param source_file The source file to add to the workspace.
 */
@@ -184,7 +474,7 @@ void tm_workspace_add_source_file(TMSourceFile *source_file)
 	g_return_if_fail(source_file != NULL);
 
 	g_ptr_array_add(theWorkspace->source_files, source_file);
-	update_source_file(source_file, NULL, 0, FALSE, TRUE);
+	update_source_file(source_file, NULL, 0, NULL, 0, FALSE, TRUE);
 }
 
 
@@ -207,11 +497,69 @@ void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file)
  @param text_buf A text buffer. The user should take care of allocate and free it after
  the use here.
  @param buf_size The size of text_buf.
+ @param text_buf2 The text following text_buf, or NULL. Pass the two parts of a gap
+ buffer as text_buf and text_buf2 to parse them without joining them first.
+ @param buf2_size The size of text_buf2.
 */
 void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
-	gsize buf_size)
+	gsize buf_size, guchar *text_buf2, gsize buf2_size)
 {
-	update_source_file(source_file, text_buf, buf_size, TRUE, TRUE);
+	update_source_file(source_file, text_buf, buf_size, text_buf2, buf2_size, TRUE, TRUE);
+}
+
+
+/* Like tm_workspace_update_source_file_buffer() but the parsing happens in a
+ background thread so the caller isn't blocked. The buffer is copied so it can be
+ modified or freed as soon as this function returns. When the parse is finished,
+ the tags of the source file and the workspace are replaced in the main loop and
+ callback is invoked. If the file is updated again (either in the background or
+ directly) or removed from the workspace before the parse is finished, the
+ outdated result is dropped and callback isn't invoked.
+ @param source_file The source file to update with a buffer.
+ @param text_buf A text buffer; it is copied.
+ @param buf_size The size of text_buf.
+ @param text_buf2 The text following text_buf, or NULL; the snapshot joins both.
+ @param buf2_size The size of text_buf2.
+ @param callback Function to call when the new tags are in place, or NULL.
+ @param user_data User data passed to callback.
+*/
+void tm_workspace_update_source_file_buffer_async(TMSourceFile *source_file, guchar* text_buf,
+	gsize buf_size, guchar *text_buf2, gsize buf2_size,
+	TMWorkspaceUpdateCallback callback, gpointer user_data)
+{
+	ParseJob *job;
+
+	g_return_if_fail(source_file != NULL);
+
+	if (!parse_pool)
+	{
+		/* parses of different files may overlap if the ctags core is re-entrant;
+		 * updates of the same file are ordered by pending_parse_jobs */
+		parse_pool = g_thread_pool_new(parse_job_run, NULL,
+			tm_ctags_is_reentrant() ? 2 : 1, FALSE, NULL);
+		finished_parse_jobs = g_async_queue_new();
+	}
+
+	cancel_pending_parse(source_file);
+
+	job = g_slice_new0(ParseJob);
+	job->source_file = tm_source_file_dup(source_file);
+	if (!text_buf2)
+		buf2_size = 0;
+	job->buf_size = buf_size + buf2_size;
+	if (job->buf_size > 0)
+	{
+		job->text_buf = g_malloc(job->buf_size);
+		if (buf_size > 0)
+			memcpy(job->text_buf, text_buf, buf_size);
+		if (buf2_size > 0)
+			memcpy(job->text_buf + buf_size, text_buf2, buf2_size);
+	}
+	job->callback = callback;
+	job->user_data = user_data;
+
+	g_hash_table_insert(pending_parse_jobs, source_file, job);
+	g_thread_pool_push(parse_pool, job, NULL);
 }
 
 
@@ -231,8 +579,11 @@ void tm_workspace_remove_source_file(TMSourceFile *source_file)
 	{
 		if (theWorkspace->source_files->pdata[i] == source_file)
 		{
+			cancel_pending_parse(source_file);
 			tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
 			tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+			tm_name_index_remove_tags(name_index, source_file->tags_array);
+			update_typenames(source_file->tags_array, NULL);
 			g_ptr_array_remove_index_fast(theWorkspace->source_files, i);
 			return;
 		}
@@ -249,6 +600,8 @@ static void tm_workspace_update(void)
 {
 	guint i, j;
 	TMSourceFile *source_file;
+	GHashTableIter iter;
+	gpointer value;
 
 #ifdef TM_DEBUG
 	g_message("Recreating workspace tags array");
@@ -281,6 +634,67 @@ static void tm_workspace_update(void)
 
 	g_ptr_array_free(theWorkspace->typename_array, TRUE);
 	theWorkspace->typename_array = tm_tags_extract(theWorkspace->tags_array, TM_GLOBAL_TYPE_MASK);
+
+	tm_name_index_clear(name_index);
+	tm_name_index_add_tags(name_index, theWorkspace->tags_array);
+	tm_name_index_add_tags(name_index, theWorkspace->global_tags);
+
+	/* recount the typenames of the remaining files */
+	g_hash_table_iter_init(&iter, typename_sets);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		free_typename_names(value);
+	for (i = 0; i < theWorkspace->source_files->len; ++i)
+	{
+		source_file = theWorkspace->source_files->pdata[i];
+		update_typenames(NULL, source_file->tags_array);
+	}
+	g_hash_table_iter_init(&iter, typename_sets);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		((TypenameSet *) value)->generation = ++typenames_generation;
+}
+
+
+/* Worker thread of the bulk parse - parses files until none are left and collects
+ * their tags into its own run sorted on workspace_tags_sort_attrs */
+static gpointer bulk_parse_thread(gpointer data)
+{
+	BulkParseWorker *worker = data;
+	BulkParse *bulk = worker->bulk;
+	guint i;
+
+	while ((i = (guint) g_atomic_int_add(&bulk->next_file, 1)) < bulk->source_files->len)
+	{
+		TMSourceFile *source_file = bulk->source_files->pdata[i];
+		guint j;
+
+		tm_source_file_parse(source_file, NULL, 0, NULL, 0, FALSE);
+		tm_tags_sort(source_file->tags_array, file_tags_sort_attrs, FALSE, TRUE);
+		for (j = 0; j < source_file->tags_array->len; j++)
+			g_ptr_array_add(worker->tags_array, source_file->tags_array->pdata[j]);
+
+		g_async_queue_push(bulk->parsed_queue, source_file);
+	}
+	tm_tags_sort(worker->tags_array, workspace_tags_sort_attrs, TRUE, FALSE);
+
+	return NULL;
+}
+
+
+/* Number of threads used to parse n_files files at once */
+static guint get_bulk_parse_thread_count(guint n_files)
+{
+	guint count = 1;
+
+	if (tm_ctags_is_reentrant())
+	{
+#if GLIB_CHECK_VERSION(2, 36, 0)
+		count = g_get_num_processors();
+#else
+		count = MAX_BULK_PARSE_THREADS;
+#endif
+		count = MIN(count, MAX_BULK_PARSE_THREADS);
+	}
+	return MAX(1, MIN(count, n_files));
 }
 
 
@@ -292,19 +706,97 @@ static void tm_workspace_update(void)
 GEANY_API_SYMBOL
 void tm_workspace_add_source_files(GPtrArray *source_files)
 {
+	tm_workspace_add_source_files_full(source_files, NULL, NULL);
+}
+
+
+/** Like tm_workspace_add_source_files() but reports the progress while the files
+ are parsed. The files are parsed by several threads at once; this function
+ returns when all of them are parsed and the workspace tag arrays are updated.
+ @param source_files @elementtype{TMSourceFile} The source files to be added to the workspace.
+ @param callback @nullable Function called in the calling thread each time a file has
+ been parsed, or @c NULL.
+ @param user_data User data passed to @a callback.
+ @since 1.29 (API 229)
+*/
+GEANY_API_SYMBOL
+void tm_workspace_add_source_files_full(GPtrArray *source_files,
+	TMWorkspaceProgressCallback callback, gpointer user_data)
+{
+	BulkParse bulk;
+	BulkParseWorker *workers;
+	GPtrArray **runs;
+	GPtrArray *new_tags;
+	guint n_threads;
 	guint i;
 
 	g_return_if_fail(source_files != NULL);
 
+	if (source_files->len == 0)
+		return;
+
 	for (i = 0; i < source_files->len; i++)
 	{
 		TMSourceFile *source_file = source_files->pdata[i];
-		
+
 		tm_workspace_add_source_file_noupdate(source_file);
-		update_source_file(source_file, NULL, 0, FALSE, FALSE);
+		cancel_pending_parse(source_file);
+		/* the tags are freed by the parse - don't leave them in the workspace */
+		if (source_file->tags_array->len > 0)
+		{
+			tm_tags_remove_file_tags(source_file, theWorkspace->tags_array);
+			tm_tags_remove_file_tags(source_file, theWorkspace->typename_array);
+			tm_name_index_remove_tags(name_index, source_file->tags_array);
+			update_typenames(source_file->tags_array, NULL);
+		}
 	}
-	
-	tm_workspace_update();
+
+	bulk.source_files = source_files;
+	bulk.next_file = 0;
+	bulk.parsed_queue = g_async_queue_new();
+
+	n_threads = get_bulk_parse_thread_count(source_files->len);
+	workers = g_new0(BulkParseWorker, n_threads);
+	for (i = 0; i < n_threads; i++)
+	{
+		workers[i].bulk = &bulk;
+		workers[i].tags_array = g_ptr_array_new();
+		workers[i].thread = g_thread_new("tm-parser", bulk_parse_thread, &workers[i]);
+	}
+
+	for (i = 0; i < source_files->len; i++)
+	{
+		TMSourceFile *source_file = g_async_queue_pop(bulk.parsed_queue);
+
+		if (callback)
+			callback(source_file, i + 1, source_files->len, user_data);
+	}
+
+	/* every thread produced a sorted run - merge them with the current workspace
+	 * tags in a single pass instead of re-sorting everything */
+	runs = g_new(GPtrArray *, n_threads + 1);
+	runs[0] = theWorkspace->tags_array;
+	for (i = 0; i < n_threads; i++)
+	{
+		g_thread_join(workers[i].thread);
+		runs[i + 1] = workers[i].tags_array;
+		tm_name_index_add_tags(name_index, workers[i].tags_array);
+	}
+	new_tags = tm_tags_merge_sorted(runs, n_threads + 1, workspace_tags_sort_attrs);
+
+	for (i = 0; i < n_threads; i++)
+		g_ptr_array_free(workers[i].tags_array, TRUE);
+	g_free(runs);
+	g_free(workers);
+	g_async_queue_unref(bulk.parsed_queue);
+
+	g_ptr_array_free(theWorkspace->tags_array, TRUE);
+	theWorkspace->tags_array = new_tags;
+
+	g_ptr_array_free(theWorkspace->typename_array, TRUE);
+	theWorkspace->typename_array = tm_tags_extract(theWorkspace->tags_array, TM_GLOBAL_TYPE_MASK);
+	for (i = 0; i < source_files->len; i++)
+		update_typenames(NULL, ((TMSourceFile *) source_files->pdata[i])->tags_array);
 }
 
 
@@ -330,6 +822,7 @@ void tm_workspace_remove_source_files(GPtrArray *source_files)
 		{
 			if (theWorkspace->source_files->pdata[j] == source_file)
 			{
+				cancel_pending_parse(source_file);
 				g_ptr_array_remove_index_fast(theWorkspace->source_files, j);
 				break;
 			}
@@ -342,6 +835,8 @@ void tm_workspace_remove_source_files(GPtrArray *source_files)
 
 /* Loads the global tag list from the specified file. The global tag list should
  have been first created using tm_workspace_create_global_tags().
+ Binary tags files are mapped into memory and used as they are because their
+ tags are already sorted; other formats are parsed and sorted.
  @param tags_file The file containing global tags.
  @return TRUE on success, FALSE on failure.
  @see tm_workspace_create_global_tags()
@@ -350,18 +845,30 @@ gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode)
 {
 	GPtrArray *file_tags, *new_tags;
 
-	file_tags = tm_source_file_read_tags_file(tags_file, mode);
+	file_tags = tm_source_file_read_binary_tags_file(tags_file, mode);
 	if (!file_tags)
-		return FALSE;
+	{
+		file_tags = tm_source_file_read_tags_file(tags_file, mode);
+		if (!file_tags)
+			return FALSE;
 
-	tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
+		tm_tags_sort(file_tags, global_tags_sort_attrs, TRUE, TRUE);
+	}
 
-	/* reorder the whole array, because tm_tags_find expects a sorted array */
-	new_tags = tm_tags_merge(theWorkspace->global_tags, 
-		file_tags, global_tags_sort_attrs, TRUE);
+	/* the merge drops duplicates - index the tags which are kept */
+	tm_name_index_remove_tags(name_index, theWorkspace->global_tags);
+	if (theWorkspace->global_tags->len == 0)
+		new_tags = file_tags;
+	else
+	{
+		/* reorder the whole array, because tm_tags_find expects a sorted array */
+		new_tags = tm_tags_merge(theWorkspace->global_tags,
+			file_tags, global_tags_sort_attrs, TRUE);
+		g_ptr_array_free(file_tags, TRUE);
+	}
 	g_ptr_array_free(theWorkspace->global_tags, TRUE);
-	g_ptr_array_free(file_tags, TRUE);
 	theWorkspace->global_tags = new_tags;
+	tm_name_index_add_tags(name_index, new_tags);
 
 	g_ptr_array_free(theWorkspace->global_typename_array, TRUE);
 	theWorkspace->global_typename_array = tm_tags_extract(new_tags, TM_GLOBAL_TYPE_MASK);
@@ -599,10 +1106,12 @@ static gchar *pre_process_file(const gchar *cmd, const gchar *inf)
  are allowed.
  @param tags_file The file where the tags will be stored.
  @param lang The language to use for the tags file.
+ @param binary Whether to write the binary format which is loaded without parsing
+ instead of the text format.
  @return TRUE on success, FALSE on failure.
 */
 gboolean tm_workspace_create_global_tags(const char *pre_process, const char **includes,
-	int includes_count, const char *tags_file, TMParserType lang)
+	int includes_count, const char *tags_file, TMParserType lang, gboolean binary)
 {
 	gboolean ret = FALSE;
 	TMSourceFile *source_file;
@@ -644,7 +1153,7 @@ gboolean tm_workspace_create_global_tags(const char *pre_process, const char **i
 	source_file = tm_source_file_new(temp_file, tm_source_file_get_lang_name(lang));
 	if (!source_file)
 		goto cleanup;
-	update_source_file(source_file, NULL, 0, FALSE, FALSE);
+	update_source_file(source_file, NULL, 0, NULL, 0, FALSE, FALSE);
 	if (source_file->tags_array->len == 0)
 	{
 		tm_source_file_free(source_file);
@@ -652,7 +1161,10 @@ gboolean tm_workspace_create_global_tags(const char *pre_process, const char **i
 	}
 
 	tm_tags_sort(source_file->tags_array, global_tags_sort_attrs, TRUE, FALSE);
-	ret = tm_source_file_write_tags_file(tags_file, source_file->tags_array);
+	if (binary)
+		ret = tm_source_file_write_binary_tags_file(tags_file, source_file->tags_array);
+	else
+		ret = tm_source_file_write_tags_file(tags_file, source_file->tags_array);
 	tm_source_file_free(source_file);
 
 cleanup:
@@ -709,32 +1221,6 @@ GPtrArray *tm_workspace_find(const char *name, const char *scope, TMTagType type
 }
 
 
-static void fill_find_tags_array_prefix(GPtrArray *dst, const GPtrArray *src,
-	const char *name, TMParserType lang, guint max_num)
-{
-	TMTag **tag, *last = NULL;
-	guint i, count, num;
-
-	if (!src || !dst || !name || !*name)
-		return;
-
-	num = 0;
-	tag = tm_tags_find(src, name, TRUE, &count);
-	for (i = 0; i < count && num < max_num; ++i)
-	{
-		if (tm_tag_langs_compatible(lang, (*tag)->lang) &&
-			!tm_tag_is_anon(*tag) &&
-			(!last || g_strcmp0(last->name, (*tag)->name) != 0))
-		{
-			g_ptr_array_add(dst, *tag);
-			last = *tag;
-			num++;
-		}
-		tag++;
-	}
-}
-
-
 /* Returns tags with the specified prefix sorted by name. If there are several
  tags with the same name, only one of them appears in the resulting array.
  @param prefix The prefix of the tag to find.
@@ -745,17 +1231,34 @@ static void fill_find_tags_array_prefix(GPtrArray *dst, const GPtrArray *src,
 */
 GPtrArray *tm_workspace_find_prefix(const char *prefix, TMParserType lang, guint max_num)
 {
-	TMTagAttrType attrs[] = { tm_tag_attr_name_t, 0 };
 	GPtrArray *tags = g_ptr_array_new();
 
-	fill_find_tags_array_prefix(tags, theWorkspace->tags_array, prefix, lang, max_num);
-	fill_find_tags_array_prefix(tags, theWorkspace->global_tags, prefix, lang, max_num);
+	tm_name_index_find_prefix(name_index, tags, prefix, lang, max_num);
+	return tags;
+}
 
-	tm_tags_sort(tags, attrs, TRUE, FALSE);
-	if (tags->len > max_num)
-		tags->len = max_num;
 
-	return tags;
+/* Returns a number which changes whenever a typename of lang (or a compatible
+ language) is added to or removed from typename_array. Use it to find out whether
+ the keywords built from typename_array need to be updated after a reparse.
+ @param lang The language of the typenames.
+ @return The generation of the typenames, 0 if there never were any.
+*/
+guint tm_workspace_get_typenames_generation(TMParserType lang)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	guint generation = 0;
+
+	g_hash_table_iter_init(&iter, typename_sets);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		TypenameSet *set = value;
+
+		if (tm_tag_langs_compatible(lang, GPOINTER_TO_INT(key)))
+			generation = MAX(generation, set->generation);
+	}
+	return generation;
 }
 
 
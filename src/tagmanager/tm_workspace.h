@@ -34,12 +34,24 @@ typedef struct TMWorkspace
 } TMWorkspace;
 
 
+/** Callback reporting the progress of tm_workspace_add_source_files_full().
+ * @param source_file The source file which has just been parsed.
+ * @param parsed The number of files parsed so far.
+ * @param total The number of files to parse.
+ * @param user_data User data passed to tm_workspace_add_source_files_full(). */
+typedef void (*TMWorkspaceProgressCallback) (TMSourceFile *source_file, guint parsed,
+	guint total, gpointer user_data);
+
+
 void tm_workspace_add_source_file(TMSourceFile *source_file);
 
 void tm_workspace_remove_source_file(TMSourceFile *source_file);
 
 void tm_workspace_add_source_files(GPtrArray *source_files);
 
+void tm_workspace_add_source_files_full(GPtrArray *source_files,
+	TMWorkspaceProgressCallback callback, gpointer user_data);
+
 void tm_workspace_remove_source_files(GPtrArray *source_files);
 
 
@@ -50,13 +62,15 @@ const TMWorkspace *tm_get_workspace(void);
 gboolean tm_workspace_load_global_tags(const char *tags_file, TMParserType mode);
 
 gboolean tm_workspace_create_global_tags(const char *pre_process, const char **includes,
-	int includes_count, const char *tags_file, TMParserType lang);
+	int includes_count, const char *tags_file, TMParserType lang, gboolean binary);
 
 GPtrArray *tm_workspace_find(const char *name, const char *scope, TMTagType type,
 	TMTagAttrType *attrs, TMParserType lang);
 
 GPtrArray *tm_workspace_find_prefix(const char *prefix, TMParserType lang, guint max_num);
 
+guint tm_workspace_get_typenames_generation(TMParserType lang);
+
 GPtrArray *tm_workspace_find_scope_members (TMSourceFile *source_file, const char *name,
 	gboolean function, gboolean member, const gchar *current_scope, gboolean search_namespace);
 
@@ -64,7 +78,15 @@ GPtrArray *tm_workspace_find_scope_members (TMSourceFile *source_file, const cha
 void tm_workspace_add_source_file_noupdate(TMSourceFile *source_file);
 
 void tm_workspace_update_source_file_buffer(TMSourceFile *source_file, guchar* text_buf,
-	gsize buf_size);
+	gsize buf_size, guchar *text_buf2, gsize buf2_size);
+
+/* Called in the main thread when the tags of source_file have been replaced by the
+ * result of a background parse */
+typedef void (*TMWorkspaceUpdateCallback) (TMSourceFile *source_file, gpointer user_data);
+
+void tm_workspace_update_source_file_buffer_async(TMSourceFile *source_file, guchar* text_buf,
+	gsize buf_size, guchar *text_buf2, gsize buf2_size,
+	TMWorkspaceUpdateCallback callback, gpointer user_data);
 
 void tm_workspace_free(void);
 
@@ -2309,6 +2309,8 @@ void ui_init_prefs(void)
 		"show_symbol_list_expanders", TRUE);
 	stash_group_add_boolean(group, &interface_prefs.compiler_tab_autoscroll,
 		"compiler_tab_autoscroll", TRUE);
+	stash_group_add_integer(group, &ui_prefs.compiler_tab_max_lines,
+		"compiler_tab_max_lines", 0);
 	stash_group_add_boolean(group, &ui_prefs.allow_always_save,
 		"allow_always_save", FALSE);
 	stash_group_add_string(group, &ui_prefs.statusbar_template,
@@ -166,6 +166,7 @@ typedef struct UIPrefs
 	gboolean	allow_always_save; /* if set, files can always be saved, even if unchanged */
 	gchar		*statusbar_template;
 	gboolean	new_document_after_close;
+	gint		compiler_tab_max_lines;	/* 0 for no limit */
 
 	/* Menu-item related data */
 	GQueue		*recent_queue;